@@ -0,0 +1,259 @@
+/**
+ * Hotel Management System
+ * audit.c - Night audit implementation
+ *
+ * This file implements the night audit. A single pass over the
+ * reservation table posts room nights for checked-in stays and marks
+ * no-shows; invoices are found through the reservation index and the
+ * nights already charged through the billing item index, so the run is
+ * linear in the number of reservations. All changes are made inside one
+ * write-ahead log transaction and reach the data files at the next
+ * checkpoint, so a run commits with a single log sync.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audit.h"
+#include "billing.h"
+#include "reservation.h"
+#include "room.h"
+#include "availability.h"
+#include "occupancy.h"
+#include "fileio.h"
+#include "table.h"
+#include "wal.h"
+#include "lock.h"
+#include "ui.h"
+
+/* Create the audit file if needed and load it */
+int initializeAuditData(void) {
+    if (!fileExists(AUDITS_FILE)) {
+        FILE *fp = fopen(AUDITS_FILE, "wb");
+        if (!fp) {
+            printf("\nError: Could not create audits file.\n");
+            return 0;
+        }
+        fclose(fp);
+    }
+    return loadTable(TABLE_AUDITS);
+}
+
+/* Get the business date the next night audit will close */
+Date getBusinessDate(void) {
+    Table *audits = getTable(TABLE_AUDITS);
+    AuditRun *runs = TABLE_RECORDS(audits, AuditRun);
+
+    // Runs are appended in business date order
+    for (int i = audits->count - 1; i >= 0; i--) {
+        if (runs[i].isActive) {
+            return runs[i].businessDate + 1;
+        }
+    }
+    return getCurrentDay();
+}
+
+/* Find the slot of a reservation's open invoice, opening one if it has none;
+   -2 if its billing was cancelled */
+static int findOrOpenInvoice(User *currentUser, const Reservation *res) {
+    Table *invoices = getTable(TABLE_INVOICES);
+    int cancelled = 0;
+
+    for (int i = indexFirst(INDEX_INVOICE_RESERVATION, res->id); i >= 0;
+         i = indexNext(INDEX_INVOICE_RESERVATION, i)) {
+        Invoice *inv = tableRecord(invoices, i);
+        if (!inv->isActive || inv->status == INVOICE_STATUS_PAID) {
+            continue;
+        }
+        if (inv->status == INVOICE_STATUS_CANCELLED) {
+            cancelled = 1;
+        } else {
+            return i;
+        }
+    }
+    if (cancelled) {
+        return -2;
+    }
+
+    // A stay settled before check-out bills its later nights on a new invoice
+    int invoiceId = openInvoice(currentUser, res);
+    return invoiceId > 0 ? tableLookup(invoices, invoiceId) : -1;
+}
+
+/* Count the room nights already charged to a reservation's invoices */
+static int postedRoomNights(int reservationId) {
+    Table *invoices = getTable(TABLE_INVOICES);
+    Table *items = getTable(TABLE_BILLING_ITEMS);
+    int nights = 0;
+
+    for (int i = indexFirst(INDEX_INVOICE_RESERVATION, reservationId); i >= 0;
+         i = indexNext(INDEX_INVOICE_RESERVATION, i)) {
+        Invoice *inv = tableRecord(invoices, i);
+        if (!inv->isActive) {
+            continue;
+        }
+        for (int j = indexFirst(INDEX_ITEM_INVOICE, inv->id); j >= 0;
+             j = indexNext(INDEX_ITEM_INVOICE, j)) {
+            BillingItem *item = tableRecord(items, j);
+            if (item->isActive && item->type == BILLING_ITEM_ROOM_CHARGE) {
+                nights += item->quantity;
+            }
+        }
+    }
+    return nights;
+}
+
+/* Post one night's room charge and tax for an in-house reservation */
+static int postRoomNight(User *currentUser, const Reservation *res, Date night, AuditRun *run) {
+    char description[MAX_BILLING_DESCRIPTION_LEN];
+    char dateStr[11];
+    Room room;
+    int slot;
+
+    if (!getRoomById(res->roomId, &room)) {
+        return 1;
+    }
+
+    // Nights up to and including this one may already be charged
+    if (postedRoomNights(res->id) >= night - res->checkInDate + 1) {
+        return 1;
+    }
+
+    slot = findOrOpenInvoice(currentUser, res);
+    if (slot == -2) {
+        run->skipped++;
+        return 1;
+    }
+    if (slot < 0) {
+        return 0;
+    }
+
+    dateToString(night, dateStr);
+    sprintf(description, "Room %d night of %s", room.id, dateStr);
+    if (!postBillingItem(slot, BILLING_ITEM_ROOM_CHARGE, description, room.rate, 1, night)) {
+        return 0;
+    }
+    sprintf(description, "Room tax %.0f%% (%s)", ROOM_TAX_RATE * 100, dateStr);
+    if (!postBillingItem(slot, BILLING_ITEM_TAX, description, room.rate * ROOM_TAX_RATE, 1, night)) {
+        return 0;
+    }
+
+    run->roomNights++;
+    run->roomRevenue += room.rate;
+    run->taxAmount += room.rate * ROOM_TAX_RATE;
+    return 1;
+}
+
+/* Close the current business date */
+int runNightAudit(User *currentUser, AuditRun *run) {
+    Table *reservations = getTable(TABLE_RESERVATIONS);
+    Table *audits = getTable(TABLE_AUDITS);
+    AuditRun result;
+    Date businessDate;
+    char dateStr[11];
+    int success = 1;
+
+    if (currentUser->role != ROLE_ADMIN) {
+        printf("\nAccess denied. Admin privileges required.\n");
+        return 0;
+    }
+
+    // Other terminals wait for the whole run; the business date is read under the lock
+    walBegin();
+    if (!lockTable(TABLE_RESERVATIONS) || !lockTable(TABLE_INVOICES) ||
+        !lockAppend(TABLE_BILLING_ITEMS) || !lockAppend(TABLE_AUDITS)) {
+        walAbort();
+        return 0;
+    }
+
+    businessDate = getBusinessDate();
+    if (businessDate > getCurrentDay()) {
+        dateToString(businessDate - 1, dateStr);
+        printf("\nError: Business date %s has already been closed.\n", dateStr);
+        walAbort();
+        return 0;
+    }
+
+    memset(&result, 0, sizeof(result));
+    result.id = tableNextId(audits);
+    result.businessDate = businessDate;
+    result.runBy = currentUser->id;
+    result.isActive = 1;
+    getCurrentDateTime(result.runAt);
+
+    for (int slot = 0; slot < reservations->count && success; slot++) {
+        Reservation *res = tableRecord(reservations, slot);
+        if (!res->isActive) {
+            continue;
+        }
+
+        if (res->status == RESERVATION_STATUS_CHECKED_IN &&
+            res->checkInDate <= businessDate && businessDate < res->checkOutDate) {
+            success = postRoomNight(currentUser, res, businessDate, &result);
+        } else if (res->status == RESERVATION_STATUS_CONFIRMED && res->checkInDate <= businessDate) {
+            // The guest was due by the business date and never arrived
+            Reservation before = *res;
+            res->status = RESERVATION_STATUS_NO_SHOW;
+            success = tableWriteRecord(reservations, slot);
+            if (success) {
+                availabilityUpdate(&before, res);
+                occupancyUpdate(&before, res);
+                result.noShows++;
+            }
+        }
+    }
+
+    if (success) {
+        // Invoices fall overdue as of the day being closed, not today
+        result.overdueInvoices = checkOverdueInvoices(businessDate);
+        success = result.overdueInvoices >= 0 && tableAppend(audits, &result) >= 0;
+    }
+
+    // Postings and no-shows commit only together with their audit run
+    if (!success) {
+        walAbort();
+    } else {
+        success = walCommit();
+    }
+    if (!success) {
+        printf("\nError: Night audit failed.\n");
+        return 0;
+    }
+
+    if (run != NULL) {
+        *run = result;
+    }
+    return 1;
+}
+
+/* Run the night audit from the menu and print its results */
+void nightAuditMenu(User *currentUser) {
+    AuditRun run;
+    char dateStr[11];
+    char confirm;
+
+    clearScreen();
+    displayHeader("Night Audit");
+
+    dateToString(getBusinessDate(), dateStr);
+    printf("Business date: %s\n", dateStr);
+    printf("Post room charges and close this date? (y/n): ");
+    scanf(" %c", &confirm);
+    if (confirm != 'y' && confirm != 'Y') {
+        printf("\nNight audit cancelled.\n");
+        return;
+    }
+
+    if (!runNightAudit(currentUser, &run)) {
+        return;
+    }
+
+    printf("\n%-28s %d\n", "Room nights posted:", run.roomNights);
+    printf("%-28s $%.2f\n", "Room revenue:", run.roomRevenue);
+    printf("%-28s $%.2f\n", "Room tax:", run.taxAmount);
+    printf("%-28s %d\n", "No-shows:", run.noShows);
+    printf("%-28s %d\n", "Skipped (billing cancelled):", run.skipped);
+    printf("%-28s %d\n", "Invoices now overdue:", run.overdueInvoices);
+    dateToString(run.businessDate + 1, dateStr);
+    printf("\nBusiness date rolled to %s.\n", dateStr);
+}
@@ -0,0 +1,76 @@
+/**
+ * Hotel Management System
+ * audit.h - Night audit header
+ *
+ * This file contains declarations for the night audit, which closes
+ * one business day: it posts that night's room charge and room tax to
+ * the invoice of every in-house reservation, marks confirmed
+ * reservations that never arrived as no-shows, runs the overdue
+ * invoice check and rolls the business date forward. The whole run is
+ * one write-ahead log transaction.
+ *
+ * Each run is recorded in AUDITS_FILE; the business date is the day
+ * after the last audited one, or today if no audit has run yet.
+ */
+
+#ifndef AUDIT_H
+#define AUDIT_H
+
+#include "auth.h"
+#include "utils.h"
+
+/* File path */
+#define AUDITS_FILE "data/audits.dat"
+
+/* Night audit run structure */
+typedef struct {
+    int id;
+    Date businessDate;      /* Day closed by this run (days since 1970-01-01) */
+    int roomNights;         /* Room nights posted */
+    double roomRevenue;     /* Room charges posted */
+    double taxAmount;       /* Room tax posted */
+    int noShows;            /* Reservations marked as no-shows */
+    int skipped;            /* In-house stays whose invoice was cancelled */
+    int overdueInvoices;    /* Invoices marked as overdue */
+    char runAt[20];         /* Date and time the audit ran */
+    int runBy;              /* ID of the user who ran the audit */
+    int isActive;
+} AuditRun;
+
+/**
+ * Create the audit file if needed and load it
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int initializeAuditData(void);
+
+/**
+ * Get the business date the next night audit will close
+ *
+ * @return Business date (days since 1970-01-01)
+ */
+Date getBusinessDate(void);
+
+/**
+ * Close the current business date
+ *
+ * Nights already covered by a room charge on the reservation's
+ * invoices (for example a whole-stay charge from createInvoice, or an
+ * earlier run) are not posted again. Once an invoice is paid, later
+ * nights go on a new one. Invoices fall overdue as of the business
+ * date. A business date after today cannot be closed.
+ *
+ * @param currentUser User running the audit (admin only)
+ * @param run Filled in with the results of the run; may be NULL
+ * @return 1 if successful, 0 otherwise
+ */
+int runNightAudit(User *currentUser, AuditRun *run);
+
+/**
+ * Run the night audit from the menu and print its results
+ *
+ * @param currentUser User running the audit
+ */
+void nightAuditMenu(User *currentUser);
+
+#endif /* AUDIT_H */
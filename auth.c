@@ -14,12 +14,14 @@
  #include "fileio.h"
  #include "utils.h"
  #include "ui.h"
+ #include "table.h"
+ #include "wal.h"
+ #include "lock.h"
  
  /* Forward declarations for static functions */
  static void updateUserLastLogin(User *user);
  static int isUsernameExists(const char *username);
- 
- #define TEMP_FILE "data/temp_users.dat"
+ static int findUserSlot(int userId);
  
  /* Simple password hashing function for academic purposes*/
  void hashPassword(const char *password, char *hashedPassword) {
@@ -46,24 +48,23 @@
      User defaultAdmin;
      char hashedPassword[MAX_PASSWORD_LEN];
  
-     fp = fopen(USERS_FILE, "rb");
-     if (fp != NULL) {
-         fseek(fp, 0, SEEK_END);
-         if (ftell(fp) > 0) {
-             fclose(fp);
-             return 1; // File exists and is not empty
+     /* Create users file if it doesn't exist */
+     if (!fileExists(USERS_FILE)) {
+         fp = fopen(USERS_FILE, "wb");
+         if (!fp) {
+             printf("\nError: Could not create user file.\n");
+             return 0;
          }
          fclose(fp);
      }
-     
-     printf("\nNo users found. Creating default admin account...");
- 
-     /* Create users file */
-     fp = fopen(USERS_FILE, "wb");
-     if (!fp) {
-         printf("\nError: Could not create user file.\n");
+     if (!loadTable(TABLE_USERS)) {
          return 0;
      }
+     if (getTable(TABLE_USERS)->count > 0) {
+         return 1; // Users already exist
+     }
+     
+     printf("\nNo users found. Creating default admin account...");
  
      /* Initialize default admin account */
      defaultAdmin.id = 1;
@@ -76,28 +77,22 @@
      defaultAdmin.active = 1;
  
      /* Write default admin to file */
-     if (fwrite(&defaultAdmin, sizeof(User), 1, fp) != 1) {
+     if (tableAppend(getTable(TABLE_USERS), &defaultAdmin) < 0) {
          printf("\nError: Could not write default admin account.\n");
-         fclose(fp);
          return 0;
      }
  
-     fclose(fp);
      printf("\nDefault admin account created. User: admin, Pass: admin123\n");
      return 1;
  }
  
  /* Login user function */
  int loginUser(User *user) {
-     FILE *fp;
-     User tempUser;
+     Table *users = getTable(TABLE_USERS);
      char username[MAX_USERNAME_LEN];
      char password[MAX_PASSWORD_LEN];
-     int found = 0;
      
-     /* Open users file */
-     fp = fopen(USERS_FILE, "rb");
-     if (fp == NULL) {
+     if (users->count == 0) {
          printf("\nError: Could not open user file. Please ensure the system is initialized.\n");
          return 0;
      }
@@ -110,87 +105,67 @@
      printf("Password: ");
      getPassword(password, MAX_PASSWORD_LEN);
      
+     return authenticateUser(username, password, user);
+ }
+ 
+ /* Check a username and password and record the login */
+ int authenticateUser(const char *username, const char *password, User *user) {
+     Table *users = getTable(TABLE_USERS);
+     int found = 0;
+     
      /* Search for user */
-     while (fread(&tempUser, sizeof(User), 1, fp) == 1) {
-         if (strcmp(tempUser.username, username) == 0 && tempUser.active) {
-             if (verifyPassword(password, tempUser.password)) {
+     for (int i = 0; i < users->count; i++) {
+         User *tempUser = tableRecord(users, i);
+         if (strcmp(tempUser->username, username) == 0 && tempUser->active) {
+             if (verifyPassword(password, tempUser->password)) {
                  found = 1;
-                 *user = tempUser;
+                 *user = *tempUser;
                  updateUserLastLogin(user);
                  break;
              }
          }
      }
      
-     fclose(fp);
-     
      return found;
  }
  
  /* Update user's last login time in memory and file */
  static void updateUserLastLogin(User *user) {
-     FILE *fp, *tempFp;
-     User tempUser;
+     Table *users = getTable(TABLE_USERS);
+     int slot;
      
      // Update the lastLogin field in the user struct passed to the function
      getCurrentDateTime(user->lastLogin);
  
-     fp = fopen(USERS_FILE, "rb");
-     if (fp == NULL) {
-         printf("Error: Cannot open users file to update login time.\n");
+     // The write commits on its own and releases the lock
+     if (!lockRecord(TABLE_USERS, user->id)) {
          return;
      }
-     
-     tempFp = fopen(TEMP_FILE, "wb");
-     if (tempFp == NULL) {
-         printf("Error: Cannot create temp file to update login time.\n");
-         fclose(fp);
+     slot = tableLookup(users, user->id);
+     if (slot < 0) {
+         printf("Error: Cannot find user record to update login time.\n");
          return;
      }
      
-     /* Copy all users to temp file, updating the matching one */
-     while (fread(&tempUser, sizeof(User), 1, fp) == 1) {
-         if (tempUser.id == user->id) {
-             strcpy(tempUser.lastLogin, user->lastLogin);
-         }
-         fwrite(&tempUser, sizeof(User), 1, tempFp);
-     }
-     
-     fclose(fp);
-     fclose(tempFp);
-     
-     remove(USERS_FILE);
-     rename(TEMP_FILE, USERS_FILE);
+     strcpy(((User *)tableRecord(users, slot))->lastLogin, user->lastLogin);
+     tableWriteRecord(users, slot);
  }
  
  /* Add a new user */
  int addUser(User *currentUser) {
-     FILE *fp;
-     User newUser, tempUser;
+     Table *users = getTable(TABLE_USERS);
+     User newUser;
      char password[MAX_PASSWORD_LEN];
      char confirmPassword[MAX_PASSWORD_LEN];
-     int nextId = 1;
      
      if (currentUser->role != ROLE_ADMIN) {
          printf("\nAccess denied. Admin privileges required.\n");
          return 0;
      }
      
-     fp = fopen(USERS_FILE, "rb");
-     if (fp != NULL) {
-         while (fread(&tempUser, sizeof(User), 1, fp) == 1) {
-             if (tempUser.id >= nextId) {
-                 nextId = tempUser.id + 1;
-             }
-         }
-         fclose(fp);
-     }
-     
      clearScreen();
      printf("===== ADD NEW USER =====\n");
      
-     newUser.id = nextId;
-     
      printf("Username: ");
      getStringInput(NULL, newUser.username, MAX_USERNAME_LEN);
      
@@ -222,14 +197,26 @@
      strcpy(newUser.lastLogin, "Never");
      newUser.active = 1;
      
-     fp = fopen(USERS_FILE, "ab");
-     if (fp == NULL) {
+     // Another terminal may have added the same username during the prompts
+     walBegin();
+     if (!lockAppend(TABLE_USERS)) {
+         walAbort();
+         return 0;
+     }
+     if (isUsernameExists(newUser.username)) {
+         printf("\nUsername already exists. Please choose another.\n");
+         walAbort();
+         return 0;
+     }
+     newUser.id = tableNextId(users);
+     if (tableInsert(users, &newUser) < 0) {
          printf("\nError: Could not open users file.\n");
+         walAbort();
+         return 0;
+     }
+     if (!walCommit()) {
          return 0;
      }
-     
-     fwrite(&newUser, sizeof(User), 1, fp);
-     fclose(fp);
      
      printf("\nUser added successfully.\n");
      return 1;
@@ -237,30 +224,22 @@
  
  /* Check if username already exists */
  static int isUsernameExists(const char *username) {
-     FILE *fp;
-     User tempUser;
-     
-     fp = fopen(USERS_FILE, "rb");
-     if (fp == NULL) {
-         return 0; 
-     }
+     Table *users = getTable(TABLE_USERS);
      
-     while (fread(&tempUser, sizeof(User), 1, fp) == 1) {
-         if (strcmp(tempUser.username, username) == 0) {
-             fclose(fp);
+     for (int i = 0; i < users->count; i++) {
+         User *tempUser = tableRecord(users, i);
+         if (strcmp(tempUser->username, username) == 0 && tempUser->role != 0) {
              return 1;
          }
      }
-     
-     fclose(fp);
      return 0;
  }
  
  /* Modify an existing user */
  int modifyUser(User *currentUser, int userId) {
-     FILE *fp, *tempFp;
-     User tempUser;
-     int found = 0;
+     Table *users;
+     User *tempUser;
+     int slot;
      
      if (currentUser->role != ROLE_ADMIN) {
          printf("\nAccess denied. Admin privileges required.\n");
@@ -273,75 +252,69 @@
          return 0;
      }
      
-     fp = fopen(USERS_FILE, "rb");
-     if (fp == NULL) {
-         printf("\nError: Could not open users file.\n");
+     walBegin();
+     if (!lockRecord(TABLE_USERS, userId)) {
+         walAbort();
          return 0;
      }
      
-     tempFp = fopen(TEMP_FILE, "wb");
-     if (tempFp == NULL) {
-         fclose(fp);
-         printf("\nError: Could not create temporary file.\n");
+     users = getTable(TABLE_USERS);
+     slot = findUserSlot(userId);
+     if (slot < 0) {
+         printf("\nUser with ID %d not found.\n", userId);
+         walAbort();
          return 0;
      }
      
-     while (fread(&tempUser, sizeof(User), 1, fp) == 1) {
-         if (tempUser.id == userId) {
-             found = 1;
-             clearScreen();
-             printf("===== MODIFY USER: %s =====\n", tempUser.username);
-             printf("1. Change Name (Current: %s)\n", tempUser.name);
-             printf("2. Change Role (Current: %s)\n", tempUser.role == ROLE_ADMIN ? "Admin" : "Staff");
-             printf("3. Reset Password\n");
-             printf("4. Toggle Active Status (Current: %s)\n", tempUser.active ? "Active" : "Inactive");
-             printf("0. Cancel\n");
-             
-             int choice = getIntInput("Enter your choice: ", 0, 4);
+     tempUser = tableRecord(users, slot);
+     clearScreen();
+     printf("===== MODIFY USER: %s =====\n", tempUser->username);
+     printf("1. Change Name (Current: %s)\n", tempUser->name);
+     printf("2. Change Role (Current: %s)\n", tempUser->role == ROLE_ADMIN ? "Admin" : "Staff");
+     printf("3. Reset Password\n");
+     printf("4. Toggle Active Status (Current: %s)\n", tempUser->active ? "Active" : "Inactive");
+     printf("0. Cancel\n");
+     
+     int choice = getIntInput("Enter your choice: ", 0, 4);
  
-             switch (choice) {
-                 case 1:
-                     printf("Enter new name: ");
-                     getStringInput(NULL, tempUser.name, MAX_NAME_LEN);
-                     break;
-                 case 2:
-                     printf("Enter new role (1=Admin, 2=Staff): ");
-                     tempUser.role = getIntInput("", 1, 2);
-                     break;
-                 case 3:
-                     hashPassword("password123", tempUser.password);
-                     printf("\nPassword has been reset to: password123\n");
-                     break;
-                 case 4:
-                     tempUser.active = !tempUser.active;
-                     printf("\nUser status is now: %s\n", tempUser.active ? "Active" : "Inactive");
-                     break;
-                 case 0:
-                     break; // No changes
-             }
-         }
-         fwrite(&tempUser, sizeof(User), 1, tempFp);
+     switch (choice) {
+         case 1:
+             printf("Enter new name: ");
+             getStringInput(NULL, tempUser->name, MAX_NAME_LEN);
+             break;
+         case 2:
+             printf("Enter new role (1=Admin, 2=Staff): ");
+             tempUser->role = getIntInput("", 1, 2);
+             break;
+         case 3:
+             hashPassword("password123", tempUser->password);
+             printf("\nPassword has been reset to: password123\n");
+             break;
+         case 4:
+             tempUser->active = !tempUser->active;
+             printf("\nUser status is now: %s\n", tempUser->active ? "Active" : "Inactive");
+             break;
+         case 0:
+             break; // No changes
+     }
+     
+     if (!tableWriteRecord(users, slot)) {
+         walAbort();
+         return 0;
      }
-     
-     fclose(fp);
-     fclose(tempFp);
-     
-     if (found) {
-         remove(USERS_FILE);
-         rename(TEMP_FILE, USERS_FILE);
-         printf("\nUser modified successfully.\n");
-     } else {
-         remove(TEMP_FILE);
-         printf("\nUser with ID %d not found.\n", userId);
+     if (!walCommit()) {
+         return 0;
      }
-     return found;
+     
+     printf("\nUser modified successfully.\n");
+     return 1;
  }
  
  /* Delete a user */
  int deleteUser(User *currentUser, int userId) {
-     FILE *fp, *tempFp;
-     User tempUser;
-     int found = 0;
+     Table *users;
+     User *tempUser;
+     int slot;
      char confirm;
      
      if (currentUser->role != ROLE_ADMIN) {
@@ -354,53 +327,52 @@
          return 0;
      }
      
-     fp = fopen(USERS_FILE, "rb");
-     if (fp == NULL) {
-         printf("\nError: Could not open users file.\n");
+     walBegin();
+     if (!lockRecord(TABLE_USERS, userId)) {
+         walAbort();
          return 0;
      }
      
-     tempFp = fopen(TEMP_FILE, "wb");
-     if (tempFp == NULL) {
-         fclose(fp);
-         printf("\nError: Could not create temporary file.\n");
+     users = getTable(TABLE_USERS);
+     slot = findUserSlot(userId);
+     if (slot < 0) {
+         printf("\nUser with ID %d not found.\n", userId);
+         walAbort();
          return 0;
      }
      
-     while (fread(&tempUser, sizeof(User), 1, fp) == 1) {
-         if (tempUser.id == userId) {
-             found = 1;
-             printf("\nAre you sure you want to delete user '%s' (ID: %d)? (y/n): ", tempUser.username, tempUser.id);
-             scanf(" %c", &confirm);
-             if (confirm == 'y' || confirm == 'Y') {
-                 // Do not write this user to the temp file, effectively deleting them
-                 printf("User deleted.\n");
-             } else {
-                 fwrite(&tempUser, sizeof(User), 1, tempFp); // Keep the user
-                 printf("Deletion cancelled.\n");
-             }
-         } else {
-             fwrite(&tempUser, sizeof(User), 1, tempFp);
+     tempUser = tableRecord(users, slot);
+     printf("\nAre you sure you want to delete user '%s' (ID: %d)? (y/n): ", tempUser->username, tempUser->id);
+     scanf(" %c", &confirm);
+     if (confirm == 'y' || confirm == 'Y') {
+         // The record stays behind without a role until its slot is reused or compacted away
+         tempUser->role = 0;
+         tempUser->active = 0;
+         if (!tableWriteRecord(users, slot)) {
+             walAbort();
+             return 0;
          }
+         printf("User deleted.\n");
+     } else {
+         printf("Deletion cancelled.\n");
      }
+     return walCommit();
+ }
+ 
+ /* Find the table slot of a user that has not been deleted, or -1 if there is none */
+ static int findUserSlot(int userId) {
+     Table *users = getTable(TABLE_USERS);
+     int slot = tableLookup(users, userId);
      
-     fclose(fp);
-     fclose(tempFp);
-     
-     if (found) {
-         remove(USERS_FILE);
-         rename(TEMP_FILE, USERS_FILE);
-     } else {
-         remove(TEMP_FILE);
-         printf("\nUser with ID %d not found.\n", userId);
+     if (slot < 0 || ((User *)tableRecord(users, slot))->role == 0) {
+         return -1;
      }
-     return found;
+     return slot;
  }
  
  /* List all users */
  void listUsers(User *currentUser) {
-     FILE *fp;
-     User tempUser;
+     Table *users;
      int count = 0;
      
      if (currentUser->role != ROLE_ADMIN) {
@@ -408,11 +380,7 @@
          return;
      }
      
-     fp = fopen(USERS_FILE, "rb");
-     if (fp == NULL) {
-         printf("\nError: Could not open users file.\n");
-         return;
-     }
+     users = getTable(TABLE_USERS);
      
      clearScreen();
      printf("===== USER LIST =====\n");
@@ -420,27 +388,29 @@
             "ID", "Username", "Name", "Role", "Last Login", "Status");
      printf("--------------------------------------------------------------------------------------------------------\n");
      
-     while (fread(&tempUser, sizeof(User), 1, fp) == 1) {
+     for (int i = 0; i < users->count; i++) {
+         User *tempUser = tableRecord(users, i);
+         if (tempUser->role == 0) {
+             continue; /* Deleted */
+         }
          printf("%-5d %-20s %-30s %-15s %-20s %-10s\n", 
-                tempUser.id, 
-                tempUser.username, 
-                tempUser.name, 
-                tempUser.role == ROLE_ADMIN ? "Administrator" : "Staff", 
-                tempUser.lastLogin, 
-                tempUser.active ? "Active" : "Inactive");
+                tempUser->id, 
+                tempUser->username, 
+                tempUser->name, 
+                tempUser->role == ROLE_ADMIN ? "Administrator" : "Staff", 
+                tempUser->lastLogin, 
+                tempUser->active ? "Active" : "Inactive");
          count++;
      }
      
-     fclose(fp);
-     
      printf("--------------------------------------------------------------------------------------------------------\n");
      printf("Total users: %d\n", count);
  }
  
  /* Change password for current user */
  int changePassword(User *currentUser) {
-     FILE *fp, *tempFp;
-     User tempUser;
+     Table *users;
+     int slot;
      char currentPassword[MAX_PASSWORD_LEN];
      char newPassword[MAX_PASSWORD_LEN];
      char confirmPassword[MAX_PASSWORD_LEN];
@@ -468,32 +438,22 @@
      
      hashPassword(newPassword, hashedPassword);
      
-     fp = fopen(USERS_FILE, "rb");
-     if (fp == NULL) {
-         printf("\nError: Could not open users file.\n");
+     // The write commits on its own and releases the lock
+     if (!lockRecord(TABLE_USERS, currentUser->id)) {
          return 0;
      }
-     
-     tempFp = fopen(TEMP_FILE, "wb");
-     if (tempFp == NULL) {
-         fclose(fp);
-         printf("\nError: Could not create temporary file.\n");
+     users = getTable(TABLE_USERS);
+     slot = tableLookup(users, currentUser->id);
+     if (slot < 0) {
+         printf("\nError: Could not open users file.\n");
          return 0;
      }
      
-     while (fread(&tempUser, sizeof(User), 1, fp) == 1) {
-         if (tempUser.id == currentUser->id) {
-             strcpy(tempUser.password, hashedPassword);
-             strcpy(currentUser->password, hashedPassword);
-         }
-         fwrite(&tempUser, sizeof(User), 1, tempFp);
+     strcpy(((User *)tableRecord(users, slot))->password, hashedPassword);
+     if (!tableWriteRecord(users, slot)) {
+         return 0;
      }
-     
-     fclose(fp);
-     fclose(tempFp);
-     
-     remove(USERS_FILE);
-     rename(TEMP_FILE, USERS_FILE);
+     strcpy(currentUser->password, hashedPassword);
      
      printf("\nPassword changed successfully.\n");
      return 1;
@@ -510,6 +470,7 @@
      }
      
      do {
+         refreshTables();
          clearScreen();
          printf("===== USER MANAGEMENT =====\n");
          printf("1. List Users\n");
@@ -29,7 +29,7 @@
      char username[MAX_USERNAME_LEN]; /* Username for login */
      char password[MAX_PASSWORD_LEN]; /* Password (hashed) */
      char name[MAX_NAME_LEN];         /* Full name of the user */
-     int role;                        /* User role (admin or staff) */
+     int role;                        /* User role (admin or staff), 0 once deleted */
      char lastLogin[20];              /* Last login timestamp */
      int active;                      /* Whether the account is active */
  } User;
@@ -44,6 +44,16 @@
   */
  int loginUser(User *user);
  
+ /**
+  * Check a username and password without prompting
+  * 
+  * @param username Username to look up
+  * @param password Plain-text password to verify
+  * @param user Pointer to User structure to store the user's info
+  * @return 1 if the credentials are valid, 0 otherwise
+  */
+ int authenticateUser(const char *username, const char *password, User *user);
+ 
  /**
   * Add a new user to the system
   * 
@@ -0,0 +1,362 @@
+/**
+ * Hotel Management System
+ * availability.c - Room availability index implementation
+ *
+ * This file implements the per-room availability index. Each room slot
+ * owns an array of stays sorted by check-in day, together with the
+ * running maximum of check-out days. A range query finds the last stay
+ * starting before the range ends by binary search; the room is taken
+ * if any stay up to that point ends after the range starts, which is
+ * exactly what the running maximum records.
+ *
+ * Hotel-wide queries use an occupancy calendar: one bitmap row per day,
+ * one bit per room slot. OR-ing the rows of the requested nights gives
+ * every room that is taken at some point in the range. The calendar
+ * covers the days spanned by held stays plus a year of slack, is kept
+ * current on each update, and is rebuilt lazily when a stay falls
+ * outside it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "availability.h"
+#include "table.h"
+#include "utils.h"
+
+#define SCHEDULE_INITIAL_CAPACITY 8
+#define CALENDAR_SLACK_DAYS 366
+
+/* A reservation holding a room for [start, end) */
+typedef struct {
+    Date start;             /* Check-in day */
+    Date end;               /* Check-out day */
+    int reservationId;      /* Reservation holding the room */
+} Stay;
+
+/* Stays of one room, sorted by start day */
+typedef struct {
+    Stay *stays;            /* Stays sorted by start day */
+    int *maxEnd;            /* maxEnd[i] = largest end among stays[0..i] */
+    int count;              /* Number of stays */
+    int capacity;           /* Number of allocated stays */
+} RoomSchedule;
+
+static RoomSchedule *schedules = NULL;  /* Indexed by room table slot */
+static int scheduleCount = 0;
+static int built = 0;
+
+static uint64_t *calendar = NULL;       /* calendarDays rows of calendarWords words */
+static uint64_t *nightMask = NULL;      /* Scratch row for range queries */
+static int calendarStart = 0;           /* Day number of the first row */
+static int calendarDays = 0;
+static int calendarWords = 0;
+static int calendarValid = 0;
+
+/* Check whether a reservation currently holds its room */
+static int holdsRoom(const Reservation *res) {
+    return res->isActive &&
+           (res->status == RESERVATION_STATUS_CONFIRMED ||
+            res->status == RESERVATION_STATUS_CHECKED_IN);
+}
+
+/* Get the schedule of a room, growing the schedule array if needed */
+static RoomSchedule *getSchedule(int roomId) {
+    Table *rooms = getTable(TABLE_ROOMS);
+    int slot = tableLookup(rooms, roomId);
+
+    if (slot < 0) {
+        return NULL;
+    }
+
+    if (slot >= scheduleCount) {
+        int newCount = rooms->count > slot ? rooms->count : slot + 1;
+        RoomSchedule *newSchedules = realloc(schedules, (size_t)newCount * sizeof(RoomSchedule));
+        if (newSchedules == NULL) {
+            printf("\nError: Out of memory while indexing room availability.\n");
+            return NULL;
+        }
+        memset(newSchedules + scheduleCount, 0, (size_t)(newCount - scheduleCount) * sizeof(RoomSchedule));
+        schedules = newSchedules;
+        scheduleCount = newCount;
+    }
+    return &schedules[slot];
+}
+
+/* Recompute the running maximum end from a position onwards */
+static void updateMaxEnd(RoomSchedule *schedule, int from) {
+    for (int i = from; i < schedule->count; i++) {
+        int previous = i > 0 ? schedule->maxEnd[i - 1] : schedule->stays[i].end;
+        schedule->maxEnd[i] = schedule->stays[i].end > previous ? schedule->stays[i].end : previous;
+    }
+}
+
+/* Find the number of stays that start before a day */
+static int countStartingBefore(const RoomSchedule *schedule, int day) {
+    int low = 0, high = schedule->count;
+
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (schedule->stays[mid].start < day) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/* Set or clear a room's bit for each night of a stay in the calendar */
+static void markNights(int slot, int start, int end, int held) {
+    if (!calendarValid) {
+        return;
+    }
+
+    /* A stay outside the calendar means it has to be rebuilt */
+    if (slot >= calendarWords * 64 || start < calendarStart || end > calendarStart + calendarDays) {
+        calendarValid = 0;
+        return;
+    }
+
+    for (int day = start; day < end; day++) {
+        uint64_t *word = &calendar[(size_t)(day - calendarStart) * calendarWords + (slot >> 6)];
+        if (held) {
+            *word |= (uint64_t)1 << (slot & 63);
+        } else {
+            *word &= ~((uint64_t)1 << (slot & 63));
+        }
+    }
+}
+
+/* Rebuild the occupancy calendar from the room schedules */
+static int buildCalendar(void) {
+    Table *rooms = getTable(TABLE_ROOMS);
+    int firstDay = INT_MAX, lastDay = INT_MIN;
+    int slots = rooms->count > scheduleCount ? rooms->count : scheduleCount;
+
+    for (int slot = 0; slot < scheduleCount; slot++) {
+        for (int i = 0; i < schedules[slot].count; i++) {
+            if (schedules[slot].stays[i].start < firstDay) firstDay = schedules[slot].stays[i].start;
+            if (schedules[slot].stays[i].end > lastDay) lastDay = schedules[slot].stays[i].end;
+        }
+    }
+    if (firstDay > lastDay) {
+        firstDay = lastDay = 0; /* No held stays */
+    }
+
+    free(calendar);
+    free(nightMask);
+    calendarStart = firstDay;
+    calendarDays = lastDay - firstDay + CALENDAR_SLACK_DAYS;
+    calendarWords = (slots + 63) / 64 + 1; /* Spare word for rooms added later */
+    calendar = calloc((size_t)calendarDays * calendarWords, sizeof(uint64_t));
+    nightMask = malloc((size_t)calendarWords * sizeof(uint64_t));
+    if (calendar == NULL || nightMask == NULL) {
+        printf("\nError: Out of memory while building the occupancy calendar.\n");
+        calendarValid = 0;
+        return 0;
+    }
+    calendarValid = 1;
+
+    for (int slot = 0; slot < scheduleCount; slot++) {
+        for (int i = 0; i < schedules[slot].count; i++) {
+            markNights(slot, schedules[slot].stays[i].start, schedules[slot].stays[i].end, 1);
+        }
+    }
+    return 1;
+}
+
+/* Add a reservation's stay to its room schedule */
+static void addStay(const Reservation *res) {
+    RoomSchedule *schedule;
+    Stay stay;
+    int pos;
+
+    stay.start = res->checkInDate;
+    stay.end = res->checkOutDate;
+    stay.reservationId = res->id;
+
+    schedule = getSchedule(res->roomId);
+    if (schedule == NULL) {
+        return;
+    }
+
+    if (schedule->count == schedule->capacity) {
+        int newCapacity = schedule->capacity > 0 ? schedule->capacity * 2 : SCHEDULE_INITIAL_CAPACITY;
+        Stay *newStays = realloc(schedule->stays, (size_t)newCapacity * sizeof(Stay));
+        int *newMaxEnd;
+        if (newStays == NULL) {
+            printf("\nError: Out of memory while indexing room availability.\n");
+            return;
+        }
+        schedule->stays = newStays;
+        newMaxEnd = realloc(schedule->maxEnd, (size_t)newCapacity * sizeof(int));
+        if (newMaxEnd == NULL) {
+            printf("\nError: Out of memory while indexing room availability.\n");
+            return;
+        }
+        schedule->maxEnd = newMaxEnd;
+        schedule->capacity = newCapacity;
+    }
+
+    /* Insert after any stays with the same start to keep the order stable */
+    pos = countStartingBefore(schedule, stay.start + 1);
+    memmove(&schedule->stays[pos + 1], &schedule->stays[pos],
+            (size_t)(schedule->count - pos) * sizeof(Stay));
+    schedule->stays[pos] = stay;
+    schedule->count++;
+    updateMaxEnd(schedule, pos);
+
+    markNights((int)(schedule - schedules), stay.start, stay.end, 1);
+}
+
+/* Remove a reservation's stay from its room schedule */
+static void removeStay(const Reservation *res) {
+    RoomSchedule *schedule = getSchedule(res->roomId);
+
+    if (schedule == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < schedule->count; i++) {
+        if (schedule->stays[i].reservationId == res->id) {
+            Stay removed = schedule->stays[i];
+            int slot = (int)(schedule - schedules);
+
+            memmove(&schedule->stays[i], &schedule->stays[i + 1],
+                    (size_t)(schedule->count - i - 1) * sizeof(Stay));
+            schedule->count--;
+            updateMaxEnd(schedule, i);
+
+            /* Clear the nights, then restore any still covered by another stay */
+            markNights(slot, removed.start, removed.end, 0);
+            for (int j = 0; j < schedule->count; j++) {
+                if (schedule->stays[j].start < removed.end && schedule->stays[j].end > removed.start) {
+                    markNights(slot, schedule->stays[j].start, schedule->stays[j].end, 1);
+                }
+            }
+            return;
+        }
+    }
+}
+
+/* Build the availability index from the reservation table */
+int buildAvailability(void) {
+    Table *reservations = getTable(TABLE_RESERVATIONS);
+
+    for (int i = 0; i < scheduleCount; i++) {
+        schedules[i].count = 0;
+    }
+    built = 1;
+    calendarValid = 0;
+
+    for (int i = 0; i < reservations->count; i++) {
+        Reservation *res = tableRecord(reservations, i);
+        if (holdsRoom(res)) {
+            addStay(res);
+        }
+    }
+    return 1;
+}
+
+/* Update the availability index after a reservation changes */
+void availabilityUpdate(const Reservation *before, const Reservation *after) {
+    if (!built) {
+        buildAvailability(); /* Builds from the table, which already holds the change */
+        return;
+    }
+
+    if (before != NULL && holdsRoom(before)) {
+        removeStay(before);
+    }
+    if (after != NULL && holdsRoom(after)) {
+        addStay(after);
+    }
+}
+
+/* Discard the index so the next query rebuilds it */
+void invalidateAvailability(void) {
+    built = 0;
+}
+
+/* Check whether a room has no reservation overlapping a range of days */
+int isRoomFreeForDays(int roomId, Date startDay, Date endDay) {
+    RoomSchedule *schedule;
+    int n;
+
+    if (!built) {
+        buildAvailability();
+    }
+
+    schedule = getSchedule(roomId);
+    if (schedule == NULL) {
+        return 1;
+    }
+
+    /* Only stays starting before endDay can overlap; one of them does if it ends after startDay */
+    n = countStartingBefore(schedule, endDay);
+    return n == 0 || schedule->maxEnd[n - 1] <= startDay;
+}
+
+/* Check whether a room has any reservation holding it */
+int roomHasHeldStays(int roomId) {
+    RoomSchedule *schedule;
+
+    if (!built) {
+        buildAvailability();
+    }
+
+    schedule = getSchedule(roomId);
+    return schedule != NULL && schedule->count > 0;
+}
+
+/* Find every room free for a date range that matches the given filters */
+int findFreeRooms(Date checkInDate, Date checkOutDate, RoomType type,
+                  int minCapacity, double maxRate, int *roomIds, int maxRooms) {
+    Table *rooms;
+    int from, to;
+    int count = 0;
+
+    if (checkInDate >= checkOutDate) {
+        return 0;
+    }
+
+    if (!built) {
+        buildAvailability();
+    }
+    if (!calendarValid && !buildCalendar()) {
+        return 0;
+    }
+
+    /* Combine the rows of every night in the range */
+    memset(nightMask, 0, (size_t)calendarWords * sizeof(uint64_t));
+    from = checkInDate > calendarStart ? checkInDate : calendarStart;
+    to = checkOutDate < calendarStart + calendarDays ? checkOutDate : calendarStart + calendarDays;
+    for (int day = from; day < to; day++) {
+        const uint64_t *row = &calendar[(size_t)(day - calendarStart) * calendarWords];
+        for (int w = 0; w < calendarWords; w++) {
+            nightMask[w] |= row[w];
+        }
+    }
+
+    rooms = getTable(TABLE_ROOMS);
+    for (int slot = 0; slot < rooms->count && count < maxRooms; slot++) {
+        Room *room;
+
+        if (slot < calendarWords * 64 && (nightMask[slot >> 6] >> (slot & 63)) & 1) {
+            continue;
+        }
+
+        room = tableRecord(rooms, slot);
+        if (room->isActive &&
+            room->status != ROOM_STATUS_MAINTENANCE &&
+            (type == 0 || room->type == type) &&
+            (minCapacity == 0 || room->capacity >= minCapacity) &&
+            (maxRate == 0.0 || room->rate <= maxRate)) {
+            roomIds[count++] = room->id;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,82 @@
+/**
+ * Hotel Management System
+ * availability.h - Room availability index header
+ *
+ * This file contains declarations for the per-room availability index.
+ * Every reservation that holds a room (confirmed or checked in) is kept
+ * as a [check-in, check-out) interval of day numbers in a sorted array
+ * for its room, so overlap checks are answered by binary search instead
+ * of scanning the reservation file. A day-by-room occupancy bitmap
+ * answers hotel-wide free-room queries.
+ */
+
+#ifndef AVAILABILITY_H
+#define AVAILABILITY_H
+
+#include "reservation.h"
+
+/**
+ * Build the availability index from the reservation table
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int buildAvailability(void);
+
+/**
+ * Update the availability index after a reservation changes
+ *
+ * Either pointer may be NULL: pass NULL as before for a new reservation,
+ * or NULL as after for a removed one. Only reservations that hold their
+ * room are indexed, so status changes such as cancellation or check-out
+ * release the interval.
+ *
+ * @param before Reservation as it was before the change, or NULL
+ * @param after Reservation as it is after the change, or NULL
+ */
+void availabilityUpdate(const Reservation *before, const Reservation *after);
+
+/**
+ * Discard the index so the next query rebuilds it
+ *
+ * Call this when reservations or rooms have changed without going
+ * through availabilityUpdate, such as by another terminal.
+ */
+void invalidateAvailability(void);
+
+/**
+ * Check whether a room has no reservation overlapping a range of days
+ *
+ * @param roomId Room number
+ * @param startDay First night (inclusive)
+ * @param endDay Departure day (exclusive)
+ * @return 1 if the room is free for the whole range, 0 otherwise
+ */
+int isRoomFreeForDays(int roomId, Date startDay, Date endDay);
+
+/**
+ * Check whether a room has any reservation holding it
+ *
+ * @param roomId Room number
+ * @return 1 if the room has a confirmed or checked-in reservation, 0 otherwise
+ */
+int roomHasHeldStays(int roomId);
+
+/**
+ * Find every room free for a date range that matches the given filters
+ *
+ * Rooms under maintenance or inactive are never returned. Filters use
+ * the same conventions as searchRooms: 0 means "any".
+ *
+ * @param checkInDate Check-in date
+ * @param checkOutDate Check-out date, after check-in
+ * @param type Room type to match, or 0 for any
+ * @param minCapacity Minimum capacity, or 0 for any
+ * @param maxRate Maximum rate per night, or 0 for any
+ * @param roomIds Array that receives the free room numbers
+ * @param maxRooms Size of the roomIds array
+ * @return Number of room numbers stored in roomIds
+ */
+int findFreeRooms(Date checkInDate, Date checkOutDate, RoomType type,
+                  int minCapacity, double maxRate, int *roomIds, int maxRooms);
+
+#endif /* AVAILABILITY_H */
@@ -0,0 +1,472 @@
+/**
+ * Hotel Management System
+ * batch.c - Batch command interpreter implementation
+ *
+ * This file implements the non-interactive command mode. Each script
+ * line is split into arguments, validated and dispatched to the module
+ * functions behind the menus. The tables are loaded once at startup,
+ * so a script of many commands pays for the file cache warm-up once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "batch.h"
+#include "auth.h"
+#include "room.h"
+#include "guest.h"
+#include "reservation.h"
+#include "billing.h"
+#include "audit.h"
+#include "occupancy.h"
+#include "revenue.h"
+#include "utils.h"
+#include "fileio.h"
+#include "wal.h"
+
+#define BATCH_LINE_LEN 1024
+#define BATCH_MAX_ARGS 16
+
+/* Batch command definition */
+typedef struct {
+    const char *name;
+    int minArgs;            /* Arguments required after the name */
+    int maxArgs;            /* Arguments allowed after the name */
+    int needsLogin;
+    int (*run)(User *currentUser, int argc, char **argv);
+    const char *usage;
+} BatchCommand;
+
+static User batchUser;
+static int loggedIn = 0;
+static int openTransactions = 0;
+
+static const char *roomTypeNames[] = { "standard", "deluxe", "suite", "executive", "presidential" };
+static const char *roomStatusNames[] = { "available", "occupied", "maintenance", "reserved", "cleaning" };
+static const char *itemTypeNames[] = { "room", "food", "laundry", "minibar", "spa", "tax", "discount", "other" };
+static const char *paymentMethodNames[] = { "cash", "credit", "debit", "transfer", "online" };
+
+/* Current time in milliseconds for per-command timing */
+static double currentMillis(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    return (double)clock() * 1000.0 / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+#endif
+}
+
+/* Split a line into arguments; double quotes group words */
+static int splitArgs(char *line, char **argv) {
+    int argc = 0;
+    char *p = line;
+
+    while (*p != '\0' && argc < BATCH_MAX_ARGS) {
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0') break;
+
+        if (*p == '"') {
+            argv[argc++] = ++p;
+            while (*p != '\0' && *p != '"') p++;
+        } else {
+            argv[argc++] = p;
+            while (*p != '\0' && *p != ' ' && *p != '\t') p++;
+        }
+        if (*p != '\0') *p++ = '\0';
+    }
+    return argc;
+}
+
+/* Parse a whole string as an integer */
+static int parseInt(const char *text, int *value) {
+    char *end;
+    long v = strtol(text, &end, 10);
+    if (end == text || *end != '\0') {
+        printf("\nError: '%s' is not a number.\n", text);
+        return 0;
+    }
+    *value = (int)v;
+    return 1;
+}
+
+/* Parse a whole string as an amount */
+static int parseAmount(const char *text, double *value) {
+    char *end;
+    double v = strtod(text, &end);
+    if (end == text || *end != '\0' || v < 0) {
+        printf("\nError: '%s' is not a valid amount.\n", text);
+        return 0;
+    }
+    *value = v;
+    return 1;
+}
+
+/* Parse a YYYY-MM-DD date */
+static int parseDate(const char *text, Date *date) {
+    if (!validateDate(text) || !dateFromString(text, date)) {
+        printf("\nError: '%s' is not a valid date (YYYY-MM-DD).\n", text);
+        return 0;
+    }
+    return 1;
+}
+
+/* Find a keyword in a list of names, returning its index */
+static int parseKeyword(const char *text, const char **names, int count, int *index) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(text, names[i]) == 0) {
+            *index = i;
+            return 1;
+        }
+    }
+    printf("\nError: Unknown value '%s'. Expected one of:", text);
+    for (int i = 0; i < count; i++) {
+        printf(" %s", names[i]);
+    }
+    printf("\n");
+    return 0;
+}
+
+/* Copy an optional argument into a fixed-size field */
+static void copyArg(char *dest, size_t size, int argc, char **argv, int index) {
+    const char *src = index < argc ? argv[index] : "";
+    strncpy(dest, src, size - 1);
+    dest[size - 1] = '\0';
+}
+
+static int cmdLogin(User *currentUser, int argc, char **argv) {
+    if (!authenticateUser(argv[1], argv[2], &batchUser)) {
+        printf("\nError: Invalid username or password.\n");
+        loggedIn = 0;
+        return 0;
+    }
+    loggedIn = 1;
+    printf("\nLogged in as %s.\n", batchUser.username);
+    return 1;
+}
+
+static int cmdAddRoom(User *currentUser, int argc, char **argv) {
+    Room room;
+    char description[MAX_ROOM_DESC_LEN];
+    char features[MAX_ROOM_FEATURES_LEN];
+    int type;
+
+    memset(&room, 0, sizeof(room));
+    if (!parseInt(argv[1], &room.id) ||
+        !parseKeyword(argv[2], roomTypeNames, 5, &type) ||
+        !parseAmount(argv[3], &room.rate) ||
+        !parseInt(argv[4], &room.capacity) ||
+        !parseInt(argv[5], &room.floor)) {
+        return 0;
+    }
+    room.type = (RoomType)(type + 1);
+    copyArg(description, sizeof(description), argc, argv, 6);
+    copyArg(features, sizeof(features), argc, argv, 7);
+    return createRoom(currentUser, &room, description, features);
+}
+
+static int cmdRoomStatus(User *currentUser, int argc, char **argv) {
+    int roomId, status;
+
+    if (!parseInt(argv[1], &roomId) || !parseKeyword(argv[2], roomStatusNames, 5, &status)) {
+        return 0;
+    }
+    return changeRoomStatus(roomId, (RoomStatus)(status + 1));
+}
+
+static int cmdAddGuest(User *currentUser, int argc, char **argv) {
+    Guest guest;
+    char address[MAX_ADDRESS_LEN];
+    char idType[MAX_ID_TYPE_LEN];
+    char notes[MAX_NOTES_LEN];
+
+    memset(&guest, 0, sizeof(guest));
+    copyArg(guest.name, sizeof(guest.name), argc, argv, 1);
+    copyArg(guest.phone, sizeof(guest.phone), argc, argv, 2);
+    copyArg(guest.email, sizeof(guest.email), argc, argv, 3);
+    copyArg(idType, sizeof(idType), argc, argv, 4);
+    copyArg(guest.idNumber, sizeof(guest.idNumber), argc, argv, 5);
+    copyArg(address, sizeof(address), argc, argv, 6);
+    copyArg(notes, sizeof(notes), argc, argv, 7);
+    return createGuest(&guest, address, idType, notes);
+}
+
+static int cmdReserve(User *currentUser, int argc, char **argv) {
+    int guestId, roomId, numGuests;
+    Date checkIn, checkOut;
+    double paid = 0.0;
+
+    if (!parseInt(argv[1], &guestId) || !parseInt(argv[2], &roomId) ||
+        !parseDate(argv[3], &checkIn) || !parseDate(argv[4], &checkOut) ||
+        !parseInt(argv[5], &numGuests) ||
+        (argc > 6 && !parseAmount(argv[6], &paid))) {
+        return 0;
+    }
+    return createReservation(currentUser, guestId, roomId, checkIn, checkOut, numGuests,
+                             paid, argc > 7 ? argv[7] : "");
+}
+
+static int cmdCheckIn(User *currentUser, int argc, char **argv) {
+    int reservationId;
+    return parseInt(argv[1], &reservationId) && checkInReservation(currentUser, reservationId);
+}
+
+static int cmdCheckOut(User *currentUser, int argc, char **argv) {
+    int reservationId;
+    return parseInt(argv[1], &reservationId) && checkOutReservation(currentUser, reservationId);
+}
+
+static int cmdCancel(User *currentUser, int argc, char **argv) {
+    int reservationId;
+    return parseInt(argv[1], &reservationId) && cancelReservation(currentUser, reservationId);
+}
+
+static int cmdInvoice(User *currentUser, int argc, char **argv) {
+    int reservationId;
+    return parseInt(argv[1], &reservationId) && createInvoice(currentUser, reservationId);
+}
+
+static int cmdCharge(User *currentUser, int argc, char **argv) {
+    int invoiceId, type, quantity;
+    double unitPrice;
+
+    if (!parseInt(argv[1], &invoiceId) || !parseKeyword(argv[2], itemTypeNames, 8, &type) ||
+        !parseAmount(argv[3], &unitPrice) || !parseInt(argv[4], &quantity)) {
+        return 0;
+    }
+    return addBillingItem(currentUser, invoiceId, (BillingItemType)type, argv[5], unitPrice, quantity);
+}
+
+static int cmdPay(User *currentUser, int argc, char **argv) {
+    int invoiceId, method;
+    double amount;
+
+    if (!parseInt(argv[1], &invoiceId) || !parseKeyword(argv[2], paymentMethodNames, 5, &method) ||
+        !parseAmount(argv[3], &amount)) {
+        return 0;
+    }
+    return recordPayment(currentUser, invoiceId, (PaymentMethod)method, amount,
+                         argc > 4 ? argv[4] : "", argc > 5 ? argv[5] : "");
+}
+
+static int cmdFreeRooms(User *currentUser, int argc, char **argv) {
+    Date checkIn, checkOut;
+
+    if (!parseDate(argv[1], &checkIn) || !parseDate(argv[2], &checkOut)) {
+        return 0;
+    }
+    if (checkIn >= checkOut) {
+        printf("\nError: Check-out must be after check-in.\n");
+        return 0;
+    }
+    listFreeRooms(checkIn, checkOut, 0, 0, 0.0);
+    return 1;
+}
+
+static int cmdListRooms(User *currentUser, int argc, char **argv) {
+    listRooms(currentUser, 0);
+    return 1;
+}
+
+static int cmdListGuests(User *currentUser, int argc, char **argv) {
+    listGuests(currentUser);
+    return 1;
+}
+
+static int cmdListReservations(User *currentUser, int argc, char **argv) {
+    listReservations(currentUser, 0);
+    return 1;
+}
+
+static int cmdListInvoices(User *currentUser, int argc, char **argv) {
+    listInvoices(currentUser, -1);
+    return 1;
+}
+
+static int cmdOverdue(User *currentUser, int argc, char **argv) {
+    int count = checkOverdueInvoices(getCurrentDay());
+    if (count < 0) {
+        return 0;
+    }
+    printf("\n%d invoice(s) updated to 'Overdue' status.\n", count);
+    return 1;
+}
+
+static int cmdOccupancy(User *currentUser, int argc, char **argv) {
+    Date first, last;
+    if (!parseDate(argv[1], &first) || !parseDate(argv[2], &last)) {
+        return 0;
+    }
+    if (last < first) {
+        printf("\nError: The last night must not be before the first.\n");
+        return 0;
+    }
+    return printOccupancyReport(first, last + 1);
+}
+
+static int cmdRevenue(User *currentUser, int argc, char **argv) {
+    Date first, last;
+    if (!parseDate(argv[1], &first) || !parseDate(argv[2], &last)) {
+        return 0;
+    }
+    if (last < first) {
+        printf("\nError: The last day must not be before the first.\n");
+        return 0;
+    }
+    return printRevenueReport(first, last + 1);
+}
+
+static int cmdNightAudit(User *currentUser, int argc, char **argv) {
+    AuditRun run;
+    if (!runNightAudit(currentUser, &run)) {
+        return 0;
+    }
+    printf("\nNight audit: %d room night(s), $%.2f room revenue, $%.2f tax, %d no-show(s), %d overdue.\n",
+           run.roomNights, run.roomRevenue, run.taxAmount, run.noShows, run.overdueInvoices);
+    return 1;
+}
+
+static int cmdBegin(User *currentUser, int argc, char **argv) {
+    walBegin();
+    openTransactions++;
+    return 1;
+}
+
+static int cmdCommit(User *currentUser, int argc, char **argv) {
+    if (openTransactions == 0) {
+        printf("\nError: commit without begin.\n");
+        return 0;
+    }
+    openTransactions--;
+    return walCommit();
+}
+
+static int cmdCompact(User *currentUser, int argc, char **argv) {
+    if (currentUser->role != ROLE_ADMIN) {
+        printf("\nAccess denied. Admin privileges required.\n");
+        return 0;
+    }
+    return compactDataFiles();
+}
+
+static const BatchCommand commands[] = {
+    { "login",             2, 2, 0, cmdLogin,            "login <username> <password>" },
+    { "add-room",          5, 7, 1, cmdAddRoom,          "add-room <number> <type> <rate> <capacity> <floor> [\"description\"] [\"features\"]" },
+    { "room-status",       2, 2, 1, cmdRoomStatus,       "room-status <number> <status>" },
+    { "add-guest",         5, 7, 1, cmdAddGuest,         "add-guest \"<name>\" <phone> <email> <id-type> <id-number> [\"address\"] [\"notes\"]" },
+    { "reserve",           5, 7, 1, cmdReserve,          "reserve <guest-id> <room> <check-in> <check-out> <guests> [paid] [\"notes\"]" },
+    { "check-in",          1, 1, 1, cmdCheckIn,          "check-in <reservation-id>" },
+    { "check-out",         1, 1, 1, cmdCheckOut,         "check-out <reservation-id>" },
+    { "cancel",            1, 1, 1, cmdCancel,           "cancel <reservation-id>" },
+    { "invoice",           1, 1, 1, cmdInvoice,          "invoice <reservation-id>" },
+    { "charge",            5, 5, 1, cmdCharge,           "charge <invoice-id> <type> <unit-price> <quantity> \"<description>\"" },
+    { "pay",               3, 5, 1, cmdPay,              "pay <invoice-id> <method> <amount> [transaction-id] [\"notes\"]" },
+    { "free-rooms",        2, 2, 1, cmdFreeRooms,        "free-rooms <check-in> <check-out>" },
+    { "list-rooms",        0, 0, 1, cmdListRooms,        "list-rooms" },
+    { "list-guests",       0, 0, 1, cmdListGuests,       "list-guests" },
+    { "list-reservations", 0, 0, 1, cmdListReservations, "list-reservations" },
+    { "list-invoices",     0, 0, 1, cmdListInvoices,     "list-invoices" },
+    { "overdue",           0, 0, 1, cmdOverdue,          "overdue" },
+    { "occupancy",         2, 2, 1, cmdOccupancy,        "occupancy <first-night> <last-night>" },
+    { "revenue",           2, 2, 1, cmdRevenue,          "revenue <first-day> <last-day>" },
+    { "night-audit",       0, 0, 1, cmdNightAudit,       "night-audit" },
+    { "compact",           0, 0, 1, cmdCompact,          "compact" },
+    { "begin",             0, 0, 0, cmdBegin,            "begin" },
+    { "commit",            0, 0, 0, cmdCommit,           "commit" }
+};
+
+/* Validate and run one parsed command */
+static int runCommand(int argc, char **argv) {
+    int count = (int)(sizeof(commands) / sizeof(commands[0]));
+    int ok;
+
+    for (int i = 0; i < count; i++) {
+        const BatchCommand *cmd = &commands[i];
+        if (strcmp(argv[0], cmd->name) != 0) {
+            continue;
+        }
+        if (argc - 1 < cmd->minArgs || argc - 1 > cmd->maxArgs) {
+            printf("\nError: Usage: %s\n", cmd->usage);
+            return 0;
+        }
+        if (cmd->needsLogin && !loggedIn) {
+            printf("\nError: '%s' requires a successful login first.\n", cmd->name);
+            return 0;
+        }
+
+        /* Compaction checkpoints the log, so it runs outside any transaction */
+        if (cmd->run == cmdCompact) {
+            return cmd->run(&batchUser, argc, argv);
+        }
+
+        /* Each command's changes commit together, or not at all */
+        walBegin();
+        ok = cmd->run(&batchUser, argc, argv);
+        if (!ok) {
+            walAbort();
+            return 0;
+        }
+        return walCommit();
+    }
+
+    printf("\nError: Unknown command '%s'.\n", argv[0]);
+    return 0;
+}
+
+/* Run a batch script */
+int runBatch(const char *path) {
+    FILE *fp;
+    char line[BATCH_LINE_LEN];
+    char *argv[BATCH_MAX_ARGS];
+    int lineNumber = 0, commandCount = 0, failed = 0;
+    double started, total = 0.0;
+
+    if (strcmp(path, "-") == 0) {
+        fp = stdin;
+    } else {
+        fp = fopen(path, "r");
+        if (fp == NULL) {
+            printf("\nError: Could not open batch file %s.\n", path);
+            return 1;
+        }
+    }
+
+    setInteractive(0);
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        int argc, ok;
+        double elapsed;
+
+        lineNumber++;
+        line[strcspn(line, "\r\n")] = '\0';
+        argc = splitArgs(line, argv);
+        if (argc == 0 || argv[0][0] == '#') {
+            continue;
+        }
+
+        started = currentMillis();
+        ok = runCommand(argc, argv);
+        elapsed = currentMillis() - started;
+
+        total += elapsed;
+        commandCount++;
+        if (!ok) failed++;
+        printf("[line %d] %s: %s (%.3f ms)\n", lineNumber, argv[0], ok ? "ok" : "FAILED", elapsed);
+    }
+
+    if (fp != stdin) {
+        fclose(fp);
+    }
+
+    /* Close any group the script left open so its changes are not lost */
+    while (openTransactions > 0) {
+        openTransactions--;
+        if (!walCommit()) {
+            failed++;
+        }
+    }
+
+    printf("\nBatch complete: %d command(s), %d failed, %.3f ms total.\n", commandCount, failed, total);
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * Hotel Management System
+ * batch.h - Batch command interpreter header
+ *
+ * This file contains declarations for running the system without the
+ * interactive menus. A batch script holds one command per line; each
+ * command calls the same module functions the menus use and is timed.
+ *
+ * Commands (arguments containing spaces go in double quotes):
+ *   login <username> <password>
+ *   add-room <number> <type> <rate> <capacity> <floor> ["description"] ["features"]
+ *   room-status <number> <available|occupied|maintenance|reserved|cleaning>
+ *   add-guest "<name>" <phone> <email> <id-type> <id-number> ["address"] ["notes"]
+ *   reserve <guest-id> <room> <check-in> <check-out> <guests> [paid] ["notes"]
+ *   check-in <reservation-id>
+ *   check-out <reservation-id>
+ *   cancel <reservation-id>
+ *   invoice <reservation-id>
+ *   charge <invoice-id> <type> <unit-price> <quantity> "<description>"
+ *   pay <invoice-id> <method> <amount> [transaction-id] ["notes"]
+ *   free-rooms <check-in> <check-out>
+ *   list-rooms | list-guests | list-reservations | list-invoices
+ *   overdue
+ *   occupancy <first-night> <last-night>
+ *   revenue <first-day> <last-day>
+ *   night-audit
+ *   compact
+ *   begin | commit
+ *
+ * Lines starting with # are comments. Every command is committed to the
+ * write-ahead log on its own unless it falls between begin and commit,
+ * in which case the whole group shares one commit. compact rewrites
+ * the data files and cannot be used inside a group.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+/**
+ * Run a batch script
+ *
+ * @param path Script file, or "-" to read commands from standard input
+ * @return 0 if every command succeeded, 1 otherwise
+ */
+int runBatch(const char *path);
+
+#endif /* BATCH_H */
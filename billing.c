@@ -17,14 +17,15 @@
  #include "guest.h"
  #include "reservation.h"
  #include "room.h"
- 
- #define TEMP_INVOICES_FILE "data/temp_invoices.dat"
- #define TEMP_ITEMS_FILE "data/temp_items.dat"
- #define TEMP_PAYMENTS_FILE "data/temp_payments.dat"
+ #include "table.h"
+ #include "wal.h"
+ #include "lock.h"
+ #include "textheap.h"
  
  // Forward declarations for local utility functions
- static void updateInvoiceAmounts(int invoiceId);
- static double calculateInvoicePaid(int invoiceId);
+ static void applyBillingItem(Invoice *inv, const BillingItem *item);
+ static int findInvoiceSlot(int invoiceId);
+ static Invoice *expectedTotals(void);
  
  /* Get the string representation of an invoice status */
  const char* getInvoiceStatusString(InvoiceStatus status) {
@@ -94,7 +95,11 @@
          fclose(fp);
      }
      
-     int count = checkOverdueInvoices();
+     if (!loadTable(TABLE_INVOICES) || !loadTable(TABLE_BILLING_ITEMS) || !loadTable(TABLE_PAYMENTS)) {
+         return 0;
+     }
+     
+     int count = checkOverdueInvoices(getCurrentDay());
      if (count > 0) {
          printf("\nSystem check: %d invoice(s) marked as overdue.\n", count);
      }
@@ -103,65 +108,89 @@
  
  /* Create a new invoice for a reservation */
  int createInvoice(User *currentUser, int reservationId) {
-     Invoice newInvoice;
+     Invoice existing;
      Reservation reservation;
+     int invoiceId;
  
-     if (!getReservationById(reservationId, &reservation)) {
-         printf("\nError: Reservation with ID %d not found.\n", reservationId);
+     // Lock before the checks so another terminal cannot invoice the reservation too
+     walBegin();
+     if (!lockRecord(TABLE_RESERVATIONS, reservationId) || !lockAppend(TABLE_INVOICES)) {
+         walAbort();
          return 0;
      }
      
-     if (getInvoiceByReservationId(reservationId, &newInvoice)) {
-         printf("\nError: Invoice already exists for reservation ID %d (Invoice ID: %d).\n", reservationId, newInvoice.id);
+     if (!getReservationById(reservationId, &reservation)) {
+         printf("\nError: Reservation with ID %d not found.\n", reservationId);
+         walAbort();
          return 0;
      }
      
-     int nextId = 1;
-     FILE *fp = fopen(INVOICES_FILE, "rb");
-     if (fp) {
-         Invoice temp;
-         while(fread(&temp, sizeof(Invoice), 1, fp) == 1) {
-             if (temp.id >= nextId) nextId = temp.id + 1;
-         }
-         fclose(fp);
+     if (getInvoiceByReservationId(reservationId, &existing)) {
+         printf("\nError: Invoice already exists for reservation ID %d (Invoice ID: %d).\n", reservationId, existing.id);
+         walAbort();
+         return 0;
      }
- 
-     newInvoice.id = nextId;
-     newInvoice.reservationId = reservationId;
-     newInvoice.guestId = reservation.guestId;
-     newInvoice.status = INVOICE_STATUS_DRAFT;
-     newInvoice.paidAmount = 0.0;
-     newInvoice.createdBy = currentUser->id;
-     newInvoice.isActive = 1;
-     strcpy(newInvoice.notes, "Auto-generated invoice.");
      
-     getCurrentDate(newInvoice.issueDate);
-     // Set due date to reservation check-out date
-     strcpy(newInvoice.dueDate, reservation.checkOutDate);
- 
-     // Save the invoice shell first
-     fp = fopen(INVOICES_FILE, "ab");
-     if (!fp) {
-         printf("\nError: Could not open invoices file for writing.\n");
+     // Save the invoice shell first; it and its room charge commit together
+     invoiceId = openInvoice(currentUser, &reservation);
+     if (invoiceId == 0) {
+         walAbort();
          return 0;
      }
-     fwrite(&newInvoice, sizeof(Invoice), 1, fp);
-     fclose(fp);
      
      // Add room charge as the first billing item
      Room room;
      if (getRoomById(reservation.roomId, &room)) {
-         int days = calculateDateDifference(reservation.checkInDate, reservation.checkOutDate);
+         int days = reservation.checkOutDate - reservation.checkInDate;
          if (days <= 0) days = 1;
          
          char description[MAX_BILLING_DESCRIPTION_LEN];
          sprintf(description, "Room %d stay (%d nights)", room.id, days);
-         addBillingItem(currentUser, newInvoice.id, BILLING_ITEM_ROOM_CHARGE, description, room.rate, days);
+         if (!addBillingItem(currentUser, invoiceId, BILLING_ITEM_ROOM_CHARGE, description, room.rate, days)) {
+             walAbort();
+             return 0;
+         }
      }
+     if (!walCommit()) {
+         return 0;
+     }
+     
+     printf("\nInvoice #%d created successfully for Reservation #%d.\n", invoiceId, reservationId);
+     return invoiceId;
+ }
+ 
+ /* Append an empty draft invoice for a reservation */
+ int openInvoice(User *currentUser, const Reservation *reservation) {
+     Table *invoices = getTable(TABLE_INVOICES);
+     Invoice newInvoice;
      
-     updateInvoiceAmounts(newInvoice.id);
+     walBegin();
+     if (!lockAppend(TABLE_INVOICES)) {
+         walAbort();
+         return 0;
+     }
      
-     printf("\nInvoice #%d created successfully for Reservation #%d.\n", newInvoice.id, reservationId);
+     memset(&newInvoice, 0, sizeof(newInvoice));
+     newInvoice.id = tableNextId(invoices);
+     newInvoice.reservationId = reservation->id;
+     newInvoice.guestId = reservation->guestId;
+     newInvoice.status = INVOICE_STATUS_DRAFT;
+     newInvoice.createdBy = currentUser->id;
+     newInvoice.isActive = 1;
+     newInvoice.notes = storeText("Auto-generated invoice.");
+     
+     newInvoice.issueDate = getCurrentDay();
+     // Set due date to reservation check-out date
+     newInvoice.dueDate = reservation->checkOutDate;
+     
+     if (newInvoice.notes < 0 || tableAppend(invoices, &newInvoice) < 0) {
+         printf("\nError: Could not open invoices file for writing.\n");
+         walAbort();
+         return 0;
+     }
+     if (!walCommit()) {
+         return 0;
+     }
      return newInvoice.id;
  }
  
@@ -170,179 +199,294 @@
  int addBillingItem(User *currentUser, int invoiceId, BillingItemType type, const char *description, 
                    double unitPrice, int quantity) {
      Invoice invoice;
+     int ok;
+     
+     // The invoice stays locked from the status check until the item is posted
+     walBegin();
+     if (!lockRecord(TABLE_INVOICES, invoiceId)) {
+         walAbort();
+         return 0;
+     }
+     
      if (!getInvoiceById(invoiceId, &invoice)) {
          printf("\nError: Invoice with ID %d not found.\n", invoiceId);
+         walAbort();
          return 0;
      }
  
      if (invoice.status == INVOICE_STATUS_PAID || invoice.status == INVOICE_STATUS_CANCELLED) {
          printf("\nError: Cannot add items to a %s invoice.\n", getInvoiceStatusString(invoice.status));
+         walAbort();
          return 0;
      }
      
-     int nextId = 1;
-     FILE *fp = fopen(BILLING_ITEMS_FILE, "rb");
-     if (fp) {
-         BillingItem temp;
-         while(fread(&temp, sizeof(BillingItem), 1, fp) == 1) {
-             if (temp.id >= nextId) nextId = temp.id + 1;
-         }
-         fclose(fp);
+     ok = postBillingItem(findInvoiceSlot(invoiceId), type, description, unitPrice, quantity, getCurrentDay());
+     if (!ok) {
+         walAbort();
+         return 0;
      }
+     if (!walCommit()) {
+         return 0;
+     }
+     
+     printf("\nBilling item added to Invoice #%d.\n", invoiceId);
+     return 1;
+ }
  
+ /* Append a billing item and fold it into its invoice's totals */
+ int postBillingItem(int invoiceSlot, BillingItemType type, const char *description,
+                     double unitPrice, int quantity, Date serviceDate) {
+     Table *invoices = getTable(TABLE_INVOICES);
+     Table *items = getTable(TABLE_BILLING_ITEMS);
+     Invoice *inv = tableRecord(invoices, invoiceSlot);
      BillingItem newItem;
-     newItem.id = nextId;
-     newItem.invoiceId = invoiceId;
+     
+     walBegin();
+     if (!lockAppend(TABLE_BILLING_ITEMS)) {
+         walAbort();
+         return 0;
+     }
+     
+     newItem.id = tableNextId(items);
+     newItem.invoiceId = inv->id;
      newItem.type = type;
      strncpy(newItem.description, description, MAX_BILLING_DESCRIPTION_LEN - 1);
      newItem.description[MAX_BILLING_DESCRIPTION_LEN - 1] = '\0';
      newItem.unitPrice = unitPrice;
      newItem.quantity = quantity;
      newItem.amount = unitPrice * quantity;
+     newItem.serviceDate = serviceDate;
      newItem.isActive = 1;
      
-     fp = fopen(BILLING_ITEMS_FILE, "ab");
-     if (!fp) {
+     if (tableAppend(items, &newItem) < 0) {
          printf("\nError: Could not open billing items file.\n");
+         walAbort();
          return 0;
      }
-     fwrite(&newItem, sizeof(BillingItem), 1, fp);
-     fclose(fp);
      
-     updateInvoiceAmounts(invoiceId);
-     printf("\nBilling item added to Invoice #%d.\n", invoiceId);
-     return 1;
+     // Fold the new item into the invoice totals
+     applyBillingItem(inv, &newItem);
+     if (!tableWriteRecord(invoices, invoiceSlot)) {
+         printf("\nError opening invoices file.\n");
+         walAbort();
+         return 0;
+     }
+     return walCommit();
  }
  
  /* Record a payment for an invoice */
  int recordPayment(User *currentUser, int invoiceId, PaymentMethod method, double amount, 
                   const char *transactionId, const char *notes) {
      Invoice invoice;
+     
+     // The invoice stays locked from the status check until the payment is applied
+     walBegin();
+     if (!lockRecord(TABLE_INVOICES, invoiceId) || !lockAppend(TABLE_PAYMENTS)) {
+         walAbort();
+         return 0;
+     }
+     
      if (!getInvoiceById(invoiceId, &invoice)) {
          printf("\nError: Invoice with ID %d not found.\n", invoiceId);
+         walAbort();
          return 0;
      }
  
      if (invoice.status == INVOICE_STATUS_PAID || invoice.status == INVOICE_STATUS_CANCELLED) {
          printf("\nError: Cannot record payment for a %s invoice.\n", getInvoiceStatusString(invoice.status));
+         walAbort();
          return 0;
      }
      
-     int nextId = 1;
-     FILE* fp = fopen(PAYMENTS_FILE, "rb");
-     if (fp) {
-         Payment temp;
-         while(fread(&temp, sizeof(Payment), 1, fp) == 1) {
-             if (temp.id >= nextId) nextId = temp.id + 1;
-         }
-         fclose(fp);
-     }
-     
+     Table *payments = getTable(TABLE_PAYMENTS);
      Payment newPayment;
-     newPayment.id = nextId;
+     newPayment.id = tableNextId(payments);
      newPayment.invoiceId = invoiceId;
      newPayment.method = method;
      newPayment.amount = amount;
      newPayment.status = PAYMENT_STATUS_COMPLETED;
-     getCurrentDate(newPayment.transactionDate);
-     strncpy(newPayment.transactionId, transactionId, MAX_PAYMENT_REF_LEN - 1);
-     newPayment.transactionId[MAX_PAYMENT_REF_LEN - 1] = '\0';
-     strncpy(newPayment.notes, notes, MAX_NOTES_LEN - 1);
-     newPayment.notes[MAX_NOTES_LEN - 1] = '\0';
+     newPayment.transactionDate = getCurrentDay();
+     newPayment.transactionId = storeText(transactionId);
+     newPayment.notes = storeText(notes);
      newPayment.createdBy = currentUser->id;
      newPayment.isActive = 1;
      
-     fp = fopen(PAYMENTS_FILE, "ab");
-     if (!fp) {
+     if (newPayment.transactionId < 0 || newPayment.notes < 0 || tableAppend(payments, &newPayment) < 0) {
          printf("\nError: Could not open payments file.\n");
+         walAbort();
          return 0;
      }
-     fwrite(&newPayment, sizeof(Payment), 1, fp);
-     fclose(fp);
      
-     updateInvoiceAmounts(invoiceId);
+     // Add the payment to the invoice's paid amount
+     Table *invoices = getTable(TABLE_INVOICES);
+     int slot = findInvoiceSlot(invoiceId);
+     Invoice *inv = tableRecord(invoices, slot);
+     inv->paidAmount += newPayment.amount;
+     // Settling the balance closes a draft invoice as well as an issued one
+     if (inv->paidAmount >= inv->totalAmount) {
+         inv->status = INVOICE_STATUS_PAID;
+     }
+     if (!tableWriteRecord(invoices, slot)) {
+         printf("\nError opening invoices file.\n");
+         walAbort();
+         return 0;
+     }
      
-     // Refresh invoice data to check if it's now paid
-     getInvoiceById(invoiceId, &invoice);
-     if (invoice.paidAmount >= invoice.totalAmount) {
+     if (inv->status == INVOICE_STATUS_PAID) {
          printf("\nInvoice is now fully paid. Marking as PAID.\n");
-         markInvoiceAsPaid(currentUser, invoiceId);
+         if (!updateGuestStayInfo(inv->guestId, inv->totalAmount)) {
+             walAbort();
+             return 0;
+         }
+     }
+     if (!walCommit()) {
+         return 0;
      }
      
      printf("\nPayment of $%.2f recorded for Invoice #%d.\n", amount, invoiceId);
      return 1;
  }
  
- /* Update invoice total amounts based on its items and payments */
- static void updateInvoiceAmounts(int invoiceId) {
-     double subtotal = 0.0, tax = 0.0, discount = 0.0;
-     
-     FILE *fp_items = fopen(BILLING_ITEMS_FILE, "rb");
-     if (fp_items) {
-         BillingItem item;
-         while(fread(&item, sizeof(BillingItem), 1, fp_items) == 1) {
-             if (item.invoiceId == invoiceId && item.isActive) {
-                 if (item.type == BILLING_ITEM_DISCOUNT) {
-                     discount += item.amount;
-                 } else if (item.type == BILLING_ITEM_TAX) {
-                     tax += item.amount;
-                 } else {
-                     subtotal += item.amount;
-                 }
-             }
-         }
-         fclose(fp_items);
-     }
+ /* Add a billing item's amount to the matching invoice total */
+ static void applyBillingItem(Invoice *inv, const BillingItem *item) {
+     if (item->type == BILLING_ITEM_DISCOUNT) {
+         inv->discountAmount += item->amount;
+     } else if (item->type == BILLING_ITEM_TAX) {
+         inv->taxAmount += item->amount;
+     } else {
+         inv->subtotal += item->amount;
+     }
+     inv->totalAmount = (inv->subtotal + inv->taxAmount) - inv->discountAmount;
+     if (inv->totalAmount < 0) inv->totalAmount = 0;
+ }
+ 
+ /* Check whether two amounts differ by a cent or more */
+ static int amountDiffers(double stored, double expected) {
+     double diff = stored - expected;
+     return diff > 0.005 || diff < -0.005;
+ }
+ 
+ /* Check whether any stored invoice total differs from its recomputed value */
+ static int totalsDiffer(const Invoice *stored, const Invoice *expected) {
+     // Drift in the parts can cancel out in the total, so each is compared
+     return amountDiffers(stored->subtotal, expected->subtotal) ||
+            amountDiffers(stored->taxAmount, expected->taxAmount) ||
+            amountDiffers(stored->discountAmount, expected->discountAmount) ||
+            amountDiffers(stored->totalAmount, expected->totalAmount) ||
+            amountDiffers(stored->paidAmount, expected->paidAmount);
+ }
+ 
+ /* Rebuild every invoice's totals, indexed by slot, in one pass over items and payments */
+ static Invoice *expectedTotals(void) {
+     Table *invoices = getTable(TABLE_INVOICES);
+     Table *items = getTable(TABLE_BILLING_ITEMS);
+     Table *payments = getTable(TABLE_PAYMENTS);
+     Invoice *expected;
      
-     double paid = calculateInvoicePaid(invoiceId);
+     expected = calloc((size_t)invoices->count + 1, sizeof(Invoice));
+     if (expected == NULL) {
+         printf("\nError: Out of memory.\n");
+         return NULL;
+     }
      
-     FILE *fp_inv = fopen(INVOICES_FILE, "rb");
-     if (!fp_inv) return;
-     FILE *fp_temp = fopen(TEMP_INVOICES_FILE, "wb");
-     if (!fp_temp) { fclose(fp_inv); return; }
- 
-     Invoice inv;
-     while(fread(&inv, sizeof(Invoice), 1, fp_inv) == 1) {
-         if (inv.id == invoiceId) {
-             inv.subtotal = subtotal;
-             inv.taxAmount = tax;
-             inv.discountAmount = discount;
-             inv.totalAmount = (subtotal + tax) - discount;
-             if (inv.totalAmount < 0) inv.totalAmount = 0;
-             inv.paidAmount = paid;
+     for (int i = 0; i < items->count; i++) {
+         BillingItem *item = tableRecord(items, i);
+         int slot = tableLookup(invoices, item->invoiceId);
+         if (item->isActive && slot >= 0) {
+             applyBillingItem(&expected[slot], item);
          }
-         fwrite(&inv, sizeof(Invoice), 1, fp_temp);
      }
      
-     fclose(fp_inv);
-     fclose(fp_temp);
-     remove(INVOICES_FILE);
-     rename(TEMP_INVOICES_FILE, INVOICES_FILE);
+     for (int i = 0; i < payments->count; i++) {
+         Payment *p = tableRecord(payments, i);
+         int slot = tableLookup(invoices, p->invoiceId);
+         if (p->isActive && p->status == PAYMENT_STATUS_COMPLETED && slot >= 0) {
+             expected[slot].paidAmount += p->amount;
+         }
+     }
+     return expected;
  }
  
- /* Calculate the total amount paid for an invoice */
- static double calculateInvoicePaid(int invoiceId) {
-     double total = 0.0;
-     FILE *fp = fopen(PAYMENTS_FILE, "rb");
-     if (fp) {
-         Payment p;
-         while(fread(&p, sizeof(Payment), 1, fp) == 1) {
-             if (p.invoiceId == invoiceId && p.isActive && p.status == PAYMENT_STATUS_COMPLETED) {
-                 total += p.amount;
+ /* Recompute all invoice totals from items and payments and report differences */
+ int verifyInvoiceTotals(User *currentUser) {
+     Table *invoices = getTable(TABLE_INVOICES);
+     Invoice *expected;
+     int mismatches = 0;
+     char confirm;
+     
+     if (currentUser->role != ROLE_ADMIN) {
+         printf("\nAccess denied. Admin privileges required.\n");
+         return 0;
+     }
+     
+     expected = expectedTotals();
+     if (expected == NULL) {
+         return 0;
+     }
+     
+     printf("\n%-5s %-12s %-12s %-12s %-12s\n", "ID", "Total", "Exp. Total", "Paid", "Exp. Paid");
+     printf("------------------------------------------------------------\n");
+     for (int slot = 0; slot < invoices->count; slot++) {
+         Invoice *inv = tableRecord(invoices, slot);
+         if (inv->isActive &&
+             totalsDiffer(inv, &expected[slot])) {
+             printf("%-5d $%-11.2f $%-11.2f $%-11.2f $%-11.2f\n", inv->id,
+                    inv->totalAmount, expected[slot].totalAmount,
+                    inv->paidAmount, expected[slot].paidAmount);
+             mismatches++;
+         }
+     }
+     printf("------------------------------------------------------------\n");
+     
+     if (mismatches == 0) {
+         printf("All invoice totals are consistent.\n");
+         free(expected);
+         return 1;
+     }
+     
+     printf("%d invoice(s) have inconsistent totals. Correct them? (y/n): ", mismatches);
+     scanf(" %c", &confirm);
+     if (confirm == 'y' || confirm == 'Y') {
+         // Recompute under the locks; other terminals may have billed meanwhile
+         free(expected);
+         walBegin();
+         if (!lockTable(TABLE_INVOICES) || !lockAppend(TABLE_BILLING_ITEMS) ||
+             !lockAppend(TABLE_PAYMENTS) || (expected = expectedTotals()) == NULL) {
+             walAbort();
+             return 0;
+         }
+         for (int slot = 0; slot < invoices->count; slot++) {
+             Invoice *inv = tableRecord(invoices, slot);
+             if (inv->isActive &&
+                 totalsDiffer(inv, &expected[slot])) {
+                 inv->subtotal = expected[slot].subtotal;
+                 inv->taxAmount = expected[slot].taxAmount;
+                 inv->discountAmount = expected[slot].discountAmount;
+                 inv->totalAmount = expected[slot].totalAmount;
+                 inv->paidAmount = expected[slot].paidAmount;
+                 if (!tableWriteRecord(invoices, slot)) {
+                     printf("\nError opening invoices file.\n");
+                     walAbort();
+                     free(expected);
+                     return 0;
+                 }
              }
          }
-         fclose(fp);
+         if (!walCommit()) {
+             free(expected);
+             return 0;
+         }
+         printf("Invoice totals corrected.\n");
      }
-     return total;
+     
+     free(expected);
+     return mismatches;
  }
  
  /* List invoices with optional status filter */
  void listInvoices(User *currentUser, int statusFilter) {
-     FILE *fp = fopen(INVOICES_FILE, "rb");
-     if (!fp) {
-         printf("\nNo invoices found or error opening file.\n");
-         return;
-     }
+     Table *invoices = getTable(TABLE_INVOICES);
+     char issueDate[DATE_STRING_LEN], dueDate[DATE_STRING_LEN];
      
      clearScreen();
      printf("===== INVOICE LIST =====\n");
@@ -350,128 +494,168 @@
             "ID", "Guest ID", "Resv. ID", "Issue Date", "Due Date", "Status", "Paid", "Total");
      printf("--------------------------------------------------------------------------------------------------\n");
      
-     Invoice inv;
      int count = 0;
-     while (fread(&inv, sizeof(Invoice), 1, fp) == 1) {
+     Invoice *all = TABLE_RECORDS(invoices, Invoice);
+     for (int i = 0; i < invoices->count; i++) {
+         Invoice *inv = &all[i];
          // statusFilter -1 means no filter
-         if (inv.isActive && (statusFilter == -1 || inv.status == statusFilter)) {
+         if (inv->isActive && (statusFilter == -1 || inv->status == statusFilter)) {
+             dateToString(inv->issueDate, issueDate);
+             dateToString(inv->dueDate, dueDate);
              printf("%-5d %-10d %-10d %-12s %-12s %-15s $%-11.2f $%-11.2f\n", 
-                    inv.id, inv.guestId, inv.reservationId, inv.issueDate, inv.dueDate,
-                    getInvoiceStatusString(inv.status), inv.paidAmount, inv.totalAmount);
+                    inv->id, inv->guestId, inv->reservationId, issueDate, dueDate,
+                    getInvoiceStatusString(inv->status), inv->paidAmount, inv->totalAmount);
              count++;
          }
      }
-     fclose(fp);
      printf("--------------------------------------------------------------------------------------------------\n");
      printf("Total invoices found: %d\n", count);
  }
  
+ /* Find the table slot of an active invoice, or -1 if there is none */
+ static int findInvoiceSlot(int invoiceId) {
+     Table *invoices = getTable(TABLE_INVOICES);
+     int slot = tableLookup(invoices, invoiceId);
+     
+     if (slot < 0 || !((Invoice *)tableRecord(invoices, slot))->isActive) {
+         return -1;
+     }
+     return slot;
+ }
+ 
  /* Get invoice by ID */
  int getInvoiceById(int invoiceId, Invoice *invoice) {
-     FILE *fp = fopen(INVOICES_FILE, "rb");
-     if (!fp) return 0;
-     
-     int found = 0;
-     Invoice temp;
-     while (fread(&temp, sizeof(Invoice), 1, fp) == 1) {
-         if (temp.id == invoiceId && temp.isActive) {
-             *invoice = temp;
-             found = 1;
-             break;
-         }
-     }
-     fclose(fp);
-     return found;
+     int slot = findInvoiceSlot(invoiceId);
+     if (slot < 0) return 0;
+     
+     *invoice = *(Invoice *)tableRecord(getTable(TABLE_INVOICES), slot);
+     return 1;
  }
  
  /* Get invoice by reservation ID */
  int getInvoiceByReservationId(int reservationId, Invoice *invoice) {
-     FILE *fp = fopen(INVOICES_FILE, "rb");
-     if (!fp) return 0;
-     
-     int found = 0;
-     Invoice temp;
-     while (fread(&temp, sizeof(Invoice), 1, fp) == 1) {
-         if (temp.reservationId == reservationId && temp.isActive) {
-             *invoice = temp;
-             found = 1;
-             break;
+     Table *invoices = getTable(TABLE_INVOICES);
+     
+     for (int i = indexFirst(INDEX_INVOICE_RESERVATION, reservationId); i >= 0;
+          i = indexNext(INDEX_INVOICE_RESERVATION, i)) {
+         Invoice *temp = tableRecord(invoices, i);
+         if (temp->isActive) {
+             *invoice = *temp;
+             return 1;
          }
      }
-     fclose(fp);
-     return found;
+     return 0;
+ }
+ 
+ /* Check whether a reservation has been invoiced and every invoice for it is paid */
+ int isReservationSettled(int reservationId) {
+     Table *invoices = getTable(TABLE_INVOICES);
+     int invoiced = 0;
+     
+     for (int i = indexFirst(INDEX_INVOICE_RESERVATION, reservationId); i >= 0;
+          i = indexNext(INDEX_INVOICE_RESERVATION, i)) {
+         Invoice *temp = tableRecord(invoices, i);
+         if (!temp->isActive || temp->status == INVOICE_STATUS_CANCELLED) {
+             continue;
+         }
+         if (temp->status != INVOICE_STATUS_PAID) {
+             return 0;
+         }
+         invoiced = 1;
+     }
+     return invoiced;
  }
  
  /* Mark an invoice as paid */
  int markInvoiceAsPaid(User *currentUser, int invoiceId) {
-     Invoice inv;
-     if (!getInvoiceById(invoiceId, &inv)) {
+     Table *invoices = getTable(TABLE_INVOICES);
+     int slot;
+     
+     walBegin();
+     if (!lockRecord(TABLE_INVOICES, invoiceId)) {
+         walAbort();
+         return 0;
+     }
+     
+     slot = findInvoiceSlot(invoiceId);
+     if (slot < 0) {
          printf("\nError: Invoice not found.\n");
+         walAbort();
          return 0;
      }
      
-     if (inv.status != INVOICE_STATUS_ISSUED && inv.status != INVOICE_STATUS_OVERDUE) {
+     Invoice *inv = tableRecord(invoices, slot);
+     if (inv->status != INVOICE_STATUS_ISSUED && inv->status != INVOICE_STATUS_OVERDUE) {
          printf("\nError: Only Issued or Overdue invoices can be marked as paid.\n");
+         walAbort();
          return 0;
      }
      
-     if (inv.paidAmount < inv.totalAmount) {
-         printf("\nWarning: Invoice not fully paid (Balance: $%.2f).", inv.totalAmount - inv.paidAmount);
+     if (inv->paidAmount < inv->totalAmount) {
+         printf("\nWarning: Invoice not fully paid (Balance: $%.2f).", inv->totalAmount - inv->paidAmount);
          char choice;
          printf("\nMark as paid anyway? (y/n): ");
          scanf(" %c", &choice);
          if (choice != 'y' && choice != 'Y') {
              printf("Operation cancelled.\n");
+             walAbort();
              return 0;
          }
      }
      
-     FILE *fp = fopen(INVOICES_FILE, "rb+");
-     if (!fp) {
+     inv->status = INVOICE_STATUS_PAID;
+     if (!tableWriteRecord(invoices, slot)) {
          printf("\nError opening invoices file.\n");
+         walAbort();
          return 0;
      }
      
-     int found = 0;
-     while (fread(&inv, sizeof(Invoice), 1, fp) == 1) {
-         if (inv.id == invoiceId) {
-             fseek(fp, -sizeof(Invoice), SEEK_CUR);
-             inv.status = INVOICE_STATUS_PAID;
-             fwrite(&inv, sizeof(Invoice), 1, fp);
-             found = 1;
-             break;
-         }
+     if (!updateGuestStayInfo(inv->guestId, inv->totalAmount)) {
+         walAbort();
+         return 0;
      }
-     fclose(fp);
-     
-     if (found) {
-         printf("\nInvoice #%d marked as PAID.\n", invoiceId);
-         updateGuestStayInfo(inv.guestId, inv.totalAmount);
+     if (!walCommit()) {
+         return 0;
      }
-     return found;
+     printf("\nInvoice #%d marked as PAID.\n", invoiceId);
+     return 1;
  }
  
  
- /* Check for overdue invoices and update their status */
- int checkOverdueInvoices(void) {
-     FILE *fp = fopen(INVOICES_FILE, "rb+");
-     if (!fp) return 0;
- 
+ /* Mark issued invoices past their due date as of a day as overdue; -1 on failure */
+ int checkOverdueInvoices(Date today) {
+     Table *invoices = getTable(TABLE_INVOICES);
      int count = 0;
-     char currentDate[11];
-     getCurrentDate(currentDate);
- 
-     Invoice inv;
-     while (fread(&inv, sizeof(Invoice), 1, fp) == 1) {
-         if (inv.isActive && inv.status == INVOICE_STATUS_ISSUED && strcmp(currentDate, inv.dueDate) > 0) {
-             inv.status = INVOICE_STATUS_OVERDUE;
-             fseek(fp, -sizeof(Invoice), SEEK_CUR);
-             fwrite(&inv, sizeof(Invoice), 1, fp);
-             fseek(fp, 0, SEEK_CUR); // Reset stream state
-             count++;
+ 
+     walBegin();
+     for (int i = 0; i < invoices->count; i++) {
+         Invoice *inv = tableRecord(invoices, i);
+         if (inv->isActive && inv->status == INVOICE_STATUS_ISSUED && today > inv->dueDate) {
+             // Another terminal may have taken a payment since the table was read
+             int id = inv->id;
+             if (!lockRecord(TABLE_INVOICES, id)) {
+                 walAbort();
+                 return -1;
+             }
+             int slot = findInvoiceSlot(id);
+             if (slot < 0) {
+                 continue;
+             }
+             inv = tableRecord(invoices, slot);
+             if (inv->status == INVOICE_STATUS_ISSUED) {
+                 inv->status = INVOICE_STATUS_OVERDUE;
+                 if (!tableWriteRecord(invoices, slot)) {
+                     walAbort();
+                     return -1;
+                 }
+                 count++;
+             }
          }
      }
-     fclose(fp);
+     if (!walCommit()) {
+         return -1;
+     }
+     
      return count;
  }
  
@@ -484,11 +668,7 @@
          return;
      }
      
-     FILE *fp = fopen(BILLING_ITEMS_FILE, "rb");
-     if (!fp) {
-         printf("\nError opening billing items file.\n");
-         return;
-     }
+     Table *items = getTable(TABLE_BILLING_ITEMS);
      
      clearScreen();
      printf("===== BILLING ITEMS FOR INVOICE #%d =====\n", invoiceId);
@@ -498,17 +678,17 @@
             "ID", "Description", "Type", "Unit Price", "Quantity", "Amount");
      printf("------------------------------------------------------------------------------------------\n");
      
-     BillingItem item;
      int count = 0;
-     while (fread(&item, sizeof(BillingItem), 1, fp) == 1) {
-         if (item.invoiceId == invoiceId && item.isActive) {
+     for (int i = indexFirst(INDEX_ITEM_INVOICE, invoiceId); i >= 0;
+          i = indexNext(INDEX_ITEM_INVOICE, i)) {
+         BillingItem *item = tableRecord(items, i);
+         if (item->isActive) {
              printf("%-5d %-30s %-15s $%-11.2f %-10d $%-11.2f\n", 
-                    item.id, item.description, getBillingItemTypeString(item.type),
-                    item.unitPrice, item.quantity, item.amount);
+                    item->id, item->description, getBillingItemTypeString(item->type),
+                    item->unitPrice, item->quantity, item->amount);
              count++;
          }
      }
-     fclose(fp);
      
      printf("------------------------------------------------------------------------------------------\n");
      printf("Subtotal: $%.2f | Tax: $%.2f | Discount: $%.2f\n", 
@@ -525,11 +705,9 @@
          return;
      }
  
-     FILE *fp = fopen(PAYMENTS_FILE, "rb");
-     if (!fp) {
-         printf("\nError opening payments file.\n");
-         return;
-     }
+     Table *payments = getTable(TABLE_PAYMENTS);
+     char transactionDate[DATE_STRING_LEN];
+     char transactionId[MAX_PAYMENT_REF_LEN];
  
      clearScreen();
      printf("===== PAYMENTS FOR INVOICE #%d =====\n", invoiceId);
@@ -538,15 +716,17 @@
             "ID", "Date", "Method", "Amount", "Transaction ID", "Status");
      printf("----------------------------------------------------------------------------------\n");
  
-     Payment p;
-     while (fread(&p, sizeof(Payment), 1, fp) == 1) {
-         if (p.invoiceId == invoiceId && p.isActive) {
+     for (int i = indexFirst(INDEX_PAYMENT_INVOICE, invoiceId); i >= 0;
+          i = indexNext(INDEX_PAYMENT_INVOICE, i)) {
+         Payment *p = tableRecord(payments, i);
+         if (p->isActive) {
+             dateToString(p->transactionDate, transactionDate);
              printf("%-5d %-12s %-15s $%-11.2f %-20s %-15s\n", 
-                    p.id, p.transactionDate, getPaymentMethodString(p.method),
-                    p.amount, p.transactionId, getPaymentStatusString(p.status));
+                    p->id, transactionDate, getPaymentMethodString(p->method),
+                    p->amount, getText(p->transactionId, transactionId, sizeof(transactionId)),
+                    getPaymentStatusString(p->status));
          }
      }
-     fclose(fp);
      printf("----------------------------------------------------------------------------------\n");
  }
  
@@ -562,6 +742,7 @@
       int choice, invoiceId, reservationId;
       
       do {
+          refreshTables();
           clearScreen();
           printf("===== BILLING MANAGEMENT =====\n");
           printf("1. List All Invoices\n");
@@ -571,10 +752,11 @@
           printf("5. Record Payment for Invoice\n");
           printf("6. Mark Invoice as Paid\n");
           printf("7. Check for Overdue Invoices\n");
+          printf("8. Verify Invoice Totals (Admin only)\n");
           printf("0. Back to Main Menu\n");
           printf("================================\n");
           
-          choice = getIntInput("Enter your choice: ", 0, 7);
+          choice = getIntInput("Enter your choice: ", 0, 8);
           
           switch (choice) {
               case 1:
@@ -637,8 +819,14 @@
                  break;
              case 7:
                  printf("\nChecking for overdue invoices...\n");
-                 int count = checkOverdueInvoices();
-                 printf("%d invoice(s) updated to 'Overdue' status.\n", count);
+                 int count = checkOverdueInvoices(getCurrentDay());
+                 if (count >= 0) {
+                     printf("%d invoice(s) updated to 'Overdue' status.\n", count);
+                 }
+                 break;
+             case 8:
+                 printf("\nRecomputing invoice totals from items and payments...\n");
+                 verifyInvoiceTotals(currentUser);
                  break;
               case 0:
                   return;
@@ -2,6 +2,9 @@
 #define BILLING_H
 
 #include "auth.h" // For User type
+#include "utils.h" // For Date type
+#include "reservation.h" // For Reservation type
+#include "textheap.h" // For TextRef type
 
 /* Invoice status definitions */
 typedef enum {
@@ -46,6 +49,9 @@ typedef enum {
 #define MAX_NOTES_LEN 200
 #define MAX_BILLING_DESCRIPTION_LEN 100
 
+/* Tax charged on room nights posted by the night audit */
+#define ROOM_TAX_RATE 0.10
+
 /* File paths */
 #define INVOICES_FILE "data/invoices.dat"
 #define BILLING_ITEMS_FILE "data/billing_items.dat"
@@ -60,6 +66,7 @@ typedef struct {
     double unitPrice;
     int quantity;
     double amount; // unitPrice * quantity
+    Date serviceDate;        /* Day the item was posted for (days since 1970-01-01) */
     int isActive;
 } BillingItem;
 
@@ -68,15 +75,15 @@ typedef struct {
     int id;
     int guestId;
     int reservationId;
-    char issueDate[11];      /* YYYY-MM-DD */
-    char dueDate[11];        /* YYYY-MM-DD */
+    Date issueDate;          /* Days since 1970-01-01 */
+    Date dueDate;            /* Days since 1970-01-01 */
     double subtotal;
     double taxAmount;
     double discountAmount;
     double totalAmount;
     double paidAmount;
     InvoiceStatus status;
-    char notes[MAX_NOTES_LEN];
+    TextRef notes;
     int createdBy;
     int isActive;
 } Invoice;
@@ -88,9 +95,9 @@ typedef struct {
     PaymentMethod method;
     PaymentStatus status;
     double amount;
-    char transactionDate[11]; /* YYYY-MM-DD */
-    char transactionId[MAX_PAYMENT_REF_LEN];
-    char notes[MAX_NOTES_LEN];
+    Date transactionDate;     /* Days since 1970-01-01 */
+    TextRef transactionId;
+    TextRef notes;
     int createdBy;
     int isActive;
 } Payment;
@@ -102,6 +109,7 @@ const char* getPaymentStatusString(PaymentStatus status);
 const char* getBillingItemTypeString(BillingItemType type);
 int initializeBillingData(void);
 int createInvoice(User *currentUser, int reservationId);
+int openInvoice(User *currentUser, const Reservation *reservation);
 int modifyInvoice(User *currentUser, int invoiceId);
 int cancelInvoice(User *currentUser, int invoiceId);
 int issueInvoice(User *currentUser, int invoiceId);
@@ -110,11 +118,14 @@ void listInvoices(User *currentUser, int statusFilter);
 void searchInvoices(User *currentUser);
 int getInvoiceById(int invoiceId, Invoice *invoice);
 int getInvoiceByReservationId(int reservationId, Invoice *invoice);
+int isReservationSettled(int reservationId);
 int addBillingItem(User *currentUser, int invoiceId, BillingItemType type, const char *description, double unitPrice, int quantity);
+int postBillingItem(int invoiceSlot, BillingItemType type, const char *description, double unitPrice, int quantity, Date serviceDate);
 void listBillingItems(User *currentUser, int invoiceId);
 int recordPayment(User *currentUser, int invoiceId, PaymentMethod method, double amount, const char *transactionId, const char *notes);
 void listPayments(User *currentUser, int invoiceId);
-int checkOverdueInvoices(void);
+int checkOverdueInvoices(Date today);
+int verifyInvoiceTotals(User *currentUser);
 void billingManagementMenu(User *currentUser);
 
 #endif /* BILLING_H */
\ No newline at end of file
@@ -0,0 +1,52 @@
+/**
+ * Hotel Management System
+ * datafile.c - Data file header implementation
+ *
+ * This file implements the data file header. The checksum is FNV-1a
+ * over the bytes of the fields before it.
+ */
+
+#include <string.h>
+#include "datafile.h"
+#include "migrate.h"
+
+/* Compute the checksum of a header's fields */
+static unsigned int headerChecksum(const DataHeader *header) {
+    const unsigned char *bytes = (const unsigned char *)header;
+    unsigned int h = 2166136261u;
+
+    for (size_t i = 0; i < offsetof(DataHeader, checksum); i++) {
+        h ^= bytes[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Fill in a header for records of the current format version */
+void initDataHeader(DataHeader *header, size_t recordSize, int count, int nextId) {
+    initVersionedHeader(header, CURRENT_FORMAT_VERSION, recordSize, count, nextId);
+}
+
+/* Fill in a header for records of a given format version */
+void initVersionedHeader(DataHeader *header, int version, size_t recordSize, int count, int nextId) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, DATA_MAGIC, sizeof(header->magic));
+    header->schemaVersion = version;
+    header->recordSize = (int)recordSize;
+    header->count = count;
+    header->nextId = nextId;
+    header->checksum = headerChecksum(header);
+}
+
+/* Check a header's magic bytes and checksum */
+int dataHeaderValid(const DataHeader *header) {
+    return memcmp(header->magic, DATA_MAGIC, sizeof(header->magic)) == 0 &&
+           header->checksum == headerChecksum(header);
+}
+
+/* Read the header at the start of an open data file */
+int readDataHeader(FILE *fp, DataHeader *header) {
+    return fseek(fp, 0, SEEK_SET) == 0 &&
+           fread(header, sizeof(*header), 1, fp) == 1 &&
+           dataHeaderValid(header);
+}
@@ -0,0 +1,72 @@
+/**
+ * Hotel Management System
+ * datafile.h - Data file header
+ *
+ * This file contains declarations for the header at the start of every
+ * data file. It records the format version the records are laid out
+ * in, their size and number, and the id for the next record, so a
+ * loader learns the count without scanning the file and refuses a file
+ * it would misread instead of loading garbage. A checksum over the
+ * header's own fields catches a damaged or foreign header.
+ */
+
+#ifndef DATAFILE_H
+#define DATAFILE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* Bytes identifying a data file */
+#define DATA_MAGIC "HMSD"
+
+/* Data file header structure */
+typedef struct {
+    char magic[4];              /* DATA_MAGIC, without its NUL */
+    int schemaVersion;          /* Format version of the records (see migrate.h) */
+    int recordSize;             /* Size of one record in bytes */
+    int count;                  /* Number of records following the header */
+    int nextId;                 /* Id for the next record added */
+    unsigned int checksum;      /* Checksum of the fields above */
+} DataHeader;
+
+/**
+ * Fill in a header for records of the current format version
+ *
+ * @param header Header to fill in
+ * @param recordSize Size of one record in bytes
+ * @param count Number of records in the file
+ * @param nextId Id for the next record added
+ */
+void initDataHeader(DataHeader *header, size_t recordSize, int count, int nextId);
+
+/**
+ * Fill in a header for records of a given format version
+ *
+ * Used by migrations, which write files in each intermediate version.
+ *
+ * @param header Header to fill in
+ * @param version Format version of the records
+ * @param recordSize Size of one record in bytes
+ * @param count Number of records in the file
+ * @param nextId Id for the next record added
+ */
+void initVersionedHeader(DataHeader *header, int version, size_t recordSize, int count, int nextId);
+
+/**
+ * Check a header's magic bytes and checksum
+ *
+ * @param header Header to check
+ * @return 1 if the header is intact, 0 otherwise
+ */
+int dataHeaderValid(const DataHeader *header);
+
+/**
+ * Read the header at the start of an open data file
+ *
+ * @param fp File to read from; left positioned after the header
+ * @param header Header to fill in
+ * @return 1 if an intact header was read, 0 otherwise
+ */
+int readDataHeader(FILE *fp, DataHeader *header);
+
+#endif /* DATAFILE_H */
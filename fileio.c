@@ -26,6 +26,16 @@
  #include "guest.h"
  #include "reservation.h"
  #include "billing.h"
+ #include "audit.h"
+ #include "table.h"
+ #include "migrate.h"
+ #include "wal.h"
+ #include "lock.h"
+ #include "server.h"
+ #include "guestindex.h"
+ #include "availability.h"
+ #include "occupancy.h"
+ #include "textheap.h"
  
  /**
   * Create a directory if it doesn't exist
@@ -96,11 +106,25 @@
  * Initialize all data files for the system
  */
 int initializeDataFiles(void) {
+    /* While a server runs it owns the data files; only fetch the tables */
+    if (serverConnected() || connectServer()) {
+        printf("Connected to the server at %s.\n", SERVER_SOCKET);
+        if (!attachLocking()) return 0;
+        for (int i = 0; i < TABLE_COUNT; i++) {
+            if (!loadTable((TableId)i)) return 0;
+        }
+        return buildGuestIndex() && buildAvailability();
+    }
+    if (!initializeLocking()) return 0;
+    if (!migrateDataFiles()) return 0;
+    if (!walRecover()) return 0;
+    if (!initializeTextData()) return 0;
     if (!initializeUserData()) return 0;
     if (!initializeRoomData()) return 0;
     if (!initializeGuestData()) return 0;
     if (!initializeReservationData()) return 0;
     if (!initializeBillingData()) return 0;
+    if (!initializeAuditData()) return 0;
     return 1;
 }
 
@@ -117,6 +141,9 @@ int loadConfiguration(void) {
  */
 int backupDataFiles(const char *backupDir) {
     createDirectoryIfNotExists(backupDir);
+
+    /* Bring the data files up to date with the log before copying them */
+    if (!walCheckpoint()) return 0;
     
     int success = 1;
     if (!backupFile(USERS_FILE, backupDir)) success = 0;
@@ -126,6 +153,64 @@ int backupDataFiles(const char *backupDir) {
     if (!backupFile(INVOICES_FILE, backupDir)) success = 0;
     if (!backupFile(BILLING_ITEMS_FILE, backupDir)) success = 0;
     if (!backupFile(PAYMENTS_FILE, backupDir)) success = 0;
+    if (!backupFile(AUDITS_FILE, backupDir)) success = 0;
+    if (!backupFile(TEXTS_FILE, backupDir)) success = 0;
 
     return success;
-}
\ No newline at end of file
+}
+
+/**
+ * Drop deleted records from every data file
+ */
+int compactDataFiles(void) {
+    long reclaimed = 0;
+    int ok;
+
+    /* A rewrite must not overtake changes that are not yet committed */
+    if (walInTransaction()) {
+        printf("\nError: Data files cannot be compacted inside a transaction.\n");
+        return 0;
+    }
+
+    /* Rooms and guests deleted before their texts were released on
+       deletion still hold them; the text heap is compacted last, so
+       their blocks go too */
+    walBegin();
+    ok = lockTable(TABLE_ROOMS) && lockTable(TABLE_GUESTS) &&
+         releaseDeletedRoomTexts() && releaseDeletedGuestTexts();
+    if (ok) {
+        ok = walCommit();
+    } else {
+        walAbort();
+    }
+
+    /* One table at a time, so other terminals can use the rest meanwhile */
+    for (int i = 0; ok && i < TABLE_COUNT; i++) {
+        Table *table = getTable((TableId)i);
+        int dropped;
+
+        if (!lockTable((TableId)i)) {
+            ok = 0;
+            break;
+        }
+        dropped = tableCompact(table);
+        releaseLocks();
+        if (dropped < 0) {
+            ok = 0;
+            break;
+        }
+        if (dropped > 0) {
+            printf("%-26s %6d record(s) %10ld bytes\n", table->path, dropped,
+                   (long)dropped * (long)table->recordSize);
+            reclaimed += (long)dropped * (long)table->recordSize;
+        }
+    }
+
+    /* Room and guest slots have moved */
+    invalidateGuestIndex();
+    invalidateAvailability();
+    invalidateOccupancy();
+
+    printf("Reclaimed %ld bytes.\n", reclaimed);
+    return ok;
+}
@@ -56,4 +56,14 @@ int loadConfiguration(void);
  */
 int backupDataFiles(const char *backupDir);
 
+/**
+ * Drop deleted records from every data file
+ *
+ * Each table is locked only while it is rewritten. Prints the records
+ * and bytes reclaimed per file. Must not be called inside a transaction.
+ *
+ * @return 1 if successful, 0 if any file could not be compacted
+ */
+int compactDataFiles(void);
+
 #endif /* FILEIO_H */
@@ -16,8 +16,18 @@
  #include "fileio.h"
  #include "utils.h"
  #include "ui.h"
+ #include "table.h"
+ #include "guestindex.h"
+ #include "wal.h"
+ #include "lock.h"
+ #include "textheap.h"
  
- #define TEMP_FILE "data/temp_guests.dat"
+ /* Forward declarations for static functions */
+ static int findGuestSlot(int guestId);
+ static int insertGuest(Guest *guest, const char *address, const char *idType, const char *notes);
+ static int editGuest(int guestId);
+ static int removeGuest(User *currentUser, int guestId);
+ static int addStay(int guestId, double amountSpent);
  
  /* Get the string representation of a VIP status */
  const char* getVipStatusString(VipStatus status) {
@@ -40,7 +50,7 @@
          fseek(fp, 0, SEEK_END);
          if (ftell(fp) > 0) {
              fclose(fp);
-             return 1;
+             return loadTable(TABLE_GUESTS) && buildGuestIndex();
          }
          fclose(fp);
      }
@@ -52,36 +62,24 @@
          return 0;
      }
      fclose(fp);
-     return 1;
+     return loadTable(TABLE_GUESTS) && buildGuestIndex();
  }
  
  /* Add a new guest */
  int addGuest(void) {
-     FILE *fp;
      Guest newGuest;
-     int nextId = 1;
- 
-     fp = fopen(GUESTS_FILE, "rb");
-     if (fp != NULL) {
-         Guest tempGuest;
-         while (fread(&tempGuest, sizeof(Guest), 1, fp) == 1) {
-             if (tempGuest.id >= nextId) {
-                 nextId = tempGuest.id + 1;
-             }
-         }
-         fclose(fp);
-     }
+     char address[MAX_ADDRESS_LEN];
+     char idType[MAX_ID_TYPE_LEN];
+     char notes[MAX_NOTES_LEN];
      
      clearScreen();
      printf("===== ADD NEW GUEST =====\n");
      
-     newGuest.id = nextId;
-     
      printf("Full Name: ");
      getStringInput(NULL, newGuest.name, MAX_GUEST_NAME_LEN);
      
      printf("Address: ");
-     getStringInput(NULL, newGuest.address, MAX_ADDRESS_LEN);
+     getStringInput(NULL, address, MAX_ADDRESS_LEN);
      
      printf("Phone Number: ");
      getStringInput(NULL, newGuest.phone, MAX_PHONE_LEN);
@@ -90,93 +88,134 @@
      getStringInput(NULL, newGuest.email, MAX_EMAIL_LEN);
      
      printf("ID Type (e.g., Passport, License): ");
-     getStringInput(NULL, newGuest.idType, MAX_ID_TYPE_LEN);
+     getStringInput(NULL, idType, MAX_ID_TYPE_LEN);
      
      printf("ID Number: ");
      getStringInput(NULL, newGuest.idNumber, MAX_ID_NUMBER_LEN);
      
      printf("Notes (optional): ");
-     getStringInput(NULL, newGuest.notes, MAX_NOTES_LEN);
-     
-     getCurrentDate(newGuest.registrationDate);
-     newGuest.totalStays = 0;
-     newGuest.totalSpent = 0.0;
-     newGuest.isActive = 1;
-     newGuest.vipStatus = VIP_STATUS_REGULAR;
+     getStringInput(NULL, notes, MAX_NOTES_LEN);
      
-     fp = fopen(GUESTS_FILE, "ab");
-     if (fp == NULL) {
+     return createGuest(&newGuest, address, idType, notes);
+ }
+ 
+ /* Register a guest whose contact details are already filled in */
+ int createGuest(Guest *guest, const char *address, const char *idType, const char *notes) {
+     int id;
+     
+     walBegin();
+     id = lockAppend(TABLE_GUESTS) ? insertGuest(guest, address, idType, notes) : 0;
+     if (id == 0) {
+         walAbort();
+         return 0;
+     }
+     return walCommit() ? id : 0;
+ }
+ 
+ /* Append a guest with the guests table locked against appends */
+ static int insertGuest(Guest *guest, const char *address, const char *idType, const char *notes) {
+     Table *guests = getTable(TABLE_GUESTS);
+     int slot;
+     
+     guest->id = tableNextId(guests);
+     getCurrentDate(guest->registrationDate);
+     guest->totalStays = 0;
+     guest->totalSpent = 0.0;
+     guest->isActive = 1;
+     guest->vipStatus = VIP_STATUS_REGULAR;
+     guest->address = storeText(address);
+     guest->idType = storeText(idType);
+     guest->notes = storeText(notes);
+     
+     slot = guest->address < 0 || guest->idType < 0 || guest->notes < 0 ? -1 : tableInsert(guests, guest);
+     if (slot < 0) {
          printf("\nError: Could not open guests file for writing.\n");
          return 0;
      }
+     guestIndexUpdate(slot, NULL, guest);
      
-     fwrite(&newGuest, sizeof(Guest), 1, fp);
-     fclose(fp);
-     
-     printf("\nGuest '%s' added successfully with ID: %d\n", newGuest.name, newGuest.id);
-     return newGuest.id;
+     printf("\nGuest '%s' added successfully with ID: %d\n", guest->name, guest->id);
+     return guest->id;
  }
  
  /* Modify an existing guest */
  int modifyGuest(User *currentUser, int guestId) {
-     FILE *fp, *tempFp;
-     Guest tempGuest;
-     int found = 0;
- 
-     fp = fopen(GUESTS_FILE, "rb");
-     if (!fp) {
-         printf("\nError: Could not open guests file.\n");
+     int ok;
+     
+     /* Other terminals wait for the guest until the change commits */
+     walBegin();
+     ok = lockRecord(TABLE_GUESTS, guestId) && editGuest(guestId);
+     if (!ok) {
+         walAbort();
          return 0;
      }
-     
-     tempFp = fopen(TEMP_FILE, "wb");
-     if (!tempFp) {
-         fclose(fp);
-         printf("\nError: Could not create temporary file.\n");
+     return walCommit();
+ }
+ 
+ /* Modify a guest once it is locked */
+ static int editGuest(int guestId) {
+     Table *guests;
+     Guest *guest;
+     char address[MAX_ADDRESS_LEN];
+     char notes[MAX_NOTES_LEN];
+     int slot;
+ 
+     slot = findGuestSlot(guestId);
+     if (slot < 0) {
+         printf("\nGuest with ID %d not found.\n", guestId);
          return 0;
      }
      
-     while (fread(&tempGuest, sizeof(Guest), 1, fp) == 1) {
-         if (tempGuest.id == guestId && tempGuest.isActive) {
-             found = 1;
-             clearScreen();
-             printf("===== MODIFYING GUEST: %s (ID: %d) =====\n", tempGuest.name, tempGuest.id);
-             printf("\n-- Contact Information --\n");
-             printf("Current Address: %s\nEnter new address: ", tempGuest.address);
-             getStringInput(NULL, tempGuest.address, MAX_ADDRESS_LEN);
+     guests = getTable(TABLE_GUESTS);
+     guest = tableRecord(guests, slot);
+     Guest before = *guest;
+     
+     clearScreen();
+     printf("===== MODIFYING GUEST: %s (ID: %d) =====\n", guest->name, guest->id);
+     printf("\n-- Contact Information --\n");
+     printf("Current Address: %s\nEnter new address: ", getText(guest->address, address, sizeof(address)));
+     getStringInput(NULL, address, MAX_ADDRESS_LEN);
  
-             printf("Current Phone: %s\nEnter new phone: ", tempGuest.phone);
-             getStringInput(NULL, tempGuest.phone, MAX_PHONE_LEN);
+     printf("Current Phone: %s\nEnter new phone: ", guest->phone);
+     getStringInput(NULL, guest->phone, MAX_PHONE_LEN);
  
-             printf("Current Email: %s\nEnter new email: ", tempGuest.email);
-             getStringInput(NULL, tempGuest.email, MAX_EMAIL_LEN);
+     printf("Current Email: %s\nEnter new email: ", guest->email);
+     getStringInput(NULL, guest->email, MAX_EMAIL_LEN);
  
-             printf("\n-- Notes --\n");
-             printf("Current Notes: %s\nEnter new notes: ", tempGuest.notes);
-             getStringInput(NULL, tempGuest.notes, MAX_NOTES_LEN);
-         }
-         fwrite(&tempGuest, sizeof(Guest), 1, tempFp);
-     }
-     
-     fclose(fp);
-     fclose(tempFp);
+     printf("\n-- Notes --\n");
+     printf("Current Notes: %s\nEnter new notes: ", getText(guest->notes, notes, sizeof(notes)));
+     getStringInput(NULL, notes, MAX_NOTES_LEN);
      
-     if (found) {
-         remove(GUESTS_FILE);
-         rename(TEMP_FILE, GUESTS_FILE);
-         printf("\nGuest information updated successfully.\n");
-     } else {
-         remove(TEMP_FILE);
-         printf("\nGuest with ID %d not found.\n", guestId);
+     if (!replaceText(&guest->address, address) || !replaceText(&guest->notes, notes) ||
+         !tableWriteRecord(guests, slot)) {
+         return 0;
      }
-     return found;
+     guestIndexUpdate(slot, &before, guest);
+     
+     printf("\nGuest information updated successfully.\n");
+     return 1;
  }
  
  /* "Delete" a guest by marking them inactive */
  int deleteGuest(User *currentUser, int guestId) {
-     FILE *fp, *tempFp;
-     Guest tempGuest;
-     int found = 0;
+     int ok;
+     
+     /* No reservation can be made for the guest while it is checked */
+     walBegin();
+     ok = lockRecord(TABLE_GUESTS, guestId) && lockAppend(TABLE_RESERVATIONS) &&
+          removeGuest(currentUser, guestId);
+     if (!ok) {
+         walAbort();
+         return 0;
+     }
+     return walCommit();
+ }
+ 
+ /* Mark a guest inactive once it and the reservations table are locked */
+ static int removeGuest(User *currentUser, int guestId) {
+     Table *guests;
+     Guest *guest;
+     int slot;
      char confirm;
      
      if (currentUser->role != ROLE_ADMIN) {
@@ -189,77 +228,78 @@
          return 0;
      }
      
-     fp = fopen(GUESTS_FILE, "rb");
-     if (!fp) {
-         printf("\nError: Could not open guests file.\n");
+     slot = findGuestSlot(guestId);
+     if (slot < 0) {
+         printf("\nGuest with ID %d not found.\n", guestId);
          return 0;
      }
      
-     tempFp = fopen(TEMP_FILE, "wb");
-     if (!tempFp) {
-         fclose(fp);
-         printf("\nError: Could not create temporary file.\n");
-         return 0;
+     guests = getTable(TABLE_GUESTS);
+     guest = tableRecord(guests, slot);
+     
+     printf("\nAre you sure you want to delete guest '%s'? (y/n): ", guest->name);
+     scanf(" %c", &confirm);
+     if (confirm == 'y' || confirm == 'Y') {
+         Guest before = *guest;
+         if (!releaseText(guest->address) || !releaseText(guest->idType) || !releaseText(guest->notes)) {
+             return 0;
+         }
+         guest->address = guest->idType = guest->notes = 0;
+         guest->isActive = 0;
+         if (!tableWriteRecord(guests, slot)) {
+             return 0;
+         }
+         guestIndexUpdate(slot, &before, guest);
+         printf("Guest has been marked as inactive.\n");
      }
+     return 1;
+ }
+
+ /* Release the texts still held by deleted guests (guests table locked) */
+ int releaseDeletedGuestTexts(void) {
+     Table *guests = getTable(TABLE_GUESTS);
  
-     while (fread(&tempGuest, sizeof(Guest), 1, fp) == 1) {
-         if (tempGuest.id == guestId && tempGuest.isActive) {
-             found = 1;
-             printf("\nAre you sure you want to delete guest '%s'? (y/n): ", tempGuest.name);
-             scanf(" %c", &confirm);
-             if (confirm == 'y' || confirm == 'Y') {
-                 tempGuest.isActive = 0;
-                 printf("Guest has been marked as inactive.\n");
-             }
+     for (int i = 0; i < guests->count; i++) {
+         Guest *guest = tableRecord(guests, i);
+ 
+         if (guest->isActive || (guest->address == 0 && guest->idType == 0 && guest->notes == 0)) {
+             continue;
+         }
+         if (!releaseText(guest->address) || !releaseText(guest->idType) || !releaseText(guest->notes)) {
+             return 0;
+         }
+         guest->address = guest->idType = guest->notes = 0;
+         if (!tableWriteRecord(guests, i)) {
+             return 0;
          }
-         fwrite(&tempGuest, sizeof(Guest), 1, tempFp);
-     }
-     
-     fclose(fp);
-     fclose(tempFp);
-     
-     if (found) {
-         remove(GUESTS_FILE);
-         rename(TEMP_FILE, GUESTS_FILE);
-     } else {
-         remove(TEMP_FILE);
-         printf("\nGuest with ID %d not found.\n", guestId);
      }
-     return found;
+     return 1;
  }
  
  /* List all active guests */
  void listGuests(User *currentUser) {
-     FILE *fp;
-     Guest tempGuest;
+     Table *guests = getTable(TABLE_GUESTS);
      int count = 0;
      
-     fp = fopen(GUESTS_FILE, "rb");
-     if (fp == NULL) {
-         printf("\nNo guests found or error opening file.\n");
-         return;
-     }
-     
      clearScreen();
      printf("===== GUEST LIST =====\n");
      printf("%-5s %-30s %-15s %-25s %-12s\n", 
             "ID", "Name", "Phone", "Email", "VIP Status");
      printf("--------------------------------------------------------------------------------------\n");
      
-     while (fread(&tempGuest, sizeof(Guest), 1, fp) == 1) {
-         if (tempGuest.isActive) {
+     for (int i = 0; i < guests->count; i++) {
+         Guest *guest = tableRecord(guests, i);
+         if (guest->isActive) {
              printf("%-5d %-30s %-15s %-25s %-12s\n", 
-                    tempGuest.id, 
-                    tempGuest.name, 
-                    tempGuest.phone, 
-                    tempGuest.email,
-                    getVipStatusString(tempGuest.vipStatus));
+                    guest->id, 
+                    guest->name, 
+                    guest->phone, 
+                    guest->email,
+                    getVipStatusString(guest->vipStatus));
              count++;
          }
      }
      
-     fclose(fp);
-     
      printf("--------------------------------------------------------------------------------------\n");
      if (count == 0) {
          printf("No active guests in the system.\n");
@@ -270,117 +310,146 @@
  
  /* Search for guests */
  void searchGuests(User *currentUser) {
-     FILE *fp;
-     Guest tempGuest;
+     Table *guests = getTable(TABLE_GUESTS);
      char searchTerm[MAX_GUEST_NAME_LEN];
-     int count = 0;
+     int *guestIds;
+     int count;
      
      clearScreen();
      printf("===== SEARCH GUESTS =====\n");
-     printf("Enter name or phone to search for: ");
+     printf("Enter name, phone or email to search for: ");
      getStringInput(NULL, searchTerm, MAX_GUEST_NAME_LEN);
      
-     for (int i = 0; searchTerm[i]; i++) {
-         searchTerm[i] = tolower(searchTerm[i]);
-     }
-     
-     fp = fopen(GUESTS_FILE, "rb");
-     if (fp == NULL) {
-         printf("\nError: Could not open guests file.\n");
+     guestIds = malloc(((size_t)guests->count + 1) * sizeof(int));
+     if (guestIds == NULL) {
+         printf("\nError: Out of memory.\n");
          return;
      }
+     count = findGuests(searchTerm, guestIds, guests->count);
      
      printf("\n===== SEARCH RESULTS =====\n");
      printf("%-5s %-30s %-15s %-25s %-12s\n", 
             "ID", "Name", "Phone", "Email", "VIP Status");
      printf("--------------------------------------------------------------------------------------\n");
      
-     while (fread(&tempGuest, sizeof(Guest), 1, fp) == 1) {
-         if (tempGuest.isActive) {
-             char lowerName[MAX_GUEST_NAME_LEN];
-             strcpy(lowerName, tempGuest.name);
-             for (int i = 0; lowerName[i]; i++) {
-                 lowerName[i] = tolower(lowerName[i]);
-             }
-             
-             if (strstr(lowerName, searchTerm) != NULL || strstr(tempGuest.phone, searchTerm) != NULL) {
-                 printf("%-5d %-30s %-15s %-25s %-12s\n", 
-                        tempGuest.id, 
-                        tempGuest.name, 
-                        tempGuest.phone, 
-                        tempGuest.email,
-                        getVipStatusString(tempGuest.vipStatus));
-                 count++;
-             }
-         }
+     for (int i = 0; i < count; i++) {
+         Guest *guest = tableRecord(guests, findGuestSlot(guestIds[i]));
+         printf("%-5d %-30s %-15s %-25s %-12s\n", 
+                guest->id, 
+                guest->name, 
+                guest->phone, 
+                guest->email,
+                getVipStatusString(guest->vipStatus));
      }
      
-     fclose(fp);
-     
      printf("--------------------------------------------------------------------------------------\n");
      printf("Found %d matching guests.\n", count);
+     free(guestIds);
  }
  
- /* Get a guest by ID */
- int getGuestById(int guestId, Guest *guest) {
-     FILE *fp;
-     Guest tempGuest;
-     int found = 0;
-     
-     fp = fopen(GUESTS_FILE, "rb");
-     if (fp == NULL) return 0;
+ /* Find active guests whose name, phone or email contains a search term, best matches first */
+ int findGuests(const char *searchTerm, int *guestIds, int maxResults) {
+     return searchGuestIndex(searchTerm, guestIds, maxResults);
+ }
+ 
+ /* Find active guests whose phone number starts with the given digits */
+ int findGuestsByPhone(const char *phone, int *guestIds, int maxResults) {
+     return lookupGuestPhone(phone, guestIds, maxResults);
+ }
+ 
+ /* Find active guests whose ID document number starts with the given prefix */
+ int findGuestsByIdNumber(const char *idNumber, int *guestIds, int maxResults) {
+     return lookupGuestIdNumber(idNumber, guestIds, maxResults);
+ }
+ 
+ /* List guests whose phone or ID number starts with a key, returning how many were shown */
+ int listGuestsByPhoneOrId(const char *key) {
+     int guestIds[MAX_GUEST_LOOKUP_RESULTS];
+     int idMatches[MAX_GUEST_LOOKUP_RESULTS];
+     int count, idCount;
+     
+     // Phone matches first, then ID number matches not already listed
+     count = findGuestsByPhone(key, guestIds, MAX_GUEST_LOOKUP_RESULTS);
+     idCount = findGuestsByIdNumber(key, idMatches, MAX_GUEST_LOOKUP_RESULTS);
+     for (int i = 0; i < idCount && count < MAX_GUEST_LOOKUP_RESULTS; i++) {
+         int listed = 0;
+         for (int j = 0; j < count && !listed; j++) {
+             listed = guestIds[j] == idMatches[i];
+         }
+         if (!listed) {
+             guestIds[count++] = idMatches[i];
+         }
+     }
      
-     while (fread(&tempGuest, sizeof(Guest), 1, fp) == 1) {
-         if (tempGuest.id == guestId && tempGuest.isActive) {
-             *guest = tempGuest;
-             found = 1;
-             break;
+     printf("\n%-5s %-30s %-15s %-20s %-12s\n", "ID", "Name", "Phone", "ID Number", "VIP Status");
+     printf("-------------------------------------------------------------------------------------\n");
+     for (int i = 0; i < count; i++) {
+         Guest guest;
+         if (getGuestById(guestIds[i], &guest)) {
+             printf("%-5d %-30s %-15s %-20s %-12s\n", guest.id, guest.name, guest.phone,
+                    guest.idNumber, getVipStatusString(guest.vipStatus));
          }
      }
+     printf("-------------------------------------------------------------------------------------\n");
+     if (count == 0) {
+         printf("No guest has a phone or ID number starting with '%s'.\n", key);
+     }
+     return count;
+ }
+ 
+ /* Find the table slot of an active guest, or -1 if there is none */
+ static int findGuestSlot(int guestId) {
+     Table *guests = getTable(TABLE_GUESTS);
+     int slot = tableLookup(guests, guestId);
      
-     fclose(fp);
-     return found;
+     if (slot < 0 || !((Guest *)tableRecord(guests, slot))->isActive) {
+         return -1;
+     }
+     return slot;
+ }
+ 
+ /* Get a guest by ID */
+ int getGuestById(int guestId, Guest *guest) {
+     int slot = findGuestSlot(guestId);
+     if (slot < 0) return 0;
+     
+     *guest = *(Guest *)tableRecord(getTable(TABLE_GUESTS), slot);
+     return 1;
  }
  
  /* Update guest stay info after checkout and payment */
  int updateGuestStayInfo(int guestId, double amountSpent) {
-     FILE *fp, *tempFp;
-     Guest tempGuest;
-     int found = 0;
-     
-     fp = fopen(GUESTS_FILE, "rb");
-     if (!fp) return 0;
+     int ok;
      
-     tempFp = fopen(TEMP_FILE, "wb");
-     if (!tempFp) {
-         fclose(fp);
+     walBegin();
+     ok = lockRecord(TABLE_GUESTS, guestId) && addStay(guestId, amountSpent);
+     if (!ok) {
+         walAbort();
          return 0;
      }
-     
-     while (fread(&tempGuest, sizeof(Guest), 1, fp) == 1) {
-         if (tempGuest.id == guestId && tempGuest.isActive) {
-             found = 1;
-             tempGuest.totalStays++;
-             tempGuest.totalSpent += amountSpent;
-             
-             if (tempGuest.totalSpent >= 5000.0) tempGuest.vipStatus = VIP_STATUS_PLATINUM;
-             else if (tempGuest.totalSpent >= 2500.0) tempGuest.vipStatus = VIP_STATUS_GOLD;
-             else if (tempGuest.totalSpent >= 1000.0) tempGuest.vipStatus = VIP_STATUS_SILVER;
-             else if (tempGuest.totalSpent >= 500.0) tempGuest.vipStatus = VIP_STATUS_BRONZE;
-         }
-         fwrite(&tempGuest, sizeof(Guest), 1, tempFp);
-     }
-     
-     fclose(fp);
-     fclose(tempFp);
-     
-     if (found) {
-         remove(GUESTS_FILE);
-         rename(TEMP_FILE, GUESTS_FILE);
-     } else {
-         remove(TEMP_FILE);
-     }
-     return found;
+     return walCommit();
+ }
+ 
+ /* Count a stay for a guest once it is locked */
+ static int addStay(int guestId, double amountSpent) {
+     Table *guests;
+     Guest *guest;
+     int slot;
+     
+     slot = findGuestSlot(guestId);
+     if (slot < 0) return 0;
+     
+     guests = getTable(TABLE_GUESTS);
+     guest = tableRecord(guests, slot);
+     guest->totalStays++;
+     guest->totalSpent += amountSpent;
+     
+     if (guest->totalSpent >= 5000.0) guest->vipStatus = VIP_STATUS_PLATINUM;
+     else if (guest->totalSpent >= 2500.0) guest->vipStatus = VIP_STATUS_GOLD;
+     else if (guest->totalSpent >= 1000.0) guest->vipStatus = VIP_STATUS_SILVER;
+     else if (guest->totalSpent >= 500.0) guest->vipStatus = VIP_STATUS_BRONZE;
+     
+     return tableWriteRecord(guests, slot);
  }
  
  /* Guest management menu */
@@ -389,6 +458,7 @@
      int guestId;
      
      do {
+         refreshTables();
          clearScreen();
          printf("===== GUEST MANAGEMENT =====\n");
          printf("1. List All Guests\n");
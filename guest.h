@@ -2,6 +2,7 @@
 #define GUEST_H
 
 #include "auth.h" /* For User type */
+#include "textheap.h" /* For TextRef type */
 
 /* VIP status definitions */
 typedef enum {
@@ -22,6 +23,9 @@ typedef enum {
 #define MAX_DATE_LEN 11
 #define MAX_NOTES_LEN 200
 
+/* Most guests shown by a phone or ID number lookup */
+#define MAX_GUEST_LOOKUP_RESULTS 20
+
 /* File paths */
 #define GUESTS_FILE "data/guests.dat"
 
@@ -29,15 +33,15 @@ typedef enum {
 typedef struct {
     int id;
     char name[MAX_GUEST_NAME_LEN];
-    char address[MAX_ADDRESS_LEN];
+    TextRef address;
     char phone[MAX_PHONE_LEN];
     char email[MAX_EMAIL_LEN];
     char idNumber[MAX_ID_NUMBER_LEN];
-    char idType[MAX_ID_TYPE_LEN];
+    TextRef idType;
     char registrationDate[MAX_DATE_LEN];
     int totalStays;
     double totalSpent;
-    char notes[MAX_NOTES_LEN];
+    TextRef notes;
     int isActive;
     VipStatus vipStatus;
 } Guest;
@@ -46,11 +50,17 @@ typedef struct {
 const char* getVipStatusString(VipStatus status);
 int initializeGuestData(void);
 int addGuest(void);
+int createGuest(Guest *guest, const char *address, const char *idType, const char *notes);
 int modifyGuest(User *currentUser, int guestId);
 int deleteGuest(User *currentUser, int guestId);
+int releaseDeletedGuestTexts(void);
 int getGuestById(int guestId, Guest *guest);
 void listGuests(User *currentUser);
 void searchGuests(User *currentUser);
+int findGuests(const char *searchTerm, int *guestIds, int maxResults);
+int findGuestsByPhone(const char *phone, int *guestIds, int maxResults);
+int findGuestsByIdNumber(const char *idNumber, int *guestIds, int maxResults);
+int listGuestsByPhoneOrId(const char *key);
 int updateGuestStayInfo(int guestId, double amountSpent);
 void guestManagementMenu(User *currentUser);
 
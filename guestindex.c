@@ -0,0 +1,651 @@
+/**
+ * Hotel Management System
+ * guestindex.c - Guest search index implementation
+ *
+ * This file implements the trigram index behind guest search. Trigrams
+ * are packed into a 24-bit key and kept in an open-addressing hash
+ * table; each entry owns a posting list of guest slots in ascending
+ * order. New guests usually take the highest slot, so adding one
+ * appends to its lists; guests placed in a deleted guest's slot, and
+ * edits, insert the new trigrams by binary search. A query walks the
+ * shortest list of the term's trigrams and probes the others by binary
+ * search, then confirms each candidate against the actual fields,
+ * since trigrams can match out of order.
+ *
+ * The phone and ID number tries are path-compressed: each edge carries
+ * a run of characters, an insert splits an edge where the new key
+ * leaves it, and a removal prunes empty leaves and merges nodes left
+ * with a single child, so no node has only one child unless a key
+ * ends there.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include "guestindex.h"
+#include "table.h"
+
+#define POSTING_INITIAL_TABLE 1024
+#define POSTING_INITIAL_CAPACITY 4
+#define MAX_GUEST_TRIGRAMS (MAX_GUEST_NAME_LEN + MAX_PHONE_LEN + MAX_EMAIL_LEN)
+#define MAX_TRIE_KEY (MAX_PHONE_LEN > MAX_ID_NUMBER_LEN ? MAX_PHONE_LEN : MAX_ID_NUMBER_LEN)
+
+/* Guest slots containing one trigram */
+typedef struct {
+    uint32_t key;           /* Packed trigram; 0 marks an empty entry */
+    int *slots;             /* Guest slots in ascending order */
+    int count;
+    int capacity;
+} Posting;
+
+/* Radix trie node; the edge from the parent is labelled with a run of key characters */
+typedef struct TrieNode {
+    char *label;                /* Edge label (empty for the root) */
+    int labelLen;
+    struct TrieNode **children; /* Children sorted by the first character of their label */
+    int childCount;
+    int *slots;                 /* Guest slots whose key ends at this node */
+    int slotCount;
+    int slotCapacity;
+} TrieNode;
+
+/* A search result before ranking */
+typedef struct {
+    int score;
+    int id;
+} Match;
+
+static Posting *postings = NULL;
+static int postingTableSize = 0;        /* Power of two */
+static int postingCount = 0;
+
+static TrieNode *phoneTrie = NULL;      /* Keyed on phone digits */
+static TrieNode *idNumberTrie = NULL;   /* Keyed on ID number letters and digits */
+static int built = 0;
+
+/* Pack three characters, folded to lower case, into a trigram key */
+static uint32_t trigramKey(const char *s) {
+    return ((uint32_t)(unsigned char)tolower((unsigned char)s[0]) << 16) |
+           ((uint32_t)(unsigned char)tolower((unsigned char)s[1]) << 8) |
+           (uint32_t)(unsigned char)tolower((unsigned char)s[2]);
+}
+
+/* Find the hash entry for a trigram: its own entry, or the empty one it would take */
+static Posting *findPosting(uint32_t key) {
+    uint32_t mask = (uint32_t)postingTableSize - 1;
+    uint32_t i = (key * 2654435761u) & mask;
+
+    while (postings[i].key != 0 && postings[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return &postings[i];
+}
+
+/* Double the hash table once it is half full */
+static int growPostingTable(void) {
+    Posting *old = postings;
+    int oldSize = postingTableSize;
+    int newSize = oldSize > 0 ? oldSize * 2 : POSTING_INITIAL_TABLE;
+
+    postings = calloc((size_t)newSize, sizeof(Posting));
+    if (postings == NULL) {
+        postings = old;
+        printf("\nError: Out of memory while indexing guests.\n");
+        return 0;
+    }
+    postingTableSize = newSize;
+    for (int i = 0; i < oldSize; i++) {
+        if (old[i].key != 0) {
+            *findPosting(old[i].key) = old[i];
+        }
+    }
+    free(old);
+    return 1;
+}
+
+/* Find the position of a slot in a posting list, or where it would go */
+static int postingPosition(const Posting *posting, int slot) {
+    int low = 0, high = posting->count;
+
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (posting->slots[mid] < slot) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/* Add a guest slot to a trigram's posting list */
+static void addToPosting(uint32_t key, int slot) {
+    Posting *posting;
+    int pos;
+
+    if ((postingCount + 1) * 2 > postingTableSize && !growPostingTable()) {
+        return;
+    }
+
+    posting = findPosting(key);
+    if (posting->key == 0) {
+        posting->key = key;
+        postingCount++;
+    }
+
+    if (posting->count == posting->capacity) {
+        int newCapacity = posting->capacity > 0 ? posting->capacity * 2 : POSTING_INITIAL_CAPACITY;
+        int *newSlots = realloc(posting->slots, (size_t)newCapacity * sizeof(int));
+        if (newSlots == NULL) {
+            printf("\nError: Out of memory while indexing guests.\n");
+            return;
+        }
+        posting->slots = newSlots;
+        posting->capacity = newCapacity;
+    }
+
+    /* New guests have the highest slot, so this is nearly always an append */
+    pos = posting->count > 0 && posting->slots[posting->count - 1] < slot ?
+          posting->count : postingPosition(posting, slot);
+    if (pos < posting->count && posting->slots[pos] == slot) {
+        return;
+    }
+    memmove(&posting->slots[pos + 1], &posting->slots[pos], (size_t)(posting->count - pos) * sizeof(int));
+    posting->slots[pos] = slot;
+    posting->count++;
+}
+
+/* Remove a guest slot from a trigram's posting list */
+static void removeFromPosting(uint32_t key, int slot) {
+    Posting *posting;
+    int pos;
+
+    if (postingTableSize == 0) {
+        return;
+    }
+    posting = findPosting(key);
+    if (posting->key == 0) {
+        return;
+    }
+
+    pos = postingPosition(posting, slot);
+    if (pos < posting->count && posting->slots[pos] == slot) {
+        memmove(&posting->slots[pos], &posting->slots[pos + 1], (size_t)(posting->count - pos - 1) * sizeof(int));
+        posting->count--;
+    }
+}
+
+/* Compare two trigram keys for qsort */
+static int compareKeys(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Append the trigrams of one string */
+static int addTrigrams(const char *text, uint32_t *keys, int count) {
+    size_t len = strlen(text);
+
+    for (size_t i = 0; i + 3 <= len; i++) {
+        keys[count++] = trigramKey(text + i);
+    }
+    return count;
+}
+
+/* Collect the distinct trigrams of a guest's indexed fields */
+static int guestTrigrams(const Guest *guest, uint32_t *keys) {
+    int count = 0, distinct = 0;
+
+    count = addTrigrams(guest->name, keys, count);
+    count = addTrigrams(guest->phone, keys, count);
+    count = addTrigrams(guest->email, keys, count);
+
+    qsort(keys, (size_t)count, sizeof(uint32_t), compareKeys);
+    for (int i = 0; i < count; i++) {
+        if (distinct == 0 || keys[distinct - 1] != keys[i]) {
+            keys[distinct++] = keys[i];
+        }
+    }
+    return distinct;
+}
+
+/* Keep the characters of a key that the trie compares, normalized */
+static int normalizeKey(const char *text, char *key, int phone) {
+    int len = 0;
+
+    for (; *text && len < MAX_TRIE_KEY - 1; text++) {
+        unsigned char c = (unsigned char)*text;
+        if (phone ? isdigit(c) : isalnum(c)) {
+            key[len++] = (char)toupper(c);
+        }
+    }
+    key[len] = '\0';
+    return len;
+}
+
+/* Create a trie node for an edge label */
+static TrieNode *newTrieNode(const char *label, int labelLen) {
+    TrieNode *node = calloc(1, sizeof(TrieNode));
+
+    if (node == NULL) {
+        return NULL;
+    }
+    node->label = malloc((size_t)labelLen + 1);
+    if (node->label == NULL) {
+        free(node);
+        return NULL;
+    }
+    memcpy(node->label, label, (size_t)labelLen);
+    node->label[labelLen] = '\0';
+    node->labelLen = labelLen;
+    return node;
+}
+
+/* Free a trie node and everything below it */
+static void freeTrie(TrieNode *node) {
+    if (node == NULL) {
+        return;
+    }
+    for (int i = 0; i < node->childCount; i++) {
+        freeTrie(node->children[i]);
+    }
+    free(node->children);
+    free(node->slots);
+    free(node->label);
+    free(node);
+}
+
+/* Find the position of the child whose label starts with a character, or where it would go */
+static int childPosition(const TrieNode *node, char c) {
+    int low = 0, high = node->childCount;
+
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if ((unsigned char)node->children[mid]->label[0] < (unsigned char)c) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/* Insert a child at a position in a node's sorted child array */
+static int insertChild(TrieNode *node, int pos, TrieNode *child) {
+    TrieNode **children = realloc(node->children, (size_t)(node->childCount + 1) * sizeof(TrieNode *));
+
+    if (children == NULL) {
+        return 0;
+    }
+    memmove(&children[pos + 1], &children[pos], (size_t)(node->childCount - pos) * sizeof(TrieNode *));
+    children[pos] = child;
+    node->children = children;
+    node->childCount++;
+    return 1;
+}
+
+/* Add a guest slot to the node for a key, splitting edges as needed */
+static void trieInsert(TrieNode *node, const char *key, int slot) {
+    while (*key) {
+        int pos = childPosition(node, key[0]);
+        TrieNode *child = pos < node->childCount ? node->children[pos] : NULL;
+        int common = 0;
+
+        if (child == NULL || child->label[0] != key[0]) {
+            /* No edge starts with this character: the rest of the key is a new leaf */
+            TrieNode *leaf = newTrieNode(key, (int)strlen(key));
+            if (leaf == NULL || !insertChild(node, pos, leaf)) {
+                freeTrie(leaf);
+                printf("\nError: Out of memory while indexing guests.\n");
+                return;
+            }
+            node = leaf;
+            break;
+        }
+
+        while (common < child->labelLen && key[common] == child->label[common]) {
+            common++;
+        }
+        if (common < child->labelLen) {
+            /* The key leaves the edge part way: split it at that point */
+            TrieNode *middle = newTrieNode(child->label, common);
+            char *rest = malloc((size_t)(child->labelLen - common) + 1);
+            if (middle == NULL || rest == NULL || !insertChild(middle, 0, child)) {
+                freeTrie(middle);
+                free(rest);
+                printf("\nError: Out of memory while indexing guests.\n");
+                return;
+            }
+            strcpy(rest, child->label + common);
+            free(child->label);
+            child->label = rest;
+            child->labelLen -= common;
+            node->children[pos] = middle;
+            child = middle;
+        }
+        node = child;
+        key += common;
+    }
+
+    if (node->slotCount == node->slotCapacity) {
+        int newCapacity = node->slotCapacity > 0 ? node->slotCapacity * 2 : 1;
+        int *slots = realloc(node->slots, (size_t)newCapacity * sizeof(int));
+        if (slots == NULL) {
+            printf("\nError: Out of memory while indexing guests.\n");
+            return;
+        }
+        node->slots = slots;
+        node->slotCapacity = newCapacity;
+    }
+    node->slots[node->slotCount++] = slot;
+}
+
+/* Remove a guest slot from the node for a key, pruning and merging emptied nodes */
+static void trieRemove(TrieNode *node, const char *key, int slot) {
+    int pos;
+    TrieNode *child;
+
+    if (*key == '\0') {
+        for (int i = 0; i < node->slotCount; i++) {
+            if (node->slots[i] == slot) {
+                node->slots[i] = node->slots[--node->slotCount];
+                break;
+            }
+        }
+        return;
+    }
+
+    pos = childPosition(node, key[0]);
+    if (pos >= node->childCount) {
+        return;
+    }
+    child = node->children[pos];
+    if (child->label[0] != key[0] || strncmp(key, child->label, (size_t)child->labelLen) != 0) {
+        return;
+    }
+    trieRemove(child, key + child->labelLen, slot);
+
+    if (child->slotCount == 0 && child->childCount == 0) {
+        memmove(&node->children[pos], &node->children[pos + 1], (size_t)(node->childCount - pos - 1) * sizeof(TrieNode *));
+        node->childCount--;
+        freeTrie(child);
+    } else if (child->slotCount == 0 && child->childCount == 1) {
+        /* A pass-through node: fold its only child's edge into it */
+        TrieNode *only = child->children[0];
+        char *label = malloc((size_t)(child->labelLen + only->labelLen) + 1);
+        if (label != NULL) {
+            memcpy(label, child->label, (size_t)child->labelLen);
+            strcpy(label + child->labelLen, only->label);
+            free(only->label);
+            only->label = label;
+            only->labelLen += child->labelLen;
+            node->children[pos] = only;
+            child->childCount = 0;
+            freeTrie(child);
+        }
+    }
+}
+
+/* Collect the active guests stored at or below a node, exact keys first */
+static int collectTrie(const TrieNode *node, int *guestIds, int count, int maxResults) {
+    Table *guests = getTable(TABLE_GUESTS);
+
+    for (int i = 0; i < node->slotCount && count < maxResults; i++) {
+        Guest *guest = tableRecord(guests, node->slots[i]);
+        if (guest->isActive) {
+            guestIds[count++] = guest->id;
+        }
+    }
+    for (int i = 0; i < node->childCount && count < maxResults; i++) {
+        count = collectTrie(node->children[i], guestIds, count, maxResults);
+    }
+    return count;
+}
+
+/* Find the guests whose normalized key starts with a prefix */
+static int trieLookup(const TrieNode *node, const char *text, int phone, int *guestIds, int maxResults) {
+    char key[MAX_TRIE_KEY];
+    const char *rest = key;
+
+    if (node == NULL || normalizeKey(text, key, phone) == 0) {
+        return 0;
+    }
+
+    while (*rest) {
+        int pos = childPosition(node, rest[0]);
+        const TrieNode *child;
+        int len;
+
+        if (pos >= node->childCount || node->children[pos]->label[0] != rest[0]) {
+            return 0;
+        }
+        child = node->children[pos];
+        len = (int)strlen(rest);
+        if (len <= child->labelLen) {
+            /* The prefix ends inside this edge: everything below matches */
+            return strncmp(rest, child->label, (size_t)len) == 0 ? collectTrie(child, guestIds, 0, maxResults) : 0;
+        }
+        if (strncmp(rest, child->label, (size_t)child->labelLen) != 0) {
+            return 0;
+        }
+        rest += child->labelLen;
+        node = child;
+    }
+    return collectTrie(node, guestIds, 0, maxResults);
+}
+
+/* Add or remove a guest's phone and ID number keys */
+static void updateTries(int slot, const Guest *guest, int add) {
+    char key[MAX_TRIE_KEY];
+
+    if (normalizeKey(guest->phone, key, 1) > 0) {
+        if (add) trieInsert(phoneTrie, key, slot); else trieRemove(phoneTrie, key, slot);
+    }
+    if (normalizeKey(guest->idNumber, key, 0) > 0) {
+        if (add) trieInsert(idNumberTrie, key, slot); else trieRemove(idNumberTrie, key, slot);
+    }
+}
+
+/* Build the search index from the guest table */
+int buildGuestIndex(void) {
+    Table *guests = getTable(TABLE_GUESTS);
+    Guest *all = TABLE_RECORDS(guests, Guest);
+
+    for (int i = 0; i < postingTableSize; i++) {
+        free(postings[i].slots);
+    }
+    free(postings);
+    postings = NULL;
+    postingTableSize = postingCount = 0;
+    freeTrie(phoneTrie);
+    freeTrie(idNumberTrie);
+    phoneTrie = newTrieNode("", 0);
+    idNumberTrie = newTrieNode("", 0);
+    if (phoneTrie == NULL || idNumberTrie == NULL || !growPostingTable()) {
+        built = 0;
+        return 0;
+    }
+
+    built = 1;
+    for (int slot = 0; slot < guests->count; slot++) {
+        guestIndexUpdate(slot, NULL, &all[slot]);
+    }
+    return 1;
+}
+
+/* Update the search index after a guest changes */
+void guestIndexUpdate(int slot, const Guest *before, const Guest *after) {
+    uint32_t keys[MAX_GUEST_TRIGRAMS];
+    int count;
+
+    if (!built) {
+        return; /* The next search builds from the table, which holds the change */
+    }
+    if (before != NULL && before->isActive) {
+        count = guestTrigrams(before, keys);
+        for (int i = 0; i < count; i++) {
+            removeFromPosting(keys[i], slot);
+        }
+        if (phoneTrie != NULL) updateTries(slot, before, 0);
+    }
+    if (after != NULL && after->isActive) {
+        count = guestTrigrams(after, keys);
+        for (int i = 0; i < count; i++) {
+            addToPosting(keys[i], slot);
+        }
+        if (phoneTrie != NULL) updateTries(slot, after, 1);
+    }
+}
+
+/* Discard the index so the next search rebuilds it */
+void invalidateGuestIndex(void) {
+    built = 0;
+}
+
+/* Rate how well a field matches a lower-case term: 3 equal, 2 prefix or word start, 1 substring, 0 none */
+static int fieldMatch(const char *field, const char *term, size_t termLen) {
+    char lower[MAX_GUEST_NAME_LEN + MAX_EMAIL_LEN];
+    const char *found;
+    size_t len = strlen(field);
+    int best = 0;
+
+    if (len >= sizeof(lower)) {
+        len = sizeof(lower) - 1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        lower[i] = (char)tolower((unsigned char)field[i]);
+    }
+    lower[len] = '\0';
+
+    for (found = strstr(lower, term); found != NULL; found = strstr(found + 1, term)) {
+        if (found == lower) {
+            return len == termLen ? 3 : 2;
+        }
+        best = isalnum((unsigned char)found[-1]) ? (best > 1 ? best : 1) : 2;
+    }
+    return best;
+}
+
+/* Score a guest against a lower-case term; 0 means no match */
+static int matchScore(const Guest *guest, const char *term, size_t termLen) {
+    int name = fieldMatch(guest->name, term, termLen);
+    int phone = fieldMatch(guest->phone, term, termLen);
+    int email = fieldMatch(guest->email, term, termLen);
+    int other = phone > email ? phone : email;
+
+    /* A name match outranks a phone or email match of the same quality */
+    if (name == 0 && other == 0) {
+        return 0;
+    }
+    return name >= other ? name * 2 + 1 : other * 2;
+}
+
+/* Compare matches for qsort: best score first, then lowest id */
+static int compareMatches(const void *a, const void *b) {
+    const Match *x = a, *y = b;
+    if (x->score != y->score) {
+        return y->score - x->score;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+/* Find active guests whose name, phone or email contains a term */
+int searchGuestIndex(const char *term, int *guestIds, int maxResults) {
+    Table *guests = getTable(TABLE_GUESTS);
+    char lowerTerm[MAX_GUEST_NAME_LEN + MAX_EMAIL_LEN];
+    uint32_t keys[MAX_GUEST_NAME_LEN + MAX_EMAIL_LEN];
+    Posting *lists[MAX_GUEST_NAME_LEN + MAX_EMAIL_LEN];
+    Match *matches;
+    size_t termLen;
+    int keyCount = 0, listCount = 0, matchCount = 0, shortest = 0;
+
+    strncpy(lowerTerm, term, sizeof(lowerTerm) - 1);
+    lowerTerm[sizeof(lowerTerm) - 1] = '\0';
+    termLen = strlen(lowerTerm);
+    for (size_t i = 0; i < termLen; i++) {
+        lowerTerm[i] = (char)tolower((unsigned char)lowerTerm[i]);
+    }
+    if (termLen == 0 || maxResults <= 0) {
+        return 0;
+    }
+    if (!built) {
+        buildGuestIndex();
+    }
+
+    matches = malloc(((size_t)guests->count + 1) * sizeof(Match));
+    if (matches == NULL) {
+        printf("\nError: Out of memory.\n");
+        return 0;
+    }
+
+    if (termLen < GUEST_INDEX_MIN_TERM || postingTableSize == 0) {
+        /* Too short to have a trigram: check every guest */
+        for (int slot = 0; slot < guests->count; slot++) {
+            Guest *guest = tableRecord(guests, slot);
+            int score = guest->isActive ? matchScore(guest, lowerTerm, termLen) : 0;
+            if (score > 0) {
+                matches[matchCount].score = score;
+                matches[matchCount++].id = guest->id;
+            }
+        }
+    } else {
+        keyCount = addTrigrams(lowerTerm, keys, 0);
+        for (int i = 0; i < keyCount; i++) {
+            Posting *posting = findPosting(keys[i]);
+            if (posting->key == 0 || posting->count == 0) {
+                listCount = 0; /* Some trigram occurs nowhere */
+                break;
+            }
+            lists[listCount++] = posting;
+        }
+        for (int i = 1; i < listCount; i++) {
+            if (lists[i]->count < lists[shortest]->count) {
+                shortest = i;
+            }
+        }
+
+        for (int n = 0; listCount > 0 && n < lists[shortest]->count; n++) {
+            int slot = lists[shortest]->slots[n];
+            int inAll = 1;
+            for (int i = 0; i < listCount && inAll; i++) {
+                int pos = postingPosition(lists[i], slot);
+                inAll = pos < lists[i]->count && lists[i]->slots[pos] == slot;
+            }
+            if (inAll) {
+                Guest *guest = tableRecord(guests, slot);
+                int score = guest->isActive ? matchScore(guest, lowerTerm, termLen) : 0;
+                if (score > 0) {
+                    matches[matchCount].score = score;
+                    matches[matchCount++].id = guest->id;
+                }
+            }
+        }
+    }
+
+    qsort(matches, (size_t)matchCount, sizeof(Match), compareMatches);
+    if (matchCount > maxResults) {
+        matchCount = maxResults;
+    }
+    for (int i = 0; i < matchCount; i++) {
+        guestIds[i] = matches[i].id;
+    }
+    free(matches);
+    return matchCount;
+}
+
+/* Find active guests whose phone digits start with those of a number */
+int lookupGuestPhone(const char *phone, int *guestIds, int maxResults) {
+    if (!built && !buildGuestIndex()) {
+        return 0;
+    }
+    return trieLookup(phoneTrie, phone, 1, guestIds, maxResults);
+}
+
+/* Find active guests whose ID number starts with a prefix */
+int lookupGuestIdNumber(const char *idNumber, int *guestIds, int maxResults) {
+    if (!built && !buildGuestIndex()) {
+        return 0;
+    }
+    return trieLookup(idNumberTrie, idNumber, 0, guestIds, maxResults);
+}
@@ -0,0 +1,97 @@
+/**
+ * Hotel Management System
+ * guestindex.h - Guest search index header
+ *
+ * This file contains declarations for the guest search index. Every
+ * three-character sequence (trigram) of an active guest's name, phone
+ * and email, folded to lower case, maps to the sorted list of guest
+ * slots that contain it. A substring search intersects the lists of the
+ * term's trigrams and only checks the guests that survive, instead of
+ * comparing the term against every guest.
+ *
+ * Exact and prefix lookups on phone numbers and ID document numbers go
+ * through two radix tries instead, keyed on the phone's digits and on
+ * the ID number's letters and digits in upper case, so a lookup costs
+ * time proportional to the key length.
+ *
+ * The indexes are built when the guest table is loaded and must be told
+ * about every change to an indexed field through guestIndexUpdate.
+ */
+
+#ifndef GUESTINDEX_H
+#define GUESTINDEX_H
+
+#include "guest.h"
+
+/* Shortest term answered from the index; shorter terms scan the table */
+#define GUEST_INDEX_MIN_TERM 3
+
+/**
+ * Build the search index from the guest table
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int buildGuestIndex(void);
+
+/**
+ * Update the search index after a guest changes
+ *
+ * Either pointer may be NULL: pass NULL as before for a new guest. The
+ * slot is the guest's slot in the guest table.
+ *
+ * @param slot Slot of the guest
+ * @param before Guest as it was before the change, or NULL
+ * @param after Guest as it is after the change, or NULL
+ */
+void guestIndexUpdate(int slot, const Guest *before, const Guest *after);
+
+/**
+ * Discard the index so the next search rebuilds it
+ *
+ * Call this when guests have changed without going through
+ * guestIndexUpdate, such as by another terminal.
+ */
+void invalidateGuestIndex(void);
+
+/**
+ * Find active guests whose name, phone or email contains a term
+ *
+ * Matching ignores case. Results are ranked by match quality: a field
+ * equal to the term first, then a field or word starting with it, then
+ * any other occurrence; a name match ranks above a phone or email match
+ * of the same quality, and ties are in guest id order.
+ *
+ * @param term Search term
+ * @param guestIds Receives the ids of matching guests, best first
+ * @param maxResults Size of the guestIds array
+ * @return Number of guest ids stored
+ */
+int searchGuestIndex(const char *term, int *guestIds, int maxResults);
+
+/**
+ * Find active guests whose phone digits start with those of a number
+ *
+ * Only digits are compared, so "+1 (555) 010" matches "1-555-0100".
+ * Exact matches come first, then longer numbers in digit order.
+ *
+ * @param phone Phone number or prefix
+ * @param guestIds Receives the ids of matching guests
+ * @param maxResults Size of the guestIds array
+ * @return Number of guest ids stored
+ */
+int lookupGuestPhone(const char *phone, int *guestIds, int maxResults);
+
+/**
+ * Find active guests whose ID number starts with a prefix
+ *
+ * Letters and digits are compared ignoring case; other characters
+ * are skipped. Exact matches come first.
+ *
+ * @param idNumber ID number or prefix
+ * @param guestIds Receives the ids of matching guests
+ * @param maxResults Size of the guestIds array
+ * @return Number of guest ids stored
+ */
+int lookupGuestIdNumber(const char *idNumber, int *guestIds, int maxResults);
+
+#endif /* GUESTINDEX_H */
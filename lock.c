@@ -0,0 +1,435 @@
+/**
+ * Hotel Management System
+ * lock.c - Multi-terminal locking implementation
+ *
+ * This file implements the locking layer. LOCK_FILE holds no records:
+ * its first bytes are counters (how often the log has been emptied and
+ * how often each data file has been written), and fcntl locks are taken
+ * on byte ranges far past them. Every terminal keeps a read lock on one
+ * byte while it runs, so a terminal can test for others by asking
+ * whether a write lock on that byte would conflict.
+ *
+ * Locks live on their own file because fcntl drops all of a process's
+ * locks on a file when any descriptor for it is closed, and the data
+ * files are opened and closed freely. fcntl locks belong to the process,
+ * so threads of one process are not kept apart by them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "lock.h"
+#include "availability.h"
+#include "occupancy.h"
+#include "guestindex.h"
+
+/* Discard the indexes built from a table so they are rebuilt */
+void invalidateDerived(TableId table) {
+    switch (table) {
+        case TABLE_ROOMS:
+        case TABLE_RESERVATIONS:
+            invalidateAvailability();
+            invalidateOccupancy();
+            break;
+        case TABLE_GUESTS:
+            invalidateGuestIndex();
+            break;
+        default:
+            break;
+    }
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+/* fcntl is not available: one terminal per data directory */
+int initializeLocking(void) { return 1; }
+int attachLocking(void) { return 1; }
+int otherTerminalsActive(void) { return 0; }
+int lockRecord(TableId table, int id) { (void)table; (void)id; return 1; }
+int lockAppend(TableId table) { (void)table; return 1; }
+int lockTable(TableId table) { (void)table; return 1; }
+void releaseLocks(void) {}
+void refreshTables(void) {}
+int lockLog(void) { return 1; }
+void unlockLog(void) {}
+int logShared(void) { return 0; }
+void noteLogTruncated(void) {}
+void noteTableWritten(TableId table, int current) { (void)table; (void)current; }
+void noteTableLoaded(TableId table) { (void)table; }
+
+#else
+
+/* Lock bytes, well past the counters at the start of the file */
+#define LOCK_TERMINALS ((off_t)1 << 20)         /* Read-locked by every running terminal */
+#define LOCK_LOG (LOCK_TERMINALS + 1)           /* Serialises use of the write-ahead log */
+#define LOCK_COUNTERS (LOCK_TERMINALS + 2)      /* Serialises counter updates */
+#define LOCK_TABLES ((off_t)1 << 32)            /* Start of the first table's range */
+#define LOCK_TABLE_SPAN ((off_t)1 << 32)        /* Per table: the append byte, then one byte per slot */
+
+/* Slot values of held locks that are not on a single record */
+#define HELD_APPEND -1
+#define HELD_TABLE -2
+
+/* Offsets of the counters */
+#define GENERATION_OFFSET 0
+#define VERSION_OFFSET(table) ((off_t)sizeof(int) * (1 + (table)))
+
+/* A lock held by the calling thread */
+typedef struct {
+    TableId table;
+    int slot;               /* Record slot, HELD_APPEND or HELD_TABLE */
+} HeldLock;
+
+static int lockFd = -1;
+static int logDepth = 0;                        /* Nesting of lockLog calls */
+static int seenGeneration = 0;                  /* Log generation after this terminal's last truncation */
+static int seenVersions[TABLE_COUNT];           /* Data file versions the cached tables match */
+
+static _Thread_local HeldLock *held = NULL;
+static _Thread_local int heldCount = 0;
+static _Thread_local int heldCapacity = 0;
+
+/* Set or clear an fcntl lock on a byte range of the lock file */
+static int setLock(short type, off_t start, off_t length, int wait) {
+    struct flock fl;
+
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = type;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = start;
+    fl.l_len = length;
+    while (fcntl(lockFd, wait ? F_SETLKW : F_SETLK, &fl) != 0) {
+        if (errno != EINTR) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Take a write lock on a byte range, waiting for other terminals if needed */
+static int acquire(off_t start, off_t length, const char *what) {
+    if (setLock(F_WRLCK, start, length, 0)) {
+        return 1;
+    }
+    if (errno != EACCES && errno != EAGAIN) {
+        printf("\nError: Could not lock %s.\n", what);
+        return 0;
+    }
+
+    printf("\nWaiting for another terminal to finish with %s...\n", what);
+    fflush(stdout);
+    if (!setLock(F_WRLCK, start, length, 1)) {
+        if (errno == EDEADLK) {
+            printf("\nError: Another terminal is waiting for this one over %s. Please try again.\n", what);
+        } else {
+            printf("\nError: Could not lock %s.\n", what);
+        }
+        return 0;
+    }
+    return 1;
+}
+
+/* Read a counter from the lock file */
+static int readCounter(off_t offset) {
+    int value = 0;
+
+    if (pread(lockFd, &value, sizeof(value), offset) != (ssize_t)sizeof(value)) {
+        return 0;
+    }
+    return value;
+}
+
+/* Increment a counter in the lock file and return its new value */
+static int bumpCounter(off_t offset) {
+    int value;
+
+    setLock(F_WRLCK, LOCK_COUNTERS, 1, 1);
+    value = readCounter(offset) + 1;
+    if (pwrite(lockFd, &value, sizeof(value), offset) != (ssize_t)sizeof(value)) {
+        printf("\nError: Could not write to %s.\n", LOCK_FILE);
+    }
+    setLock(F_UNLCK, LOCK_COUNTERS, 1, 0);
+    return value;
+}
+
+/* Get the first byte of a table's lock range */
+static off_t tableBase(TableId table) {
+    return LOCK_TABLES + (off_t)table * LOCK_TABLE_SPAN;
+}
+
+/* Check whether the calling thread holds a lock covering a slot of a table */
+static int holds(TableId table, int slot) {
+    for (int i = 0; i < heldCount; i++) {
+        if (held[i].table == table && (held[i].slot == slot || held[i].slot == HELD_TABLE)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Check whether the calling thread holds any lock on a table */
+static int holdsAny(TableId table) {
+    for (int i = 0; i < heldCount; i++) {
+        if (held[i].table == table) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Remember a lock taken by the calling thread */
+static int addHeld(TableId table, int slot) {
+    if (heldCount == heldCapacity) {
+        int newCapacity = heldCapacity > 0 ? heldCapacity * 2 : 16;
+        HeldLock *newHeld = realloc(held, (size_t)newCapacity * sizeof(HeldLock));
+
+        if (newHeld == NULL) {
+            printf("\nError: Out of memory while locking.\n");
+            return 0;
+        }
+        held = newHeld;
+        heldCapacity = newCapacity;
+    }
+    held[heldCount].table = table;
+    held[heldCount].slot = slot;
+    heldCount++;
+    return 1;
+}
+
+/* Get the lock range of a held lock */
+static void heldRange(const HeldLock *lock, off_t *start, off_t *length) {
+    *start = tableBase(lock->table);
+    *length = 1;
+    if (lock->slot == HELD_TABLE) {
+        *length = LOCK_TABLE_SPAN;
+    } else if (lock->slot >= 0) {
+        *start += 1 + lock->slot;
+    }
+}
+
+/* Bring a table up to date with other terminals after locking part of it */
+static int syncTable(TableId id, int firstLock, int slot) {
+    Table *table = getTable(id);
+    int version = readCounter(VERSION_OFFSET(id));
+    int ok;
+
+    if (version == seenVersions[id]) {
+        return 1;
+    }
+
+    /* Nothing in the table has been changed in this transaction yet,
+       so the whole table can be read again; later locks only re-read
+       what they lock and leave the version to be caught up next time */
+    if (firstLock) {
+        seenVersions[id] = version;
+        ok = tableRefresh(table);
+    } else {
+        ok = tableRefreshRecord(table, slot);
+    }
+    invalidateDerived(id);
+    return ok;
+}
+
+/* Open the lock file without registering this terminal */
+int attachLocking(void) {
+    if (lockFd >= 0) {
+        return 1;
+    }
+    lockFd = open(LOCK_FILE, O_RDWR | O_CREAT, 0644);
+    if (lockFd < 0) {
+        printf("\nError: Could not open %s.\n", LOCK_FILE);
+        return 0;
+    }
+    seenGeneration = readCounter(GENERATION_OFFSET);
+    return 1;
+}
+
+/* Open the lock file and register this terminal */
+int initializeLocking(void) {
+    if (lockFd >= 0) {
+        return 1;
+    }
+    if (!attachLocking()) {
+        return 0;
+    }
+    if (!setLock(F_RDLCK, LOCK_TERMINALS, 1, 1)) {
+        printf("\nError: Could not lock %s.\n", LOCK_FILE);
+        close(lockFd);
+        lockFd = -1;
+        return 0;
+    }
+    return 1;
+}
+
+/* Check whether another terminal is using the data directory */
+int otherTerminalsActive(void) {
+    struct flock fl;
+
+    if (lockFd < 0) {
+        return 0;
+    }
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = LOCK_TERMINALS;
+    fl.l_len = 1;
+    /* Our own read lock does not count against us */
+    return fcntl(lockFd, F_GETLK, &fl) == 0 && fl.l_type != F_UNLCK;
+}
+
+/* Lock the record with a given id for the rest of the transaction */
+int lockRecord(TableId id, int recordId) {
+    Table *table = getTable(id);
+    int firstLock, slot;
+
+    if (lockFd < 0) {
+        return 1;
+    }
+    firstLock = !holdsAny(id);
+
+    slot = tableLookup(table, recordId);
+    if (slot < 0) {
+        /* The record may have been added by another terminal */
+        if (!syncTable(id, firstLock, -1)) {
+            return 0;
+        }
+        slot = tableLookup(table, recordId);
+        if (slot < 0) {
+            return 1;
+        }
+    }
+    if (holds(id, slot)) {
+        return 1;
+    }
+
+    if (!acquire(tableBase(id) + 1 + slot, 1, table->path) || !addHeld(id, slot)) {
+        return 0;
+    }
+    if (!syncTable(id, firstLock, slot)) {
+        return 0;
+    }
+
+    /* A rewrite of the data file may have moved the record */
+    if (firstLock && tableLookup(table, recordId) != slot) {
+        setLock(F_UNLCK, tableBase(id) + 1 + slot, 1, 0);
+        heldCount--;
+        return lockRecord(id, recordId);
+    }
+    return 1;
+}
+
+/* Lock a table against appends from other terminals */
+int lockAppend(TableId id) {
+    Table *table = getTable(id);
+    int firstLock;
+
+    if (lockFd < 0 || holds(id, HELD_APPEND)) {
+        return 1;
+    }
+    firstLock = !holdsAny(id);
+    if (!acquire(tableBase(id), 1, table->path) || !addHeld(id, HELD_APPEND)) {
+        return 0;
+    }
+    return syncTable(id, firstLock, -1);
+}
+
+/* Lock a whole table, including every record and appends */
+int lockTable(TableId id) {
+    Table *table = getTable(id);
+    int firstLock;
+
+    if (lockFd < 0 || holds(id, HELD_TABLE)) {
+        return 1;
+    }
+    firstLock = !holdsAny(id);
+    if (!acquire(tableBase(id), LOCK_TABLE_SPAN, table->path) || !addHeld(id, HELD_TABLE)) {
+        return 0;
+    }
+    return syncTable(id, firstLock, -1);
+}
+
+/* Release every lock the calling thread holds on records and tables */
+void releaseLocks(void) {
+    for (int i = 0; i < heldCount; i++) {
+        off_t start, length;
+
+        heldRange(&held[i], &start, &length);
+        setLock(F_UNLCK, start, length, 0);
+    }
+    heldCount = 0;
+}
+
+/* Re-read every loaded table that another terminal has changed */
+void refreshTables(void) {
+    if (lockFd < 0 || heldCount > 0) {
+        return;
+    }
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        syncTable((TableId)i, 1, -1);
+    }
+}
+
+/* Take the lock serialising access to the write-ahead log */
+int lockLog(void) {
+    if (lockFd < 0) {
+        return 1;
+    }
+    if (logDepth == 0 && !acquire(LOCK_LOG, 1, "the transaction log")) {
+        return 0;
+    }
+    logDepth++;
+    return 1;
+}
+
+/* Release the write-ahead log lock taken by lockLog */
+void unlockLog(void) {
+    if (lockFd < 0 || logDepth == 0) {
+        return;
+    }
+    if (--logDepth == 0) {
+        setLock(F_UNLCK, LOCK_LOG, 1, 0);
+    }
+}
+
+/* Check whether commits must be written through to the data files */
+int logShared(void) {
+    if (lockFd < 0) {
+        return 0;
+    }
+    return otherTerminalsActive() || readCounter(GENERATION_OFFSET) != seenGeneration;
+}
+
+/* Record that the log has been emptied by this terminal */
+void noteLogTruncated(void) {
+    if (lockFd >= 0) {
+        seenGeneration = bumpCounter(GENERATION_OFFSET);
+    }
+}
+
+/* Record that this terminal has written a table's data file */
+void noteTableWritten(TableId table, int current) {
+    int version;
+
+    if (lockFd < 0) {
+        return;
+    }
+    version = bumpCounter(VERSION_OFFSET(table));
+    /* Only skip the refresh if nobody else wrote the file in between */
+    if (current && version == seenVersions[table] + 1) {
+        seenVersions[table] = version;
+    }
+}
+
+/* Record that a table has just been read from its data file */
+void noteTableLoaded(TableId table) {
+    if (lockFd >= 0) {
+        seenVersions[table] = readCounter(VERSION_OFFSET(table));
+    }
+}
+
+#endif
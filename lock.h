@@ -0,0 +1,163 @@
+/**
+ * Hotel Management System
+ * lock.h - Multi-terminal locking header
+ *
+ * This file contains declarations for the locking layer that lets
+ * several terminals share one data directory. Locks are fcntl byte-range
+ * locks on LOCK_FILE: each table owns a range in which one byte stands
+ * for each record slot, one for appends, and the whole range for
+ * rewrites of the data file. Locks taken inside a transaction are held
+ * until it commits; walCommit releases them.
+ *
+ * Whenever another terminal is running, each commit is written through
+ * to the data files before its locks are released, and a counter per
+ * table in LOCK_FILE records that the file changed. Taking a lock
+ * compares the counter with the one seen when the table was last read
+ * and re-reads the table, or the locked record, if another terminal has
+ * written it since.
+ *
+ * Within one transaction, take record locks before append locks and
+ * lock tables in TableId order where possible. fcntl detects a deadlock
+ * between terminals; the lock call then fails and the caller backs out.
+ */
+
+#ifndef LOCK_H
+#define LOCK_H
+
+#include "table.h"
+
+/* File paths */
+#define LOCK_FILE "data/hotel.lock"
+
+/**
+ * Discard the indexes built from a table so they are rebuilt
+ *
+ * Called when the table's records change other than through the
+ * indexes' own update functions, e.g. by another terminal or when a
+ * transaction is abandoned.
+ *
+ * @param table Table whose records changed
+ */
+void invalidateDerived(TableId table);
+
+/**
+ * Open the lock file and register this terminal
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int initializeLocking(void);
+
+/**
+ * Open the lock file without registering this terminal
+ *
+ * Used by clients of a server (see server.h). They lock records like
+ * any terminal, but only the server writes the data files, so it need
+ * not write its commits through for them.
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int attachLocking(void);
+
+/**
+ * Check whether another terminal is using the data directory
+ *
+ * @return 1 if another terminal is registered, 0 otherwise
+ */
+int otherTerminalsActive(void);
+
+/**
+ * Lock the record with a given id for the rest of the transaction
+ *
+ * Waits while another terminal holds the record, then re-reads it so
+ * the caller sees that terminal's last committed change. Succeeds
+ * without locking anything if no record has the id.
+ *
+ * @param table Table holding the record
+ * @param id Id of the record
+ * @return 1 if successful, 0 on error or deadlock
+ */
+int lockRecord(TableId table, int id);
+
+/**
+ * Lock a table against appends from other terminals
+ *
+ * Records appended elsewhere are read in first, so tableNextId and
+ * duplicate checks see them.
+ *
+ * @param table Table to append to
+ * @return 1 if successful, 0 on error or deadlock
+ */
+int lockAppend(TableId table);
+
+/**
+ * Lock a whole table, including every record and appends
+ *
+ * Required before rewriting the data file, as tableCompact does.
+ *
+ * @param table Table to lock
+ * @return 1 if successful, 0 on error or deadlock
+ */
+int lockTable(TableId table);
+
+/**
+ * Release every lock the calling thread holds on records and tables
+ */
+void releaseLocks(void);
+
+/**
+ * Re-read every loaded table that another terminal has changed
+ *
+ * Does nothing while the calling thread holds locks.
+ */
+void refreshTables(void);
+
+/**
+ * Take the lock serialising access to the write-ahead log
+ *
+ * Calls nest; the lock is released by the matching last unlockLog.
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int lockLog(void);
+
+/**
+ * Release the write-ahead log lock taken by lockLog
+ */
+void unlockLog(void);
+
+/**
+ * Check whether commits must be written through to the data files
+ *
+ * True while another terminal is running, or if another terminal has
+ * emptied the log since this one last did. Call with the log locked.
+ *
+ * @return 1 if commits must be written through, 0 otherwise
+ */
+int logShared(void);
+
+/**
+ * Record that the log has been emptied by this terminal
+ */
+void noteLogTruncated(void);
+
+/**
+ * Record that this terminal has written a table's data file
+ *
+ * A server also calls this when it changes a table for a client, so
+ * its other clients fetch the change.
+ *
+ * @param table Table that was written
+ * @param current Whether the cached table matches what was written
+ */
+void noteTableWritten(TableId table, int current);
+
+/**
+ * Record that a table has just been read from its data file
+ *
+ * Call before reading the file, so a change made meanwhile is noticed.
+ *
+ * @param table Table being read
+ */
+void noteTableLoaded(TableId table);
+
+#endif /* LOCK_H */
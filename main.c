@@ -18,6 +18,11 @@
  #include "fileio.h"
  #include "utils.h"
  #include "ui.h"
+ #include "wal.h"
+ #include "batch.h"
+ #include "lock.h"
+ #include "server.h"
+ #include "migrate.h"
  
  #define VERSION "1.0.1"
  
@@ -25,17 +30,69 @@
  void displayMainMenu(User *currentUser);
  void initializeSystem(void);
  void backupData(void);
+ void maintenanceMenu(void);
  void handleAdminMenu(int choice, User *currentUser);
  void handleStaffMenu(int choice, User *currentUser);
  
  /**
   * Main function - Entry point of the application
+  *
+  * Run with "--batch <file>" (or "--batch -" for standard input) to
+  * execute a command script instead of the interactive menus.
+  *
+  * Run with "--server" to serve the data directory to other terminals
+  * until interrupted, or "--client" to require a running server. Any
+  * terminal started while a server runs becomes its client.
+  *
+  * Run with "--migrate" to upgrade the data files to the current format
+  * and exit, instead of upgrading them when the system next starts.
   */
- int main(void) {
+ int main(int argc, char *argv[]) {
      int choice;
      User currentUser;
      int loggedIn = 0;
      
+     if (argc > 1 && strcmp(argv[1], "--server") == 0) {
+         initializeSystem();
+         return runServer();
+     }
+     
+     if (argc > 1 && strcmp(argv[1], "--migrate") == 0) {
+         createDirectoryIfNotExists("data");
+         if (connectServer() || !initializeLocking() || otherTerminalsActive()) {
+             printf("Stop every other terminal and the server before migrating the data files.\n");
+             return 1;
+         }
+         if (!migrateDataFiles()) {
+             printf("\nError: The data files could not be migrated.\n");
+             return 1;
+         }
+         printf("Data files are in format %d.\n", CURRENT_FORMAT_VERSION);
+         return 0;
+     }
+     
+     if (argc > 1 && strcmp(argv[1], "--client") == 0) {
+         if (!connectServer()) {
+             printf("No server is running. Start one with: %s --server\n", argv[0]);
+             return 1;
+         }
+         argv[1] = argv[0];
+         argc--;
+         argv++;
+     }
+     
+     if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+         int status;
+         if (argc != 3) {
+             printf("Usage: %s --batch <script file | ->\n", argv[0]);
+             return 1;
+         }
+         initializeSystem();
+         status = runBatch(argv[2]);
+         walCheckpoint();
+         return status;
+     }
+     
      /* Initialize the system */
      initializeSystem();
      
@@ -59,6 +116,7 @@
      
      /* Main program loop */
      do {
+         refreshTables(); /* Pick up changes made on other terminals */
          displayMainMenu(&currentUser);
          choice = getIntInput("Enter your choice: ", 0, 9);
          
@@ -74,6 +132,8 @@
          
      } while (choice != 0);
      
+     /* Fold the write-ahead log into the data files on a clean exit */
+     walCheckpoint();
      return 0;
  }
  
@@ -88,10 +148,7 @@
          case 4: billingManagementMenu(currentUser); break;
          case 5: reportsMenu(currentUser); break;
          case 6: userManagementMenu(currentUser); break;
-         case 7: 
-             backupData();
-             printf("\nSystem backup completed successfully.\n");
-             break;
+         case 7: maintenanceMenu(); break;
          case 8: changePassword(currentUser); break;
          case 9:
              printf("\nHotel Management System v%s\n", VERSION);
@@ -148,7 +205,7 @@
      if (currentUser->role == ROLE_ADMIN) {
          printf("5. Reports\n");
          printf("6. User Management\n");
-         printf("7. System Backup\n");
+         printf("7. System Maintenance\n");
      }
      printf("8. Change Password\n");
      printf("9. About\n");
@@ -165,8 +222,11 @@
      /* Create data directory if it doesn't exist */
      createDirectoryIfNotExists("data");
      
-     /* Initialize data files if they don't exist */
-     initializeDataFiles();
+     /* Initialize data files if they don't exist; never run on files that failed to load */
+     if (!initializeDataFiles()) {
+         printf("\nError: The data files could not be loaded. Exiting.\n");
+         exit(1);
+     }
      
      /* Load configuration */
      loadConfiguration();
@@ -191,4 +251,29 @@
      
      printf("Creating backup in directory: %s\n", backupDir);
      backupDataFiles(backupDir);
- }
\ No newline at end of file
+ }
+ 
+ /**
+  * System maintenance menu: backups and compaction of the data files
+  */
+ void maintenanceMenu(void) {
+     int choice;
+     
+     printf("\n===== SYSTEM MAINTENANCE =====\n");
+     printf("1. Back Up Data Files\n");
+     printf("2. Compact Data Files\n");
+     printf("0. Back\n");
+     choice = getIntInput("Enter your choice: ", 0, 2);
+     
+     switch (choice) {
+         case 1:
+             backupData();
+             printf("\nSystem backup completed successfully.\n");
+             break;
+         case 2:
+             if (compactDataFiles()) {
+                 printf("\nData files compacted successfully.\n");
+             }
+             break;
+     }
+ }
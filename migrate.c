@@ -0,0 +1,1068 @@
+/**
+ * Hotel Management System
+ * migrate.c - Data file format migration implementation
+ *
+ * This file implements the upgrade of data files between format
+ * versions. A migration runs as a series of steps, one per version,
+ * each listing the files it converts and the converter for their
+ * records. Records are streamed one at a time through the converter
+ * into a temporary file, so memory use does not depend on the size of
+ * the file being migrated, and large files report their progress. Text
+ * moved out of the records is appended to a copy of the text heap as
+ * the records are converted; values repeated across records are written
+ * once and shared.
+ *
+ * Once every file of a step has been written and flushed to disk, the
+ * step is committed by writing MIGRATION_FILE, and the temporary files
+ * are renamed over the originals. A step interrupted before then is
+ * redone from the untouched originals; one interrupted after is
+ * finished from MIGRATION_FILE on the next start.
+ *
+ * Format 5 puts a header in front of every data file. The next ids it
+ * holds come from the sequence file the header replaces. Format 6 dates
+ * each billing item; older items take the night a night audit named in
+ * their description, or else their invoice's issue date.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "migrate.h"
+#include "datafile.h"
+#include "fileio.h"
+#include "utils.h"
+#include "auth.h"
+#include "room.h"
+#include "guest.h"
+#include "reservation.h"
+#include "billing.h"
+#include "audit.h"
+#include "textheap.h"
+
+/* Format 5 billing item layout, also used by formats 1 to 4 */
+typedef struct {
+    int id;
+    int invoiceId;
+    BillingItemType type;
+    char description[MAX_BILLING_DESCRIPTION_LEN];
+    double unitPrice;
+    int quantity;
+    double amount;
+    int isActive;
+} BillingItemV5;
+
+/* A data file and the size of its records */
+typedef struct {
+    const char *path;
+    size_t recordSize;
+} DataFile;
+
+/* Every data file, in the order of their next ids in the format 4 sequence
+   file, with the record size it has in formats 4 and 5 */
+static const DataFile dataFiles[] = {
+    { ROOMS_FILE,         sizeof(Room) },
+    { GUESTS_FILE,        sizeof(Guest) },
+    { RESERVATIONS_FILE,  sizeof(Reservation) },
+    { INVOICES_FILE,      sizeof(Invoice) },
+    { BILLING_ITEMS_FILE, sizeof(BillingItemV5) },
+    { PAYMENTS_FILE,      sizeof(Payment) },
+    { USERS_FILE,         sizeof(User) },
+    { AUDITS_FILE,        sizeof(AuditRun) },
+    { TEXTS_FILE,         sizeof(TextBlock) }
+};
+
+#define DATA_FILE_COUNT ((int)(sizeof(dataFiles) / sizeof(dataFiles[0])))
+
+/* Directory holding the data files */
+#define DATA_DIRECTORY "data"
+
+/* stdio buffer size for the files being migrated */
+#define MIGRATE_BUFFER_SIZE (1 << 20)
+
+/* Files at least this large report their progress while being migrated */
+#define PROGRESS_MIN_BYTES (16L * 1024 * 1024)
+
+/* Format 1 reservation layout */
+typedef struct {
+    int id;
+    int guestId;
+    int roomId;
+    char checkInDate[11];
+    char checkOutDate[11];
+    ReservationStatus status;
+    int numGuests;
+    double totalAmount;
+    double paidAmount;
+    char creationDate[20];
+    int createdBy;
+    char notes[MAX_RESERVATION_NOTES_LEN];
+    int isActive;
+} ReservationV1;
+
+/* Format 1 invoice layout */
+typedef struct {
+    int id;
+    int guestId;
+    int reservationId;
+    char issueDate[11];
+    char dueDate[11];
+    double subtotal;
+    double taxAmount;
+    double discountAmount;
+    double totalAmount;
+    double paidAmount;
+    InvoiceStatus status;
+    char notes[MAX_NOTES_LEN];
+    int createdBy;
+    int isActive;
+} InvoiceV1;
+
+/* Format 1 payment layout */
+typedef struct {
+    int id;
+    int invoiceId;
+    PaymentMethod method;
+    PaymentStatus status;
+    double amount;
+    char transactionDate[11];
+    char transactionId[MAX_PAYMENT_REF_LEN];
+    char notes[MAX_NOTES_LEN];
+    int createdBy;
+    int isActive;
+} PaymentV1;
+
+/* Format 2 room layout */
+typedef struct {
+    int id;
+    RoomType type;
+    RoomStatus status;
+    double rate;
+    char description[MAX_ROOM_DESC_LEN];
+    char features[MAX_ROOM_FEATURES_LEN];
+    int capacity;
+    int floor;
+    int isActive;
+} RoomV2;
+
+/* Format 2 guest layout */
+typedef struct {
+    int id;
+    char name[MAX_GUEST_NAME_LEN];
+    char address[MAX_ADDRESS_LEN];
+    char phone[MAX_PHONE_LEN];
+    char email[MAX_EMAIL_LEN];
+    char idNumber[MAX_ID_NUMBER_LEN];
+    char idType[MAX_ID_TYPE_LEN];
+    char registrationDate[MAX_DATE_LEN];
+    int totalStays;
+    double totalSpent;
+    char notes[MAX_NOTES_LEN];
+    int isActive;
+    VipStatus vipStatus;
+} GuestV2;
+
+/* Format 2 reservation layout */
+typedef struct {
+    int id;
+    int guestId;
+    int roomId;
+    Date checkInDate;
+    Date checkOutDate;
+    ReservationStatus status;
+    int numGuests;
+    double totalAmount;
+    double paidAmount;
+    char creationDate[20];
+    int createdBy;
+    char notes[MAX_RESERVATION_NOTES_LEN];
+    int isActive;
+} ReservationV2;
+
+/* Format 2 invoice layout */
+typedef struct {
+    int id;
+    int guestId;
+    int reservationId;
+    Date issueDate;
+    Date dueDate;
+    double subtotal;
+    double taxAmount;
+    double discountAmount;
+    double totalAmount;
+    double paidAmount;
+    InvoiceStatus status;
+    char notes[MAX_NOTES_LEN];
+    int createdBy;
+    int isActive;
+} InvoiceV2;
+
+/* Format 2 payment layout */
+typedef struct {
+    int id;
+    int invoiceId;
+    PaymentMethod method;
+    PaymentStatus status;
+    double amount;
+    Date transactionDate;
+    char transactionId[MAX_PAYMENT_REF_LEN];
+    char notes[MAX_NOTES_LEN];
+    int createdBy;
+    int isActive;
+} PaymentV2;
+
+/* Format 3 guest layout */
+typedef struct {
+    int id;
+    char name[MAX_GUEST_NAME_LEN];
+    TextRef address;
+    char phone[MAX_PHONE_LEN];
+    char email[MAX_EMAIL_LEN];
+    char idNumber[MAX_ID_NUMBER_LEN];
+    char idType[MAX_ID_TYPE_LEN];
+    char registrationDate[MAX_DATE_LEN];
+    int totalStays;
+    double totalSpent;
+    TextRef notes;
+    int isActive;
+    VipStatus vipStatus;
+} GuestV3;
+
+/* Most distinct values shared by one migration step */
+#define MAX_SHARED_TEXTS 64
+
+/* A text written once for every record that holds the same value */
+typedef struct {
+    char text[MAX_ROOM_FEATURES_LEN];
+    TextRef ref;
+    long offset;                /* Position of its first block in the text heap */
+    int refs;
+} SharedText;
+
+static FILE *textOut = NULL;    /* Text heap being written by the converters */
+static int nextTextId = 1;      /* Id of the next text block written */
+static SharedText sharedTexts[MAX_SHARED_TEXTS];
+static int sharedTextCount = 0;
+
+/* Parse a format 1 date string, treating unreadable dates as day 0 */
+static Date convertDate(const char *dateStr) {
+    Date date;
+    return dateFromString(dateStr, &date) ? date : 0;
+}
+
+/* Convert a format 1 reservation */
+static int convertReservationV1(const void *oldRecord, void *newRecord) {
+    const ReservationV1 *old = oldRecord;
+    ReservationV2 *res = newRecord;
+
+    memset(res, 0, sizeof(ReservationV2));
+    res->id = old->id;
+    res->guestId = old->guestId;
+    res->roomId = old->roomId;
+    res->checkInDate = convertDate(old->checkInDate);
+    res->checkOutDate = convertDate(old->checkOutDate);
+    res->status = old->status;
+    res->numGuests = old->numGuests;
+    res->totalAmount = old->totalAmount;
+    res->paidAmount = old->paidAmount;
+    memcpy(res->creationDate, old->creationDate, sizeof(res->creationDate));
+    res->createdBy = old->createdBy;
+    memcpy(res->notes, old->notes, sizeof(res->notes));
+    res->isActive = old->isActive;
+    return 1;
+}
+
+/* Convert a format 1 invoice */
+static int convertInvoiceV1(const void *oldRecord, void *newRecord) {
+    const InvoiceV1 *old = oldRecord;
+    InvoiceV2 *inv = newRecord;
+
+    memset(inv, 0, sizeof(InvoiceV2));
+    inv->id = old->id;
+    inv->guestId = old->guestId;
+    inv->reservationId = old->reservationId;
+    inv->issueDate = convertDate(old->issueDate);
+    inv->dueDate = convertDate(old->dueDate);
+    inv->subtotal = old->subtotal;
+    inv->taxAmount = old->taxAmount;
+    inv->discountAmount = old->discountAmount;
+    inv->totalAmount = old->totalAmount;
+    inv->paidAmount = old->paidAmount;
+    inv->status = old->status;
+    memcpy(inv->notes, old->notes, sizeof(inv->notes));
+    inv->createdBy = old->createdBy;
+    inv->isActive = old->isActive;
+    return 1;
+}
+
+/* Convert a format 1 payment */
+static int convertPaymentV1(const void *oldRecord, void *newRecord) {
+    const PaymentV1 *old = oldRecord;
+    PaymentV2 *p = newRecord;
+
+    memset(p, 0, sizeof(PaymentV2));
+    p->id = old->id;
+    p->invoiceId = old->invoiceId;
+    p->method = old->method;
+    p->status = old->status;
+    p->amount = old->amount;
+    p->transactionDate = convertDate(old->transactionDate);
+    memcpy(p->transactionId, old->transactionId, sizeof(p->transactionId));
+    memcpy(p->notes, old->notes, sizeof(p->notes));
+    p->createdBy = old->createdBy;
+    p->isActive = old->isActive;
+    return 1;
+}
+
+/* Append a format 2 text field to the text heap, or -1 on failure */
+static TextRef moveText(const char *text, size_t size) {
+    size_t length = strnlen(text, size);
+    TextRef first = nextTextId;
+
+    if (length == 0) {
+        return 0;
+    }
+    for (size_t offset = 0; offset < length; offset += TEXT_BLOCK_LEN) {
+        TextBlock block;
+        size_t part = length - offset < TEXT_BLOCK_LEN ? length - offset : TEXT_BLOCK_LEN;
+
+        memset(&block, 0, sizeof(block));
+        block.id = nextTextId++;
+        block.next = offset + part < length ? nextTextId : 0;
+        memcpy(block.text, text + offset, part);
+        block.isActive = 1;
+        if (fwrite(&block, sizeof(block), 1, textOut) != 1) {
+            printf("\nError: Could not write %s.\n", TEXTS_FILE);
+            return -1;
+        }
+    }
+    return first;
+}
+
+/* Move a text field holding a commonly repeated value, sharing earlier copies */
+static TextRef moveSharedText(const char *text, size_t size) {
+    size_t length = strnlen(text, size);
+    SharedText *shared;
+
+    if (length == 0) {
+        return 0;
+    }
+    for (int i = 0; i < sharedTextCount; i++) {
+        if (strncmp(sharedTexts[i].text, text, length) == 0 && sharedTexts[i].text[length] == '\0') {
+            sharedTexts[i].refs++;
+            return sharedTexts[i].ref;
+        }
+    }
+    if (sharedTextCount == MAX_SHARED_TEXTS || length >= sizeof(shared->text)) {
+        return moveText(text, size);
+    }
+    shared = &sharedTexts[sharedTextCount];
+    shared->offset = ftell(textOut);
+    shared->ref = moveText(text, size);
+    if (shared->ref < 0) {
+        return -1;
+    }
+    memcpy(shared->text, text, length);
+    shared->text[length] = '\0';
+    shared->refs = 1;
+    sharedTextCount++;
+    return shared->ref;
+}
+
+/* Store the reference counts of the shared texts in their first blocks */
+static int finishSharedTexts(void) {
+    for (int i = 0; i < sharedTextCount; i++) {
+        if (fseek(textOut, sharedTexts[i].offset + (long)offsetof(TextBlock, isActive), SEEK_SET) != 0 ||
+            fwrite(&sharedTexts[i].refs, sizeof(int), 1, textOut) != 1) {
+            printf("\nError: Could not write %s.\n", TEXTS_FILE);
+            return 0;
+        }
+    }
+    sharedTextCount = 0;
+    return 1;
+}
+
+/* Start the text heap written by a migration step, copying the existing one if asked */
+static int openTextHeap(int copyExisting) {
+    char tempPath[256];
+    TextBlock block;
+    FILE *in;
+
+    sprintf(tempPath, "%s.tmp", TEXTS_FILE);
+    textOut = fopen(tempPath, "w+b");
+    if (textOut == NULL) {
+        printf("\nError: Could not create %s.\n", tempPath);
+        return 0;
+    }
+    nextTextId = 1;
+    sharedTextCount = 0;
+    in = copyExisting ? fopen(TEXTS_FILE, "rb") : NULL;
+    if (in == NULL) {
+        return 1;
+    }
+    /* Whole blocks only; a torn last block is dropped */
+    while (fread(&block, sizeof(block), 1, in) == 1) {
+        if (block.id >= nextTextId) {
+            nextTextId = block.id + 1;
+        }
+        if (fwrite(&block, sizeof(block), 1, textOut) != 1) {
+            printf("\nError: Could not write %s.\n", tempPath);
+            fclose(in);
+            return 0;
+        }
+    }
+    fclose(in);
+    return 1;
+}
+
+/* Convert a format 2 room */
+static int convertRoomV2(const void *oldRecord, void *newRecord) {
+    const RoomV2 *old = oldRecord;
+    Room *room = newRecord;
+
+    memset(room, 0, sizeof(Room));
+    room->id = old->id;
+    room->type = old->type;
+    room->status = old->status;
+    room->rate = old->rate;
+    room->description = moveSharedText(old->description, sizeof(old->description));
+    room->features = moveSharedText(old->features, sizeof(old->features));
+    room->capacity = old->capacity;
+    room->floor = old->floor;
+    room->isActive = old->isActive;
+    return room->description >= 0 && room->features >= 0;
+}
+
+/* Convert a format 2 guest */
+static int convertGuestV2(const void *oldRecord, void *newRecord) {
+    const GuestV2 *old = oldRecord;
+    GuestV3 *guest = newRecord;
+
+    memset(guest, 0, sizeof(GuestV3));
+    guest->id = old->id;
+    memcpy(guest->name, old->name, sizeof(guest->name));
+    guest->address = moveText(old->address, sizeof(old->address));
+    memcpy(guest->phone, old->phone, sizeof(guest->phone));
+    memcpy(guest->email, old->email, sizeof(guest->email));
+    memcpy(guest->idNumber, old->idNumber, sizeof(guest->idNumber));
+    memcpy(guest->idType, old->idType, sizeof(guest->idType));
+    memcpy(guest->registrationDate, old->registrationDate, sizeof(guest->registrationDate));
+    guest->totalStays = old->totalStays;
+    guest->totalSpent = old->totalSpent;
+    guest->notes = moveText(old->notes, sizeof(old->notes));
+    guest->isActive = old->isActive;
+    guest->vipStatus = old->vipStatus;
+    return guest->address >= 0 && guest->notes >= 0;
+}
+
+/* Convert a format 3 guest */
+static int convertGuestV3(const void *oldRecord, void *newRecord) {
+    const GuestV3 *old = oldRecord;
+    Guest *guest = newRecord;
+
+    memset(guest, 0, sizeof(Guest));
+    guest->id = old->id;
+    memcpy(guest->name, old->name, sizeof(guest->name));
+    guest->address = old->address;
+    memcpy(guest->phone, old->phone, sizeof(guest->phone));
+    memcpy(guest->email, old->email, sizeof(guest->email));
+    memcpy(guest->idNumber, old->idNumber, sizeof(guest->idNumber));
+    guest->idType = moveSharedText(old->idType, sizeof(old->idType));
+    memcpy(guest->registrationDate, old->registrationDate, sizeof(guest->registrationDate));
+    guest->totalStays = old->totalStays;
+    guest->totalSpent = old->totalSpent;
+    guest->notes = old->notes;
+    guest->isActive = old->isActive;
+    guest->vipStatus = old->vipStatus;
+    return guest->idType >= 0;
+}
+
+/* Convert a format 2 reservation */
+static int convertReservationV2(const void *oldRecord, void *newRecord) {
+    const ReservationV2 *old = oldRecord;
+    Reservation *res = newRecord;
+
+    memset(res, 0, sizeof(Reservation));
+    res->id = old->id;
+    res->guestId = old->guestId;
+    res->roomId = old->roomId;
+    res->checkInDate = old->checkInDate;
+    res->checkOutDate = old->checkOutDate;
+    res->status = old->status;
+    res->numGuests = old->numGuests;
+    res->totalAmount = old->totalAmount;
+    res->paidAmount = old->paidAmount;
+    memcpy(res->creationDate, old->creationDate, sizeof(res->creationDate));
+    res->createdBy = old->createdBy;
+    res->notes = moveText(old->notes, sizeof(old->notes));
+    res->isActive = old->isActive;
+    return res->notes >= 0;
+}
+
+/* Convert a format 2 invoice */
+static int convertInvoiceV2(const void *oldRecord, void *newRecord) {
+    const InvoiceV2 *old = oldRecord;
+    Invoice *inv = newRecord;
+
+    memset(inv, 0, sizeof(Invoice));
+    inv->id = old->id;
+    inv->guestId = old->guestId;
+    inv->reservationId = old->reservationId;
+    inv->issueDate = old->issueDate;
+    inv->dueDate = old->dueDate;
+    inv->subtotal = old->subtotal;
+    inv->taxAmount = old->taxAmount;
+    inv->discountAmount = old->discountAmount;
+    inv->totalAmount = old->totalAmount;
+    inv->paidAmount = old->paidAmount;
+    inv->status = old->status;
+    inv->notes = moveText(old->notes, sizeof(old->notes));
+    inv->createdBy = old->createdBy;
+    inv->isActive = old->isActive;
+    return inv->notes >= 0;
+}
+
+/* Convert a format 2 payment */
+static int convertPaymentV2(const void *oldRecord, void *newRecord) {
+    const PaymentV2 *old = oldRecord;
+    Payment *p = newRecord;
+
+    memset(p, 0, sizeof(Payment));
+    p->id = old->id;
+    p->invoiceId = old->invoiceId;
+    p->method = old->method;
+    p->status = old->status;
+    p->amount = old->amount;
+    p->transactionDate = old->transactionDate;
+    p->transactionId = moveText(old->transactionId, sizeof(old->transactionId));
+    p->notes = moveText(old->notes, sizeof(old->notes));
+    p->createdBy = old->createdBy;
+    p->isActive = old->isActive;
+    return p->transactionId >= 0 && p->notes >= 0;
+}
+
+
+/* Issue dates of the format 5 invoices, indexed by invoice id */
+static Date *invoiceDates = NULL;
+static int invoiceDateCount = 0;
+
+/* Find the day a format 5 billing item was posted for */
+static Date serviceDateV5(const BillingItemV5 *old) {
+    char description[MAX_BILLING_DESCRIPTION_LEN + 1];
+    const char *date = NULL;
+    Date day;
+
+    /* Night audit items name their night: "... night of <date>", "... (<date>)" */
+    memcpy(description, old->description, MAX_BILLING_DESCRIPTION_LEN);
+    description[MAX_BILLING_DESCRIPTION_LEN] = '\0';
+    if (old->type == BILLING_ITEM_ROOM_CHARGE && strstr(description, "night of ") != NULL) {
+        date = strstr(description, "night of ") + strlen("night of ");
+    } else if (old->type == BILLING_ITEM_TAX && strrchr(description, '(') != NULL) {
+        date = strrchr(description, '(') + 1;
+    }
+    if (date != NULL && dateFromString(date, &day)) {
+        return day;
+    }
+
+    /* Anything else was dated by its invoice until now */
+    if (old->invoiceId > 0 && old->invoiceId < invoiceDateCount) {
+        return invoiceDates[old->invoiceId];
+    }
+    return 0;
+}
+
+/* Convert a format 5 billing item */
+static int convertBillingItemV5(const void *oldRecord, void *newRecord) {
+    const BillingItemV5 *old = oldRecord;
+    BillingItem *item = newRecord;
+
+    memset(item, 0, sizeof(BillingItem));
+    item->id = old->id;
+    item->invoiceId = old->invoiceId;
+    item->type = old->type;
+    memcpy(item->description, old->description, sizeof(item->description));
+    item->unitPrice = old->unitPrice;
+    item->quantity = old->quantity;
+    item->amount = old->amount;
+    item->serviceDate = serviceDateV5(old);
+    item->isActive = old->isActive;
+    return 1;
+}
+
+/* Flush a file written by the migration to disk and close it */
+static int closeSynced(FILE *fp) {
+    int ok = fflush(fp) == 0;
+
+#if defined(_WIN32) || defined(_WIN64)
+    ok = ok && _commit(_fileno(fp)) == 0;
+#else
+    ok = ok && fsync(fileno(fp)) == 0;
+#endif
+    return fclose(fp) == 0 && ok;
+}
+
+/* Flush renames in the data directory to disk */
+static void syncDirectory(void) {
+#if !defined(_WIN32) && !defined(_WIN64)
+    int fd = open(DATA_DIRECTORY, O_RDONLY);
+
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+/* A data file converted by a migration step */
+typedef struct {
+    int fromVersion;            /* Format the step upgrades from */
+    const char *path;
+    size_t oldSize;
+    size_t newSize;
+    int (*convert)(const void *oldRecord, void *newRecord);    /* NULL copies records unchanged */
+} Conversion;
+
+/* Record conversions of each step, in the order they run */
+static const Conversion conversions[] = {
+    { 1, RESERVATIONS_FILE, sizeof(ReservationV1), sizeof(ReservationV2), convertReservationV1 },
+    { 1, INVOICES_FILE,     sizeof(InvoiceV1),     sizeof(InvoiceV2),     convertInvoiceV1 },
+    { 1, PAYMENTS_FILE,     sizeof(PaymentV1),     sizeof(PaymentV2),     convertPaymentV1 },
+    { 2, ROOMS_FILE,        sizeof(RoomV2),        sizeof(Room),          convertRoomV2 },
+    { 2, GUESTS_FILE,       sizeof(GuestV2),       sizeof(GuestV3),       convertGuestV2 },
+    { 2, RESERVATIONS_FILE, sizeof(ReservationV2), sizeof(Reservation),   convertReservationV2 },
+    { 2, INVOICES_FILE,     sizeof(InvoiceV2),     sizeof(Invoice),       convertInvoiceV2 },
+    { 2, PAYMENTS_FILE,     sizeof(PaymentV2),     sizeof(Payment),       convertPaymentV2 },
+    { 3, GUESTS_FILE,       sizeof(GuestV3),       sizeof(Guest),         convertGuestV3 },
+    { 5, BILLING_ITEMS_FILE, sizeof(BillingItemV5), sizeof(BillingItem),  convertBillingItemV5 }
+};
+
+#define CONVERSION_COUNT ((int)(sizeof(conversions) / sizeof(conversions[0])))
+
+/* Next ids from the format 4 sequence file */
+static int sequences[DATA_FILE_COUNT];
+
+/* Records converted in each data file, reported once the upgrade is done */
+static int migratedRecords[DATA_FILE_COUNT];
+
+/* Start a step that moves text into a new text heap */
+static int beginNewTextHeap(void) {
+    return openTextHeap(0);
+}
+
+/* Start a step that moves text into the existing text heap */
+static int beginTextHeap(void) {
+    return openTextHeap(1);
+}
+
+/* Complete the text heap written by a step */
+static int finishTextHeap(int ok) {
+    ok = ok && finishSharedTexts();
+    if (!closeSynced(textOut) && ok) {
+        printf("\nError: Could not write %s.tmp.\n", TEXTS_FILE);
+        ok = 0;
+    }
+    textOut = NULL;
+    return ok;
+}
+
+/* Read the next ids of the format 4 sequence file */
+static int readSequences(void) {
+    FILE *fp = fopen(SEQUENCES_FILE, "rb");
+
+    /* Missing entries stay 0; the next ids are also derived from the records */
+    memset(sequences, 0, sizeof(sequences));
+    for (int i = 0; fp != NULL && i < DATA_FILE_COUNT; i++) {
+        if (fread(&sequences[i], sizeof(int), 1, fp) != 1) {
+            break;
+        }
+    }
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    return 1;
+}
+
+/* Read the issue date of every invoice, which dated billing items before format 6 */
+static int readInvoiceDates(void) {
+    FILE *fp = fopen(INVOICES_FILE, "rb");
+    DataHeader header;
+    Invoice invoice;
+
+    invoiceDateCount = 0;
+    if (fp == NULL || fseek(fp, 0, SEEK_END) != 0 || ftell(fp) == 0) {
+        if (fp != NULL) fclose(fp);
+        return 1; /* No invoices, so no billing items to date */
+    }
+    if (!readDataHeader(fp, &header) || header.recordSize != (int)sizeof(Invoice)) {
+        printf("\nError: %s has an unexpected header for its format; not migrating.\n", INVOICES_FILE);
+        fclose(fp);
+        return 0;
+    }
+    invoiceDates = calloc((size_t)header.nextId + 1, sizeof(Date));
+    if (invoiceDates == NULL) {
+        printf("\nError: Out of memory.\n");
+        fclose(fp);
+        return 0;
+    }
+    invoiceDateCount = header.nextId + 1;
+    setvbuf(fp, NULL, _IOFBF, MIGRATE_BUFFER_SIZE);
+    for (int i = 0; i < header.count && fread(&invoice, sizeof(invoice), 1, fp) == 1; i++) {
+        if (invoice.id > 0 && invoice.id < invoiceDateCount) {
+            invoiceDates[invoice.id] = invoice.issueDate;
+        }
+    }
+    fclose(fp);
+    return 1;
+}
+
+/* Drop the invoice dates once the billing items are converted */
+static int finishInvoiceDates(int ok) {
+    free(invoiceDates);
+    invoiceDates = NULL;
+    invoiceDateCount = 0;
+    return ok;
+}
+
+/* One step of the migration, from a format version to the next */
+typedef struct {
+    int fromVersion;
+    int copyAll;                /* Copy every data file behind a header instead of converting */
+    int (*begin)(void);         /* Called before the files are converted, or NULL */
+    int (*finish)(int ok);      /* Called after they are, or NULL */
+} MigrationStep;
+
+static const MigrationStep migrationSteps[] = {
+    { 1, 0, NULL,             NULL },
+    { 2, 0, beginNewTextHeap, finishTextHeap },
+    { 3, 0, beginTextHeap,    finishTextHeap },
+    { 4, 1, readSequences,    NULL },
+    { 5, 1, readInvoiceDates, finishInvoiceDates }
+};
+
+#define MIGRATION_STEP_COUNT ((int)(sizeof(migrationSteps) / sizeof(migrationSteps[0])))
+
+/* Show how far through a large file the migration is */
+static void showProgress(const char *path, long done, long total, int *shown) {
+    int percent = (int)((double)done * 100.0 / (double)total);
+
+    if (percent != *shown) {
+        printf("\rMigrating %s: %3d%%", path, percent);
+        fflush(stdout);
+        *shown = percent;
+    }
+}
+
+/* Stream a data file through a record converter into its temporary file */
+static int convertFile(const Conversion *conv, int nextId) {
+    char tempPath[256];
+    int toVersion = conv->fromVersion + 1;
+    DataHeader header;
+    FILE *in, *out;
+    void *oldRecord, *newRecord;
+    long fileSize, dataStart = 0;
+    int expected, converted = 0, shown = -1;
+    int ok;
+
+    in = fopen(conv->path, "rb");
+    if (in == NULL) {
+        return 1; /* Nothing to migrate */
+    }
+
+    fseek(in, 0, SEEK_END);
+    fileSize = ftell(in);
+    if (fileSize == 0) {
+        fclose(in);
+        return 1; /* Still empty; it gets a current header with its first records */
+    }
+    if (readDataHeader(in, &header)) {
+        if (header.schemaVersion > conv->fromVersion) {
+            fclose(in);
+            return 1; /* Already in a later format */
+        }
+        if (header.schemaVersion < conv->fromVersion || header.recordSize != (int)conv->oldSize ||
+            header.count < 0 || header.count > (fileSize - (long)sizeof(header)) / (long)conv->oldSize) {
+            printf("\nError: %s has an unexpected header for its format; not migrating.\n", conv->path);
+            fclose(in);
+            return 0;
+        }
+        dataStart = (long)sizeof(header);
+        expected = header.count;
+        if (header.nextId > nextId) {
+            nextId = header.nextId;
+        }
+    } else if (conv->fromVersion >= HEADER_FORMAT_VERSION || fileSize % (long)conv->oldSize != 0) {
+        printf("\nError: %s has an unexpected size for its format; not migrating.\n", conv->path);
+        fclose(in);
+        return 0;
+    } else {
+        expected = (int)(fileSize / (long)conv->oldSize);
+    }
+    fseek(in, dataStart, SEEK_SET);
+
+    sprintf(tempPath, "%s.tmp", conv->path);
+    out = fopen(tempPath, "wb");
+    oldRecord = malloc(conv->oldSize);
+    newRecord = malloc(conv->newSize);
+    if (out == NULL || oldRecord == NULL || newRecord == NULL) {
+        printf("\nError: Could not create temporary file.\n");
+        if (out != NULL) fclose(out);
+        free(oldRecord);
+        free(newRecord);
+        fclose(in);
+        return 0;
+    }
+    setvbuf(in, NULL, _IOFBF, MIGRATE_BUFFER_SIZE);
+    setvbuf(out, NULL, _IOFBF, MIGRATE_BUFFER_SIZE);
+
+    /* The header is written last, once the records have been counted */
+    ok = 1;
+    if (toVersion >= HEADER_FORMAT_VERSION) {
+        initVersionedHeader(&header, toVersion, conv->newSize, 0, 0);
+        ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    }
+    while (ok && converted < expected && fread(oldRecord, conv->oldSize, 1, in) == 1) {
+        const void *record = oldRecord;
+        int id;
+
+        memcpy(&id, oldRecord, sizeof(id));
+        if (id >= nextId) {
+            nextId = id + 1;
+        }
+        if (conv->convert != NULL) {
+            ok = conv->convert(oldRecord, newRecord);
+            record = newRecord;
+        }
+        ok = ok && fwrite(record, conv->newSize, 1, out) == 1;
+        converted++;
+        if (fileSize >= PROGRESS_MIN_BYTES && (converted % 4096 == 0 || converted == expected)) {
+            showProgress(conv->path, converted, expected, &shown);
+        }
+    }
+    if (shown >= 0) {
+        printf("\n");
+    }
+    fclose(in);
+    free(oldRecord);
+    free(newRecord);
+
+    if (ok && converted != expected) {
+        printf("\nError: Could not read %s.\n", conv->path);
+        fclose(out);
+        return 0;
+    }
+    if (ok && toVersion >= HEADER_FORMAT_VERSION) {
+        initVersionedHeader(&header, toVersion, conv->newSize, converted, nextId > 0 ? nextId : 1);
+        ok = fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+    }
+    if (!closeSynced(out) || !ok) {
+        printf("\nError: Could not write %s.\n", tempPath);
+        return 0;
+    }
+
+    /* Each step converts the same records; count them once */
+    for (int i = 0; i < DATA_FILE_COUNT; i++) {
+        if (strcmp(dataFiles[i].path, conv->path) == 0 && converted > migratedRecords[i]) {
+            migratedRecords[i] = converted;
+        }
+    }
+    return 1;
+}
+
+/* Remove the temporary files of an unfinished migration step */
+static void discardTempFiles(void) {
+    char tempPath[256];
+
+    for (int i = 0; i < DATA_FILE_COUNT; i++) {
+        sprintf(tempPath, "%s.tmp", dataFiles[i].path);
+        remove(tempPath);
+    }
+}
+
+/* Write a format version to a file and flush it to disk */
+static int writeVersionFile(const char *path, int version) {
+    FILE *fp = fopen(path, "wb");
+
+    if (fp == NULL || fwrite(&version, sizeof(int), 1, fp) != 1 || !closeSynced(fp)) {
+        printf("\nError: Could not write %s.\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+/* Replace the data files with those written by a migration step and record the new version */
+static int completeStep(int version) {
+    char tempPath[256];
+
+    for (int i = 0; i < DATA_FILE_COUNT; i++) {
+        sprintf(tempPath, "%s.tmp", dataFiles[i].path);
+        if (!fileExists(tempPath)) {
+            continue;
+        }
+        /* rename replaces the file atomically except on Windows, where the target has
+           to be removed first; MIGRATION_FILE lets a restart finish the job */
+#if defined(_WIN32) || defined(_WIN64)
+        remove(dataFiles[i].path);
+#endif
+        if (rename(tempPath, dataFiles[i].path) != 0) {
+            printf("\nError: Could not replace %s.\n", dataFiles[i].path);
+            return 0;
+        }
+    }
+    syncDirectory();
+
+    if (version >= HEADER_FORMAT_VERSION) {
+        /* The headers hold the version and next ids from here on */
+        remove(SEQUENCES_FILE);
+        remove(FORMAT_FILE);
+    } else if (!writeVersionFile(FORMAT_FILE, version)) {
+        return 0;
+    }
+    remove(MIGRATION_FILE);
+    syncDirectory();
+    return 1;
+}
+
+/* Run one migration step: convert its files, then swap them all in */
+static int migrateStep(const MigrationStep *step) {
+    int ok;
+
+    discardTempFiles();
+    if (step->begin != NULL && !step->begin()) {
+        discardTempFiles();
+        return 0;
+    }
+    ok = 1;
+    if (step->copyAll) {
+        /* Every header takes the new version; files the step changes are converted */
+        for (int i = 0; ok && i < DATA_FILE_COUNT; i++) {
+            Conversion copy = { step->fromVersion, dataFiles[i].path,
+                                dataFiles[i].recordSize, dataFiles[i].recordSize, NULL };
+            for (int j = 0; j < CONVERSION_COUNT; j++) {
+                if (conversions[j].fromVersion == step->fromVersion &&
+                    strcmp(conversions[j].path, dataFiles[i].path) == 0) {
+                    copy = conversions[j];
+                }
+            }
+            ok = convertFile(&copy, sequences[i]);
+        }
+    } else {
+        for (int i = 0; ok && i < CONVERSION_COUNT; i++) {
+            if (conversions[i].fromVersion == step->fromVersion) {
+                ok = convertFile(&conversions[i], 0);
+            }
+        }
+    }
+    if (step->finish != NULL) {
+        ok = step->finish(ok);
+    }
+    if (!ok) {
+        discardTempFiles();
+        return 0;
+    }
+
+    /* Once MIGRATION_FILE is written the step counts as done */
+    return writeVersionFile(MIGRATION_FILE, step->fromVersion + 1) &&
+           completeStep(step->fromVersion + 1);
+}
+
+/* Finish a migration step interrupted while its files were being swapped in */
+static int resumeMigration(void) {
+    FILE *fp = fopen(MIGRATION_FILE, "rb");
+    int version;
+    int ok;
+
+    if (fp == NULL) {
+        return 1;
+    }
+    ok = fread(&version, sizeof(int), 1, fp) == 1;
+    fclose(fp);
+    if (!ok) {
+        /* Torn while being written, so the step never committed */
+        discardTempFiles();
+        remove(MIGRATION_FILE);
+        return 1;
+    }
+    printf("\nCompleting an interrupted upgrade to data format %d.\n", version);
+    return completeStep(version);
+}
+
+/* Read the format version of the data files */
+static int readFormatVersion(void) {
+    FILE *fp;
+    int version = CURRENT_FORMAT_VERSION;
+    int headed = 0, headerless = 0;
+
+    fp = fopen(FORMAT_FILE, "rb");
+    if (fp != NULL) {
+        if (fread(&version, sizeof(int), 1, fp) != 1) {
+            version = 1;
+        }
+        fclose(fp);
+        return version;
+    }
+
+    /* Since format 5 the version is in each file's header; the oldest file decides */
+    for (int i = 0; i < DATA_FILE_COUNT; i++) {
+        DataHeader header;
+
+        fp = fopen(dataFiles[i].path, "rb");
+        if (fp == NULL) {
+            continue;
+        }
+        if (readDataHeader(fp, &header)) {
+            headed = 1;
+            if (header.schemaVersion < version) {
+                version = header.schemaVersion;
+            }
+        } else if (fseek(fp, 0, SEEK_END) == 0 && ftell(fp) > 0) {
+            headerless = 1;
+        }
+        fclose(fp);
+    }
+    if (headerless) {
+        /* Files written before versioning are format 1; headerless files
+           next to headed ones were left by an older program */
+        return headed ? (version < HEADER_FORMAT_VERSION ? version : HEADER_FORMAT_VERSION - 1) : 1;
+    }
+    return version; /* No files yet: they are created in the current format */
+}
+
+/* Bring all data files up to the current format version */
+int migrateDataFiles(void) {
+    int version;
+
+    if (!resumeMigration()) {
+        return 0;
+    }
+    version = readFormatVersion();
+    if (version > CURRENT_FORMAT_VERSION) {
+        printf("\nError: Data files use format %d, but this program only supports up to format %d.\n",
+               version, CURRENT_FORMAT_VERSION);
+        return 0;
+    }
+    if (version < CURRENT_FORMAT_VERSION) {
+        printf("\nUpgrading data files from format %d to format %d.\n", version, CURRENT_FORMAT_VERSION);
+    }
+
+    for (int i = 0; i < MIGRATION_STEP_COUNT; i++) {
+        if (migrationSteps[i].fromVersion == version) {
+            if (!migrateStep(&migrationSteps[i])) {
+                return 0;
+            }
+            version++;
+        }
+    }
+
+    for (int i = 0; i < DATA_FILE_COUNT; i++) {
+        if (migratedRecords[i] > 0) {
+            printf("\nMigrated %d record(s) in %s.\n", migratedRecords[i], dataFiles[i].path);
+        }
+    }
+    return 1;
+}
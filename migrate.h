@@ -0,0 +1,51 @@
+/**
+ * Hotel Management System
+ * migrate.h - Data file format migration header
+ *
+ * This file contains declarations for upgrading the data files when
+ * the on-disk record layout changes. Since format 5 every data file
+ * records its format version in its header (see datafile.h). Earlier
+ * formats kept it in FORMAT_FILE, and headerless files without one are
+ * format 1.
+ */
+
+#ifndef MIGRATE_H
+#define MIGRATE_H
+
+/* Files replaced by the data file headers in format 5 */
+#define FORMAT_FILE "data/format.dat"
+#define SEQUENCES_FILE "data/sequences.dat"
+
+/* Written while a migration step replaces the data files; holds the version it upgrades to */
+#define MIGRATION_FILE "data/migration.dat"
+
+/*
+ * Format versions:
+ *   1 - Dates stored as YYYY-MM-DD strings
+ *   2 - Reservation, invoice and payment dates stored as day numbers
+ *   3 - Free-text fields moved to the text heap
+ *   4 - Guest ID types moved to the text heap; repeated texts shared
+ *   5 - Each data file starts with a header holding its format version,
+ *       record size, record count and next id
+ *   6 - Billing items carry the day they were posted for
+ */
+#define CURRENT_FORMAT_VERSION 6
+
+/* First format version whose data files start with a header */
+#define HEADER_FORMAT_VERSION 5
+
+/**
+ * Bring all data files up to the current format version
+ *
+ * Runs one step per version from the files' format to the current one.
+ * Each step streams its files one record at a time into temporary
+ * files, flushes them to disk and then swaps them all in, so a failed
+ * step leaves the old files intact and a step interrupted while
+ * swapping is finished by the next call. To add a format version,
+ * keep the old record layouts and add a step with their converters.
+ *
+ * @return 1 if successful or nothing to do, 0 otherwise
+ */
+int migrateDataFiles(void);
+
+#endif /* MIGRATE_H */
@@ -0,0 +1,269 @@
+/**
+ * Hotel Management System
+ * occupancy.c - Occupancy aggregates implementation
+ *
+ * This file implements the daily occupancy aggregates. Each day is a
+ * row of counters: occupied and booked nights followed by one counter
+ * per room type and one per floor. Rows are kept in a single array
+ * covering the days spanned by counted stays, which grows at either end
+ * when a stay falls outside it. Adding or removing a stay touches one
+ * row per night; a report sums one row per day of its range.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "occupancy.h"
+#include "room.h"
+#include "table.h"
+#include "ui.h"
+#include "utils.h"
+
+/* Counters in one day's row */
+#define COL_OCCUPIED 0
+#define COL_BOOKED 1
+#define COL_TYPE 2
+#define COL_FLOOR (COL_TYPE + OCCUPANCY_ROOM_TYPES)
+#define ROW_COLUMNS (COL_FLOOR + OCCUPANCY_MAX_FLOOR + 1)
+
+#define GROWTH_SLACK_DAYS 366
+
+static int *rows = NULL;        /* rowDays rows of ROW_COLUMNS counters */
+static Date rowStart = 0;       /* Day number of the first row */
+static int rowDays = 0;
+static int built = 0;
+
+/* Check whether a reservation's nights count as sold */
+static int isSold(const Reservation *res) {
+    return res->isActive &&
+           (res->status == RESERVATION_STATUS_CONFIRMED ||
+            res->status == RESERVATION_STATUS_CHECKED_IN ||
+            res->status == RESERVATION_STATUS_CHECKED_OUT);
+}
+
+/* Make sure rows exist for the days [start, end) */
+static int ensureDays(Date start, Date end) {
+    Date newStart;
+    int newDays;
+    int *newRows;
+
+    if (rowDays > 0 && start >= rowStart && end <= rowStart + rowDays) {
+        return 1;
+    }
+
+    // Grow with slack on the side that ran out so runs of new bookings do not copy every time
+    newStart = rowDays == 0 ? start : (start < rowStart ? start - GROWTH_SLACK_DAYS : rowStart);
+    newDays = (rowDays == 0 ? end : (end > rowStart + rowDays ? end + GROWTH_SLACK_DAYS : rowStart + rowDays)) - newStart;
+
+    newRows = calloc((size_t)newDays * ROW_COLUMNS, sizeof(int));
+    if (newRows == NULL) {
+        printf("\nError: Out of memory while building occupancy aggregates.\n");
+        return 0;
+    }
+    if (rows != NULL) {
+        memcpy(newRows + (size_t)(rowStart - newStart) * ROW_COLUMNS, rows,
+               (size_t)rowDays * ROW_COLUMNS * sizeof(int));
+        free(rows);
+    }
+    rows = newRows;
+    rowStart = newStart;
+    rowDays = newDays;
+    return 1;
+}
+
+/* Add (delta 1) or remove (delta -1) the nights of a stay */
+static void countStay(const Reservation *res, int delta) {
+    Table *rooms = getTable(TABLE_ROOMS);
+    int roomSlot = tableLookup(rooms, res->roomId);
+    int statusColumn = res->status == RESERVATION_STATUS_CONFIRMED ? COL_BOOKED : COL_OCCUPIED;
+    int typeColumn = -1, floorColumn = -1;
+
+    if (res->checkInDate >= res->checkOutDate || !ensureDays(res->checkInDate, res->checkOutDate)) {
+        return;
+    }
+
+    if (roomSlot >= 0) {
+        Room *room = tableRecord(rooms, roomSlot);
+        if (room->type > 0 && room->type < OCCUPANCY_ROOM_TYPES) {
+            typeColumn = COL_TYPE + room->type;
+        }
+        if (room->floor >= 0 && room->floor <= OCCUPANCY_MAX_FLOOR) {
+            floorColumn = COL_FLOOR + room->floor;
+        }
+    }
+
+    for (Date day = res->checkInDate; day < res->checkOutDate; day++) {
+        int *row = &rows[(size_t)(day - rowStart) * ROW_COLUMNS];
+        row[statusColumn] += delta;
+        if (typeColumn >= 0) row[typeColumn] += delta;
+        if (floorColumn >= 0) row[floorColumn] += delta;
+    }
+}
+
+/* Build the daily aggregates from the reservation table */
+int buildOccupancy(void) {
+    Table *reservations = getTable(TABLE_RESERVATIONS);
+    Reservation *all = TABLE_RECORDS(reservations, Reservation);
+    Date first = 0, last = 0;
+    int any = 0;
+
+    // Size the rows for the whole history up front
+    for (int i = 0; i < reservations->count; i++) {
+        if (isSold(&all[i]) && all[i].checkInDate < all[i].checkOutDate) {
+            if (!any || all[i].checkInDate < first) first = all[i].checkInDate;
+            if (!any || all[i].checkOutDate > last) last = all[i].checkOutDate;
+            any = 1;
+        }
+    }
+
+    free(rows);
+    rows = NULL;
+    rowDays = 0;
+    built = 1;
+    if (!any) {
+        return 1;
+    }
+    if (!ensureDays(first, last + GROWTH_SLACK_DAYS)) {
+        built = 0;
+        return 0;
+    }
+
+    for (int i = 0; i < reservations->count; i++) {
+        if (isSold(&all[i])) {
+            countStay(&all[i], 1);
+        }
+    }
+    return 1;
+}
+
+/* Update the daily aggregates after a reservation changes */
+void occupancyUpdate(const Reservation *before, const Reservation *after) {
+    if (!built) {
+        return; /* Built from the table, which already holds the change, when first needed */
+    }
+
+    if (before != NULL && isSold(before)) {
+        countStay(before, -1);
+    }
+    if (after != NULL && isSold(after)) {
+        countStay(after, 1);
+    }
+}
+
+/* Discard the aggregates so the next report rebuilds them */
+void invalidateOccupancy(void) {
+    built = 0;
+}
+
+/* Total the aggregates over a range of nights */
+int getOccupancy(Date from, Date to, OccupancyReport *report) {
+    Table *rooms = getTable(TABLE_ROOMS);
+    int totals[ROW_COLUMNS] = {0};
+    Date start, end;
+
+    if (!built && !buildOccupancy()) {
+        return 0;
+    }
+
+    memset(report, 0, sizeof(*report));
+    report->from = from;
+    report->to = to;
+
+    for (int slot = 0; slot < rooms->count; slot++) {
+        Room *room = tableRecord(rooms, slot);
+        if (!room->isActive) {
+            continue;
+        }
+        report->roomsAvailable++;
+        if (room->type > 0 && room->type < OCCUPANCY_ROOM_TYPES) {
+            report->roomsByType[room->type]++;
+        }
+        if (room->floor >= 0 && room->floor <= OCCUPANCY_MAX_FLOOR) {
+            report->roomsByFloor[room->floor]++;
+        }
+    }
+
+    start = from > rowStart ? from : rowStart;
+    end = to < rowStart + rowDays ? to : rowStart + rowDays;
+    for (Date day = start; day < end; day++) {
+        const int *row = &rows[(size_t)(day - rowStart) * ROW_COLUMNS];
+        for (int c = 0; c < ROW_COLUMNS; c++) {
+            totals[c] += row[c];
+        }
+    }
+
+    report->occupiedNights = totals[COL_OCCUPIED];
+    report->bookedNights = totals[COL_BOOKED];
+    for (int t = 0; t < OCCUPANCY_ROOM_TYPES; t++) {
+        report->nightsByType[t] = totals[COL_TYPE + t];
+    }
+    for (int f = 0; f <= OCCUPANCY_MAX_FLOOR; f++) {
+        report->nightsByFloor[f] = totals[COL_FLOOR + f];
+    }
+    return 1;
+}
+
+/* Percentage of available room nights that were sold */
+static double occupancyPercent(int nights, int rooms, int days) {
+    return rooms > 0 && days > 0 ? 100.0 * nights / ((double)rooms * days) : 0.0;
+}
+
+/* Print the occupancy report for a range of nights */
+int printOccupancyReport(Date from, Date to) {
+    char startDate[DATE_STRING_LEN], endDate[DATE_STRING_LEN];
+    OccupancyReport report;
+    int days = to - from, sold;
+
+    if (!getOccupancy(from, to, &report)) {
+        return 0;
+    }
+
+    dateToString(from, startDate);
+    dateToString(to - 1, endDate);
+    sold = report.occupiedNights + report.bookedNights;
+    printf("\nPeriod: %s to %s (%d night(s)), %d room(s)\n", startDate, endDate, days, report.roomsAvailable);
+    printf("%-28s %d\n", "Available room nights:", report.roomsAvailable * days);
+    printf("%-28s %d\n", "Occupied room nights:", report.occupiedNights);
+    printf("%-28s %d\n", "Booked (not arrived):", report.bookedNights);
+    printf("%-28s %.1f%%\n", "Occupancy:", occupancyPercent(sold, report.roomsAvailable, days));
+
+    printf("\n%-15s %-8s %-12s %-10s\n", "Room Type", "Rooms", "Nights Sold", "Occupancy");
+    printf("------------------------------------------------\n");
+    for (int t = 1; t < OCCUPANCY_ROOM_TYPES; t++) {
+        if (report.roomsByType[t] > 0 || report.nightsByType[t] > 0) {
+            printf("%-15s %-8d %-12d %.1f%%\n", getRoomTypeString((RoomType)t), report.roomsByType[t],
+                   report.nightsByType[t], occupancyPercent(report.nightsByType[t], report.roomsByType[t], days));
+        }
+    }
+
+    printf("\n%-15s %-8s %-12s %-10s\n", "Floor", "Rooms", "Nights Sold", "Occupancy");
+    printf("------------------------------------------------\n");
+    for (int f = 0; f <= OCCUPANCY_MAX_FLOOR; f++) {
+        if (report.roomsByFloor[f] > 0 || report.nightsByFloor[f] > 0) {
+            printf("%-15d %-8d %-12d %.1f%%\n", f, report.roomsByFloor[f],
+                   report.nightsByFloor[f], occupancyPercent(report.nightsByFloor[f], report.roomsByFloor[f], days));
+        }
+    }
+    return 1;
+}
+
+/* Prompt for a date range and print the occupancy report */
+void occupancyReportMenu(User *currentUser) {
+    char startDate[DATE_STRING_LEN], endDate[DATE_STRING_LEN];
+    Date from, last;
+
+    clearScreen();
+    displayHeader("Occupancy Report");
+
+    printf("Enter first night (YYYY-MM-DD): ");
+    getStringInput(NULL, startDate, DATE_STRING_LEN);
+    printf("Enter last night (YYYY-MM-DD): ");
+    getStringInput(NULL, endDate, DATE_STRING_LEN);
+    if (!validateDate(startDate) || !validateDate(endDate) ||
+        !dateFromString(startDate, &from) || !dateFromString(endDate, &last) || last < from) {
+        printf("\nInvalid dates. The last night must not be before the first.\n");
+        return;
+    }
+
+    printOccupancyReport(from, last + 1);
+}
@@ -0,0 +1,87 @@
+/**
+ * Hotel Management System
+ * occupancy.h - Occupancy aggregates header
+ *
+ * This file contains declarations for the daily occupancy aggregates.
+ * For every day the aggregates count the room nights sold, split into
+ * stays that have checked in (in-house or departed) and confirmed
+ * bookings still to arrive, and break the total down by room type and
+ * floor. They are built once from the reservation table and updated on
+ * every reservation change, so a report over any range only sums one
+ * row per day.
+ */
+
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include "reservation.h"
+
+/* Room types and floors covered by the breakdowns */
+#define OCCUPANCY_ROOM_TYPES (ROOM_TYPE_PRESIDENTIAL + 1)
+#define OCCUPANCY_MAX_FLOOR 100
+
+/* Occupancy totals for a range of days */
+typedef struct {
+    Date from;                                      /* First night of the range */
+    Date to;                                        /* Day after the last night */
+    int roomsAvailable;                             /* Active rooms */
+    int occupiedNights;                             /* Nights of checked-in and checked-out stays */
+    int bookedNights;                               /* Nights of confirmed stays */
+    int nightsByType[OCCUPANCY_ROOM_TYPES];         /* Sold nights by room type */
+    int roomsByType[OCCUPANCY_ROOM_TYPES];          /* Active rooms by room type */
+    int nightsByFloor[OCCUPANCY_MAX_FLOOR + 1];     /* Sold nights by floor */
+    int roomsByFloor[OCCUPANCY_MAX_FLOOR + 1];      /* Active rooms by floor */
+} OccupancyReport;
+
+/**
+ * Build the daily aggregates from the reservation table
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int buildOccupancy(void);
+
+/**
+ * Update the daily aggregates after a reservation changes
+ *
+ * Either pointer may be NULL, as for availabilityUpdate.
+ *
+ * @param before Reservation as it was before the change, or NULL
+ * @param after Reservation as it is after the change, or NULL
+ */
+void occupancyUpdate(const Reservation *before, const Reservation *after);
+
+/**
+ * Discard the aggregates so the next report rebuilds them
+ *
+ * Call this when a room's type or floor changes, since nights are
+ * attributed to the room's type and floor when they are counted.
+ */
+void invalidateOccupancy(void);
+
+/**
+ * Total the aggregates over a range of nights
+ *
+ * @param from First night of the range
+ * @param to Day after the last night
+ * @param report Filled in with the totals
+ * @return 1 if successful, 0 otherwise
+ */
+int getOccupancy(Date from, Date to, OccupancyReport *report);
+
+/**
+ * Print the occupancy report for a range of nights
+ *
+ * @param from First night of the range
+ * @param to Day after the last night
+ * @return 1 if successful, 0 otherwise
+ */
+int printOccupancyReport(Date from, Date to);
+
+/**
+ * Prompt for a date range and print the occupancy report
+ *
+ * @param currentUser Logged-in user
+ */
+void occupancyReportMenu(User *currentUser);
+
+#endif /* OCCUPANCY_H */
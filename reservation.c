@@ -14,8 +14,22 @@
   #include "fileio.h"
   #include "utils.h"
   #include "ui.h"
+  #include "table.h"
+  #include "availability.h"
+  #include "occupancy.h"
+  #include "wal.h"
+  #include "lock.h"
+  #include "textheap.h"
+  #include "billing.h"
   
-  #define TEMP_FILE "data/temp_reservations.dat"
+  /* Forward declarations for static functions */
+  static int findReservationSlot(int reservationId);
+  static int lockReservation(int reservationId, int lockRoom, int lockGuest);
+  static int insertReservation(User *currentUser, int guestId, int roomId, Date checkIn, Date checkOut,
+                               int numGuests, double paidAmount, const char *notes);
+  static int cancelLocked(int reservationId);
+  static int checkInLocked(int reservationId);
+  static int checkOutLocked(int reservationId);
   
   /* Get the string representation of a reservation status */
   const char* getReservationStatusString(ReservationStatus status) {
@@ -38,7 +52,7 @@
           fseek(fp, 0, SEEK_END);
           if (ftell(fp) > 0) {
               fclose(fp);
-              return 1; 
+              return loadTable(TABLE_RESERVATIONS) && buildAvailability();
           }
           fclose(fp);
       }
@@ -49,11 +63,11 @@
           return 0;
       }
       fclose(fp);
-      return 1;
+      return loadTable(TABLE_RESERVATIONS) && buildAvailability();
   }
   
   /* Calculate the total amount for a reservation */
-  double calculateReservationAmount(int roomId, const char *startDate, const char *endDate) {
+  double calculateReservationAmount(int roomId, Date startDate, Date endDate) {
       Room room;
       int days;
       
@@ -61,16 +75,14 @@
           return 0.0;
       }
       
-      days = calculateDateDifference(startDate, endDate);
+      days = endDate - startDate;
       if (days <= 0) days = 1;
       
       return room.rate * days;
   }
   
   /* Check if a room is available for a given date range */
-  int checkRoomAvailability(int roomId, const char *startDate, const char *endDate) {
-      FILE *fp;
-      Reservation tempReservation;
+  int checkRoomAvailability(int roomId, Date startDate, Date endDate) {
       Room room;
   
       if (!getRoomById(roomId, &room)) {
@@ -81,95 +93,53 @@
           return 0;
       }
       
-      fp = fopen(RESERVATIONS_FILE, "rb");
-      if (fp == NULL) {
-          return 1; 
-      }
-      
-      while (fread(&tempReservation, sizeof(Reservation), 1, fp) == 1) {
-          if (tempReservation.roomId == roomId && 
-              tempReservation.isActive && 
-              (tempReservation.status == RESERVATION_STATUS_CONFIRMED || 
-               tempReservation.status == RESERVATION_STATUS_CHECKED_IN)) {
-              
-              if (strcmp(startDate, tempReservation.checkOutDate) < 0 && 
-                  strcmp(endDate, tempReservation.checkInDate) > 0) {
-                  fclose(fp);
-                  return 0; 
-              }
-          }
-      }
-      
-      fclose(fp);
-      return 1;
+      return isRoomFreeForDays(roomId, startDate, endDate);
   }
   
   /* Check if a room has any active/future reservations */
   int hasActiveReservations(int roomId) {
-      FILE *fp;
-      Reservation tempReservation;
-      
-      fp = fopen(RESERVATIONS_FILE, "rb");
-      if (fp == NULL) return 0;
-      
-      while (fread(&tempReservation, sizeof(Reservation), 1, fp) == 1) {
-          if (tempReservation.roomId == roomId && 
-              tempReservation.isActive && 
-              (tempReservation.status == RESERVATION_STATUS_CONFIRMED || 
-               tempReservation.status == RESERVATION_STATUS_CHECKED_IN)) {
-              fclose(fp);
-              return 1;
-          }
-      }
-      
-      fclose(fp);
-      return 0;
+      return roomHasHeldStays(roomId);
   }
   
   /* Check if a guest has any active/future reservations */
   int hasActiveReservationsByGuest(int guestId) {
-      FILE *fp;
-      Reservation tempReservation;
-      
-      fp = fopen(RESERVATIONS_FILE, "rb");
-      if (fp == NULL) return 0;
-      
-      while (fread(&tempReservation, sizeof(Reservation), 1, fp) == 1) {
-          if (tempReservation.guestId == guestId && 
-              tempReservation.isActive && 
-              (tempReservation.status == RESERVATION_STATUS_CONFIRMED || 
-               tempReservation.status == RESERVATION_STATUS_CHECKED_IN)) {
-              fclose(fp);
+      Table *reservations = getTable(TABLE_RESERVATIONS);
+      
+      for (int i = indexFirst(INDEX_RESERVATION_GUEST, guestId); i >= 0;
+           i = indexNext(INDEX_RESERVATION_GUEST, i)) {
+          Reservation *res = tableRecord(reservations, i);
+          if (res->isActive && 
+              (res->status == RESERVATION_STATUS_CONFIRMED || 
+               res->status == RESERVATION_STATUS_CHECKED_IN)) {
               return 1;
           }
       }
       
-      fclose(fp);
       return 0;
   }
   
   /* Add a new reservation */
   int addReservation(User *currentUser) {
-      FILE *fp;
-      Reservation newRes;
       Guest guest;
       Room room;
-      int nextId = 1;
-      int guestId, roomId;
-      char startDate[11], endDate[11];
-      
-      fp = fopen(RESERVATIONS_FILE, "rb");
-      if (fp != NULL) {
-          while (fread(&newRes, sizeof(Reservation), 1, fp) == 1) {
-              if (newRes.id >= nextId) nextId = newRes.id + 1;
-          }
-          fclose(fp);
-      }
+      int guestId, roomId, numGuests;
+      double totalAmount, paidAmount;
+      char startDate[DATE_STRING_LEN], endDate[DATE_STRING_LEN];
+      char notes[MAX_RESERVATION_NOTES_LEN];
+      char lookup[MAX_PHONE_LEN];
+      Date checkIn, checkOut;
       
       clearScreen();
       printf("===== ADD NEW RESERVATION =====\n");
       
-      listGuests(currentUser);
+      // Find the guest by phone or ID document rather than paging through everyone
+      printf("Guest phone or ID number (press Enter to list all guests): ");
+      getStringInput(NULL, lookup, MAX_PHONE_LEN);
+      if (lookup[0] == '\0') {
+          listGuests(currentUser);
+      } else {
+          listGuestsByPhoneOrId(lookup);
+      }
       guestId = getIntInput("\nEnter Guest ID (or 0 to add a new guest): ", 0, 9999);
       if (guestId == 0) {
           guestId = addGuest();
@@ -182,52 +152,106 @@
           return 0;
       }
       
-      listRooms(currentUser, ROOM_STATUS_AVAILABLE);
-      roomId = getIntInput("\nEnter Room Number for reservation: ", 1, 9999);
-      if (!getRoomById(roomId, &room) || room.status != ROOM_STATUS_AVAILABLE) {
-          printf("\nRoom %d is not available or does not exist. Reservation cancelled.\n", roomId);
-          return 0;
-      }
-      
       do {
           printf("\nEnter Check-in Date (YYYY-MM-DD): ");
-          getStringInput(NULL, startDate, 11);
+          getStringInput(NULL, startDate, DATE_STRING_LEN);
           printf("Enter Check-out Date (YYYY-MM-DD): ");
-          getStringInput(NULL, endDate, 11);
-          if (!validateDate(startDate) || !validateDate(endDate) || strcmp(startDate, endDate) >= 0) {
+          getStringInput(NULL, endDate, DATE_STRING_LEN);
+          if (!validateDate(startDate) || !validateDate(endDate) ||
+              !dateFromString(startDate, &checkIn) || !dateFromString(endDate, &checkOut) ||
+              checkIn >= checkOut) {
               printf("\nInvalid dates. Check-out must be after check-in.\n");
-          } else if (!checkRoomAvailability(roomId, startDate, endDate)) {
-               printf("\nRoom %d is not available for the selected dates.\n", roomId);
           } else {
-              break; // Dates are valid and room is available
+              break; // Dates are valid
           }
       } while (1);
       
-      newRes.numGuests = getIntInput("Number of Guests: ", 1, room.capacity);
-      newRes.totalAmount = calculateReservationAmount(roomId, startDate, endDate);
-      printf("\nTotal Amount for stay: $%.2f\n", newRes.totalAmount);
-      newRes.paidAmount = getDoubleInput("Enter amount paid now: $", 0.0, newRes.totalAmount);
+      // Offer only the rooms that are free for the whole stay
+      if (listFreeRooms(checkIn, checkOut, 0, 0, 0.0) == 0) {
+          printf("\nNo rooms are free for the selected dates. Reservation cancelled.\n");
+          return 0;
+      }
+      roomId = getIntInput("\nEnter Room Number for reservation: ", 1, 9999);
+      if (!getRoomById(roomId, &room) || !checkRoomAvailability(roomId, checkIn, checkOut)) {
+          printf("\nRoom %d is not available for the selected dates. Reservation cancelled.\n", roomId);
+          return 0;
+      }
+      
+      numGuests = getIntInput("Number of Guests: ", 1, room.capacity);
+      totalAmount = calculateReservationAmount(roomId, checkIn, checkOut);
+      printf("\nTotal Amount for stay: $%.2f\n", totalAmount);
+      paidAmount = getDoubleInput("Enter amount paid now: $", 0.0, totalAmount);
       
       printf("Notes (optional): ");
-      getStringInput(NULL, newRes.notes, MAX_RESERVATION_NOTES_LEN);
+      getStringInput(NULL, notes, MAX_RESERVATION_NOTES_LEN);
+  
+      return createReservation(currentUser, guestId, roomId, checkIn, checkOut, numGuests, paidAmount, notes);
+  }
+  
+  /* Create a reservation from already collected details */
+  int createReservation(User *currentUser, int guestId, int roomId, Date checkIn, Date checkOut,
+                        int numGuests, double paidAmount, const char *notes) {
+      int id = 0;
+      
+      // Holding the append lock keeps other terminals from booking the room meanwhile
+      walBegin();
+      if (lockRecord(TABLE_ROOMS, roomId) && lockRecord(TABLE_GUESTS, guestId) &&
+          lockAppend(TABLE_RESERVATIONS)) {
+          id = insertReservation(currentUser, guestId, roomId, checkIn, checkOut, numGuests, paidAmount, notes);
+      }
+      if (id == 0) {
+          walAbort();
+          return 0;
+      }
+      return walCommit() ? id : 0;
+  }
   
-      newRes.id = nextId;
+  /* Check and append a reservation with the room, guest and table locked */
+  static int insertReservation(User *currentUser, int guestId, int roomId, Date checkIn, Date checkOut,
+                               int numGuests, double paidAmount, const char *notes) {
+      Table *reservations = getTable(TABLE_RESERVATIONS);
+      Reservation newRes;
+      Guest guest;
+      Room room;
+      
+      if (!getGuestById(guestId, &guest)) {
+          printf("\nGuest with ID %d not found. Reservation cancelled.\n", guestId);
+          return 0;
+      }
+      if (checkIn >= checkOut) {
+          printf("\nInvalid dates. Check-out must be after check-in.\n");
+          return 0;
+      }
+      if (!getRoomById(roomId, &room) || !checkRoomAvailability(roomId, checkIn, checkOut)) {
+          printf("\nRoom %d is not available for the selected dates. Reservation cancelled.\n", roomId);
+          return 0;
+      }
+      if (numGuests < 1 || numGuests > room.capacity) {
+          printf("\nRoom %d holds at most %d guest(s). Reservation cancelled.\n", roomId, room.capacity);
+          return 0;
+      }
+      
+      memset(&newRes, 0, sizeof(newRes));
+      newRes.id = tableNextId(reservations);
       newRes.guestId = guestId;
       newRes.roomId = roomId;
-      strcpy(newRes.checkInDate, startDate);
-      strcpy(newRes.checkOutDate, endDate);
+      newRes.checkInDate = checkIn;
+      newRes.checkOutDate = checkOut;
       newRes.status = RESERVATION_STATUS_CONFIRMED;
+      newRes.numGuests = numGuests;
+      newRes.totalAmount = calculateReservationAmount(roomId, checkIn, checkOut);
+      newRes.paidAmount = paidAmount < newRes.totalAmount ? paidAmount : newRes.totalAmount;
       getCurrentDateTime(newRes.creationDate);
       newRes.createdBy = currentUser->id;
+      newRes.notes = storeText(notes);
       newRes.isActive = 1;
       
-      fp = fopen(RESERVATIONS_FILE, "ab");
-      if (!fp) {
+      if (newRes.notes < 0 || tableAppend(reservations, &newRes) < 0) {
           printf("\nError: Could not save reservation.\n");
           return 0;
       }
-      fwrite(&newRes, sizeof(Reservation), 1, fp);
-      fclose(fp);
+      availabilityUpdate(NULL, &newRes);
+      occupancyUpdate(NULL, &newRes);
       
       // Room status is updated by check-in/out, not just reservation
       // changeRoomStatus(roomId, ROOM_STATUS_RESERVED);
@@ -239,152 +263,158 @@
   
   /* Cancel a reservation */
   int cancelReservation(User *currentUser, int reservationId) {
-      FILE *fp, *tempFp;
-      Reservation res;
-      int found = 0;
+      int ok;
       
-      fp = fopen(RESERVATIONS_FILE, "rb");
-      if (!fp) return 0;
-      
-      tempFp = fopen(TEMP_FILE, "wb");
-      if (!tempFp) { fclose(fp); return 0; }
-      
-      while (fread(&res, sizeof(Reservation), 1, fp) == 1) {
-          if (res.id == reservationId && res.isActive) {
-              found = 1;
-              if (res.status == RESERVATION_STATUS_CONFIRMED) {
-                  printf("\nCancelling reservation %d...", reservationId);
-                  res.status = RESERVATION_STATUS_CANCELLED;
-                  // Note: a real system might have cancellation fees logic here
-                  if(res.paidAmount > 0) {
-                      printf("\nNote: $%.2f was paid. Please process refund manually.", res.paidAmount);
-                  }
-              } else {
-                  printf("\nOnly 'Confirmed' reservations can be cancelled. Status is '%s'.", getReservationStatusString(res.status));
-              }
-          }
-          fwrite(&res, sizeof(Reservation), 1, tempFp);
+      walBegin();
+      ok = lockReservation(reservationId, 0, 0) && cancelLocked(reservationId);
+      if (!ok) {
+          walAbort();
+          return 0;
+      }
+      return walCommit();
+  }
+  
+  /* Cancel a reservation once it is locked */
+  static int cancelLocked(int reservationId) {
+      Table *reservations;
+      Reservation *res;
+      int slot;
+      
+      slot = findReservationSlot(reservationId);
+      if (slot < 0) {
+          printf("\nReservation with ID %d not found.\n", reservationId);
+          return 0;
       }
       
-      fclose(fp);
-      fclose(tempFp);
-      
-      if (found) {
-          remove(RESERVATIONS_FILE);
-          rename(TEMP_FILE, RESERVATIONS_FILE);
-          printf("\nOperation completed.\n");
+      reservations = getTable(TABLE_RESERVATIONS);
+      res = tableRecord(reservations, slot);
+      if (res->status == RESERVATION_STATUS_CONFIRMED) {
+          Reservation before = *res;
+          printf("\nCancelling reservation %d...", reservationId);
+          res->status = RESERVATION_STATUS_CANCELLED;
+          // Note: a real system might have cancellation fees logic here
+          if(res->paidAmount > 0) {
+              printf("\nNote: $%.2f was paid. Please process refund manually.", res->paidAmount);
+          }
+          if (!tableWriteRecord(reservations, slot)) {
+              return 0;
+          }
+          availabilityUpdate(&before, res);
+          occupancyUpdate(&before, res);
       } else {
-          remove(TEMP_FILE);
-          printf("\nReservation with ID %d not found.\n", reservationId);
+          printf("\nOnly 'Confirmed' reservations can be cancelled. Status is '%s'.", getReservationStatusString(res->status));
       }
-      return found;
+      
+      printf("\nOperation completed.\n");
+      return 1;
   }
   
   /* Check in a guest for a reservation */
   int checkInReservation(User *currentUser, int reservationId) {
-      FILE *fp, *tempFp;
-      Reservation res;
-      int found = 0;
+      int ok;
       
-      fp = fopen(RESERVATIONS_FILE, "rb");
-      if (!fp) return 0;
-      
-      tempFp = fopen(TEMP_FILE, "wb");
-      if (!tempFp) { fclose(fp); return 0; }
-      
-      while (fread(&res, sizeof(Reservation), 1, fp) == 1) {
-          if (res.id == reservationId && res.isActive) {
-              found = 1;
-              if (res.status == RESERVATION_STATUS_CONFIRMED) {
-                  res.status = RESERVATION_STATUS_CHECKED_IN;
-                  changeRoomStatus(res.roomId, ROOM_STATUS_OCCUPIED);
-                  printf("\nGuest checked in successfully for reservation %d.\n", reservationId);
-              } else {
-                  printf("\nCannot check-in. Reservation status is '%s'.\n", getReservationStatusString(res.status));
-              }
-          }
-          fwrite(&res, sizeof(Reservation), 1, tempFp);
+      walBegin();
+      ok = lockReservation(reservationId, 1, 0) && checkInLocked(reservationId);
+      if (!ok) {
+          walAbort();
+          return 0;
+      }
+      return walCommit();
+  }
+  
+  /* Check in a reservation once it and its room are locked */
+  static int checkInLocked(int reservationId) {
+      Table *reservations;
+      Reservation *res;
+      int slot;
+      
+      slot = findReservationSlot(reservationId);
+      if (slot < 0) {
+          printf("\nReservation with ID %d not found.\n", reservationId);
+          return 0;
       }
       
-      fclose(fp);
-      fclose(tempFp);
-      
-      if (found) {
-          remove(RESERVATIONS_FILE);
-          rename(TEMP_FILE, RESERVATIONS_FILE);
+      reservations = getTable(TABLE_RESERVATIONS);
+      res = tableRecord(reservations, slot);
+      if (res->status == RESERVATION_STATUS_CONFIRMED) {
+          // The reservation and room status change commit together
+          Reservation before = *res;
+          res->status = RESERVATION_STATUS_CHECKED_IN;
+          if (!tableWriteRecord(reservations, slot)) {
+              return 0;
+          }
+          occupancyUpdate(&before, res);
+          if (!changeRoomStatus(res->roomId, ROOM_STATUS_OCCUPIED)) {
+              return 0;
+          }
+          printf("\nGuest checked in successfully for reservation %d.\n", reservationId);
       } else {
-          remove(TEMP_FILE);
-          printf("\nReservation with ID %d not found.\n", reservationId);
+          printf("\nCannot check-in. Reservation status is '%s'.\n", getReservationStatusString(res->status));
       }
-      return found;
+      return 1;
   }
   
   /* Check out a guest from a reservation */
   int checkOutReservation(User *currentUser, int reservationId) {
-      FILE *fp, *tempFp;
-      Reservation res;
-      int found = 0;
+      int ok;
       
-      if (!getReservationById(reservationId, &res)) {
+      walBegin();
+      ok = lockReservation(reservationId, 1, 1) && checkOutLocked(reservationId);
+      if (!ok) {
+          walAbort();
+          return 0;
+      }
+      return walCommit();
+  }
+  
+  /* Check out a reservation once it, its room and its guest are locked */
+  static int checkOutLocked(int reservationId) {
+      Table *reservations;
+      Reservation *res;
+      int slot;
+      
+      slot = findReservationSlot(reservationId);
+      if (slot < 0) {
           printf("\nReservation with ID %d not found.\n", reservationId);
           return 0;
       }
   
-      if (res.status != RESERVATION_STATUS_CHECKED_IN) {
-          printf("\nOnly checked-in guests can be checked out. Status: %s\n", getReservationStatusString(res.status));
+      reservations = getTable(TABLE_RESERVATIONS);
+      res = tableRecord(reservations, slot);
+      if (res->status != RESERVATION_STATUS_CHECKED_IN) {
+          printf("\nOnly checked-in guests can be checked out. Status: %s\n", getReservationStatusString(res->status));
           return 0;
       }
   
-      // A real system would link to billing here to check for outstanding balance.
-      // We simulate this by checking the paidAmount.
-      if (res.paidAmount < res.totalAmount) {
-          printf("\nWarning: Outstanding balance of $%.2f.", res.totalAmount - res.paidAmount);
+      // Paying the reservation's invoices in the Billing module settles it too
+      if (res->paidAmount < res->totalAmount && !isReservationSettled(res->id)) {
+          printf("\nWarning: Outstanding balance of $%.2f.", res->totalAmount - res->paidAmount);
           printf("\nPlease resolve payment in the Billing module before checkout.\n");
           return 0;
       }
       
-      fp = fopen(RESERVATIONS_FILE, "rb");
-      if (!fp) return 0;
-      
-      tempFp = fopen(TEMP_FILE, "wb");
-      if (!tempFp) { fclose(fp); return 0; }
-  
-      while (fread(&res, sizeof(Reservation), 1, fp) == 1) {
-          if (res.id == reservationId && res.isActive) {
-              found = 1;
-              res.status = RESERVATION_STATUS_CHECKED_OUT;
-              changeRoomStatus(res.roomId, ROOM_STATUS_CLEANING);
-              updateGuestStayInfo(res.guestId, res.totalAmount);
-              printf("\nGuest checked out successfully. Room %d status set to Cleaning.\n", res.roomId);
-          }
-          fwrite(&res, sizeof(Reservation), 1, tempFp);
+      Reservation before = *res;
+      res->status = RESERVATION_STATUS_CHECKED_OUT;
+      if (!tableWriteRecord(reservations, slot)) {
+          return 0;
       }
-  
-      fclose(fp);
-      fclose(tempFp);
-  
-      if (found) {
-          remove(RESERVATIONS_FILE);
-          rename(TEMP_FILE, RESERVATIONS_FILE);
-      } else {
-          remove(TEMP_FILE);
+      availabilityUpdate(&before, res);
+      occupancyUpdate(&before, res);
+      if (!changeRoomStatus(res->roomId, ROOM_STATUS_CLEANING) ||
+          !updateGuestStayInfo(res->guestId, res->totalAmount)) {
+          return 0;
       }
-      return found;
+      printf("\nGuest checked out successfully. Room %d status set to Cleaning.\n", res->roomId);
+      return 1;
   }
   
   /* List all reservations */
   void listReservations(User *currentUser, ReservationStatus statusFilter) {
-      FILE *fp;
-      Reservation res;
+      Table *reservations = getTable(TABLE_RESERVATIONS);
       Guest guest;
+      char checkIn[DATE_STRING_LEN], checkOut[DATE_STRING_LEN];
       int count = 0;
       
-      fp = fopen(RESERVATIONS_FILE, "rb");
-      if (fp == NULL) {
-          printf("\nCould not open reservations file or no reservations exist.\n");
-          return;
-      }
-      
       clearScreen();
       printf("===== RESERVATION LIST =====\n");
       if (statusFilter != 0) {
@@ -395,46 +425,69 @@
              "ID", "Guest Name", "Room", "Check-in", "Check-out", "Status");
       printf("--------------------------------------------------------------------------------\n");
       
-      while (fread(&res, sizeof(Reservation), 1, fp) == 1) {
-          if (res.isActive && (statusFilter == 0 || res.status == statusFilter)) {
-              if (getGuestById(res.guestId, &guest)) {
+      Reservation *all = TABLE_RECORDS(reservations, Reservation);
+      for (int i = 0; i < reservations->count; i++) {
+          Reservation *res = &all[i];
+          if (res->isActive && (statusFilter == 0 || res->status == statusFilter)) {
+              if (getGuestById(res->guestId, &guest)) {
+                  dateToString(res->checkInDate, checkIn);
+                  dateToString(res->checkOutDate, checkOut);
                   printf("%-5d %-25s %-6d %-12s %-12s %-12s\n", 
-                         res.id, 
+                         res->id, 
                          guest.name, 
-                         res.roomId, 
-                         res.checkInDate,
-                         res.checkOutDate,
-                         getReservationStatusString(res.status));
+                         res->roomId, 
+                         checkIn,
+                         checkOut,
+                         getReservationStatusString(res->status));
                   count++;
               }
           }
       }
       
-      fclose(fp);
-      
       printf("--------------------------------------------------------------------------------\n");
       printf("Total reservations found: %d\n", count);
   }
   
-  /* Get a reservation by ID */
-  int getReservationById(int reservationId, Reservation *reservation) {
-      FILE *fp;
-      Reservation temp;
-      int found = 0;
+  /* Find the table slot of an active reservation, or -1 if there is none */
+  static int findReservationSlot(int reservationId) {
+      Table *reservations = getTable(TABLE_RESERVATIONS);
+      int slot = tableLookup(reservations, reservationId);
       
-      fp = fopen(RESERVATIONS_FILE, "rb");
-      if (fp == NULL) return 0;
-      
-      while (fread(&temp, sizeof(Reservation), 1, fp) == 1) {
-          if (temp.id == reservationId && temp.isActive) {
-              *reservation = temp;
-              found = 1;
-              break;
-          }
+      if (slot < 0 || !((Reservation *)tableRecord(reservations, slot))->isActive) {
+          return -1;
+      }
+      return slot;
+  }
+  
+  /* Lock a reservation, after its room and guest if asked, for the rest of the transaction */
+  static int lockReservation(int reservationId, int lockRoom, int lockGuest) {
+      Reservation *res;
+      int roomId, guestId;
+      int slot;
+      
+      // Pick up reservations made on other terminals before looking this one up
+      refreshTables();
+      slot = findReservationSlot(reservationId);
+      if (slot < 0) {
+          return 1; /* The caller reports it missing */
       }
       
-      fclose(fp);
-      return found;
+      // Room and guest never change, so the cached copy names the right records
+      res = tableRecord(getTable(TABLE_RESERVATIONS), slot);
+      roomId = res->roomId;
+      guestId = res->guestId;
+      return (!lockRoom || lockRecord(TABLE_ROOMS, roomId)) &&
+             (!lockGuest || lockRecord(TABLE_GUESTS, guestId)) &&
+             lockRecord(TABLE_RESERVATIONS, reservationId);
+  }
+  
+  /* Get a reservation by ID */
+  int getReservationById(int reservationId, Reservation *reservation) {
+      int slot = findReservationSlot(reservationId);
+      if (slot < 0) return 0;
+      
+      *reservation = *(Reservation *)tableRecord(getTable(TABLE_RESERVATIONS), slot);
+      return 1;
   }
   
   
@@ -444,6 +497,7 @@
       int reservationId;
       
       do {
+          refreshTables();
           clearScreen();
           printf("===== RESERVATION MANAGEMENT =====\n");
           printf("1. List All Reservations\n");
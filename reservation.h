@@ -12,6 +12,8 @@
  #include "auth.h" 
  #include "room.h" 
  #include "guest.h"
+ #include "utils.h"
+ #include "textheap.h"
  
  /* Reservation status definitions */
  typedef enum {
@@ -36,15 +38,15 @@
      int id;                                      /* Unique reservation ID */
      int guestId;                                  /* ID of the guest */
      int roomId;                                   /* ID of the room */
-     char checkInDate[11];                         /* Check-in date (YYYY-MM-DD) */
-     char checkOutDate[11];                        /* Check-out date (YYYY-MM-DD) */
+     Date checkInDate;                             /* Check-in date (days since 1970-01-01) */
+     Date checkOutDate;                            /* Check-out date (days since 1970-01-01) */
      ReservationStatus status;                     /* Reservation status */
      int numGuests;                                /* Number of guests */
      double totalAmount;                           /* Total amount for the stay */
      double paidAmount;                            /* Amount already paid */
      char creationDate[20];                        /* Date and time of reservation creation */
      int createdBy;                                /* ID of user who created the reservation */
-     char notes[MAX_RESERVATION_NOTES_LEN];        /* Additional notes */
+     TextRef notes;                                /* Additional notes */
      int isActive;                                 /* Whether the reservation is active in the system */
  } Reservation;
  
@@ -52,6 +54,8 @@
  
  int initializeReservationData(void);
  int addReservation(User *currentUser);
+ int createReservation(User *currentUser, int guestId, int roomId, Date checkIn, Date checkOut,
+                       int numGuests, double paidAmount, const char *notes);
  int modifyReservation(User *currentUser, int reservationId);
  int cancelReservation(User *currentUser, int reservationId);
  int checkInReservation(User *currentUser, int reservationId);
@@ -59,10 +63,10 @@
  void listReservations(User *currentUser, ReservationStatus statusFilter);
  void searchReservations(User *currentUser);
  int getReservationById(int reservationId, Reservation *reservation);
- int checkRoomAvailability(int roomId, const char *startDate, const char *endDate);
+ int checkRoomAvailability(int roomId, Date startDate, Date endDate);
  int hasActiveReservations(int roomId);
  int hasActiveReservationsByGuest(int guestId);
- double calculateReservationAmount(int roomId, const char *startDate, const char *endDate);
+ double calculateReservationAmount(int roomId, Date startDate, Date endDate);
  void reservationManagementMenu(User *currentUser);
  const char* getReservationStatusString(ReservationStatus status);
  
@@ -0,0 +1,279 @@
+/**
+ * Hotel Management System
+ * revenue.c - Revenue report implementation
+ *
+ * This file implements the revenue report. A snapshot copies the fields
+ * the report needs out of the billing item, invoice and payment tables
+ * into parallel arrays, dating each item by the day it was posted for,
+ * so a stay's nightly charges fall on their own nights. Totals by type,
+ * day and payment method are then plain loops over those arrays.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "revenue.h"
+#include "room.h"
+#include "table.h"
+#include "ui.h"
+#include "utils.h"
+
+#define DAILY_LISTING_MAX_DAYS 62
+
+/* Column-oriented snapshot of the billing tables */
+static struct {
+    double *amount;         /* Item amount */
+    double *net;            /* Amount counted as net revenue (negative for discounts, 0 for tax) */
+    int *day;               /* Day the item was posted for */
+    int *quantity;          /* Item quantity */
+    unsigned char *type;    /* BillingItemType */
+    int count;
+    int capacity;
+} items;
+
+static struct {
+    double *amount;         /* Payment amount */
+    int *day;               /* Transaction date */
+    unsigned char *method;  /* PaymentMethod */
+    int count;
+    int capacity;
+} payments;
+
+/* Make room for a number of rows in the item columns */
+static int reserveItemColumns(int rows) {
+    if (rows <= items.capacity) {
+        return 1;
+    }
+    free(items.amount);
+    free(items.net);
+    free(items.day);
+    free(items.quantity);
+    free(items.type);
+    items.amount = malloc((size_t)rows * sizeof(double));
+    items.net = malloc((size_t)rows * sizeof(double));
+    items.day = malloc((size_t)rows * sizeof(int));
+    items.quantity = malloc((size_t)rows * sizeof(int));
+    items.type = malloc((size_t)rows);
+    if (items.amount == NULL || items.net == NULL || items.day == NULL ||
+        items.quantity == NULL || items.type == NULL) {
+        items.capacity = 0;
+        return 0;
+    }
+    items.capacity = rows;
+    return 1;
+}
+
+/* Make room for a number of rows in the payment columns */
+static int reservePaymentColumns(int rows) {
+    if (rows <= payments.capacity) {
+        return 1;
+    }
+    free(payments.amount);
+    free(payments.day);
+    free(payments.method);
+    payments.amount = malloc((size_t)rows * sizeof(double));
+    payments.day = malloc((size_t)rows * sizeof(int));
+    payments.method = malloc((size_t)rows);
+    if (payments.amount == NULL || payments.day == NULL || payments.method == NULL) {
+        payments.capacity = 0;
+        return 0;
+    }
+    payments.capacity = rows;
+    return 1;
+}
+
+/* Take a fresh snapshot of the billing tables */
+int loadRevenueSnapshot(void) {
+    Table *itemTable = getTable(TABLE_BILLING_ITEMS);
+    Table *invoiceTable = getTable(TABLE_INVOICES);
+    Table *paymentTable = getTable(TABLE_PAYMENTS);
+    BillingItem *allItems = TABLE_RECORDS(itemTable, BillingItem);
+    Invoice *allInvoices = TABLE_RECORDS(invoiceTable, Invoice);
+    Payment *allPayments = TABLE_RECORDS(paymentTable, Payment);
+
+    items.count = payments.count = 0;
+    if (!reserveItemColumns(itemTable->count) || !reservePaymentColumns(paymentTable->count)) {
+        printf("\nError: Out of memory while building the revenue snapshot.\n");
+        return 0;
+    }
+
+    for (int i = 0; i < itemTable->count; i++) {
+        const BillingItem *item = &allItems[i];
+        int slot = tableLookup(invoiceTable, item->invoiceId);
+        int n;
+
+        if (!item->isActive || slot < 0 || !allInvoices[slot].isActive ||
+            allInvoices[slot].status == INVOICE_STATUS_CANCELLED ||
+            item->type < 0 || item->type >= REVENUE_ITEM_TYPES) {
+            continue;
+        }
+
+        n = items.count++;
+        items.amount[n] = item->amount;
+        items.net[n] = item->type == BILLING_ITEM_TAX ? 0.0 :
+                       item->type == BILLING_ITEM_DISCOUNT ? -item->amount : item->amount;
+        items.day[n] = item->serviceDate;
+        items.quantity[n] = item->quantity;
+        items.type[n] = (unsigned char)item->type;
+    }
+
+    for (int i = 0; i < paymentTable->count; i++) {
+        const Payment *p = &allPayments[i];
+        int n;
+
+        if (!p->isActive || p->status != PAYMENT_STATUS_COMPLETED ||
+            p->method < 0 || p->method >= REVENUE_PAYMENT_METHODS) {
+            continue;
+        }
+
+        n = payments.count++;
+        payments.amount[n] = p->amount;
+        payments.day[n] = p->transactionDate;
+        payments.method[n] = (unsigned char)p->method;
+    }
+    return 1;
+}
+
+/* Total the current snapshot over a range of days */
+void getRevenue(Date from, Date to, RevenueReport *report) {
+    Table *rooms = getTable(TABLE_ROOMS);
+    double roomRevenue;
+    int days = to - from;
+
+    memset(report, 0, sizeof(*report));
+    report->from = from;
+    report->to = to;
+
+    for (int i = 0; i < items.count; i++) {
+        if (items.day[i] >= from && items.day[i] < to) {
+            report->byType[items.type[i]] += items.amount[i];
+            report->netRevenue += items.net[i];
+            report->roomNights += items.type[i] == BILLING_ITEM_ROOM_CHARGE ? items.quantity[i] : 0;
+        }
+    }
+
+    for (int i = 0; i < payments.count; i++) {
+        if (payments.day[i] >= from && payments.day[i] < to) {
+            report->byMethod[payments.method[i]] += payments.amount[i];
+            report->collected += payments.amount[i];
+        }
+    }
+
+    for (int slot = 0; slot < rooms->count; slot++) {
+        report->roomsAvailable += ((Room *)tableRecord(rooms, slot))->isActive ? 1 : 0;
+    }
+
+    roomRevenue = report->byType[BILLING_ITEM_ROOM_CHARGE];
+    report->adr = report->roomNights > 0 ? roomRevenue / report->roomNights : 0.0;
+    report->revpar = report->roomsAvailable > 0 && days > 0 ?
+                     roomRevenue / ((double)report->roomsAvailable * days) : 0.0;
+}
+
+/* Total net revenue for each day of a range from the current snapshot */
+void getDailyRevenue(Date from, Date to, double *daily) {
+    memset(daily, 0, (size_t)(to - from) * sizeof(double));
+    for (int i = 0; i < items.count; i++) {
+        if (items.day[i] >= from && items.day[i] < to) {
+            daily[items.day[i] - from] += items.net[i];
+        }
+    }
+}
+
+/* Print net revenue by day, or by month for long ranges */
+static int printRevenueByPeriod(Date from, Date to) {
+    double *daily = malloc((size_t)(to - from) * sizeof(double));
+    char dateStr[DATE_STRING_LEN];
+
+    if (daily == NULL) {
+        printf("\nError: Out of memory.\n");
+        return 0;
+    }
+    getDailyRevenue(from, to, daily);
+
+    if (to - from <= DAILY_LISTING_MAX_DAYS) {
+        printf("\n%-12s %-14s\n", "Day", "Net Revenue");
+        printf("---------------------------\n");
+        for (Date day = from; day < to; day++) {
+            dateToString(day, dateStr);
+            printf("%-12s $%-13.2f\n", dateStr, daily[day - from]);
+        }
+    } else {
+        int year, month, dayOfMonth, currentYear, currentMonth;
+        double monthTotal = 0.0;
+
+        printf("\n%-12s %-14s\n", "Month", "Net Revenue");
+        printf("---------------------------\n");
+        civilFromDays(from, &currentYear, &currentMonth, &dayOfMonth);
+        for (Date day = from; day < to; day++) {
+            civilFromDays(day, &year, &month, &dayOfMonth);
+            if (year != currentYear || month != currentMonth) {
+                printf("%04d-%02d      $%-13.2f\n", currentYear, currentMonth, monthTotal);
+                monthTotal = 0.0;
+                currentYear = year;
+                currentMonth = month;
+            }
+            monthTotal += daily[day - from];
+        }
+        printf("%04d-%02d      $%-13.2f\n", currentYear, currentMonth, monthTotal);
+    }
+
+    free(daily);
+    return 1;
+}
+
+/* Snapshot the billing tables and print the revenue report for a range */
+int printRevenueReport(Date from, Date to) {
+    char startDate[DATE_STRING_LEN], endDate[DATE_STRING_LEN];
+    RevenueReport report;
+
+    if (!loadRevenueSnapshot()) {
+        return 0;
+    }
+    getRevenue(from, to, &report);
+
+    dateToString(from, startDate);
+    dateToString(to - 1, endDate);
+    printf("\nPeriod: %s to %s (%d day(s))\n", startDate, endDate, to - from);
+
+    printf("\n%-18s %-14s\n", "Item Type", "Amount");
+    printf("---------------------------------\n");
+    for (int t = 0; t < REVENUE_ITEM_TYPES; t++) {
+        printf("%-18s $%-13.2f\n", getBillingItemTypeString((BillingItemType)t), report.byType[t]);
+    }
+
+    printf("\n%-28s $%.2f\n", "Net revenue (before tax):", report.netRevenue);
+    printf("%-28s $%.2f\n", "Tax:", report.byType[BILLING_ITEM_TAX]);
+    printf("%-28s %d\n", "Room nights billed:", report.roomNights);
+    printf("%-28s $%.2f\n", "ADR:", report.adr);
+    printf("%-28s $%.2f\n", "RevPAR:", report.revpar);
+
+    printf("\n%-18s %-14s\n", "Payment Method", "Collected");
+    printf("---------------------------------\n");
+    for (int m = 0; m < REVENUE_PAYMENT_METHODS; m++) {
+        printf("%-18s $%-13.2f\n", getPaymentMethodString((PaymentMethod)m), report.byMethod[m]);
+    }
+    printf("%-18s $%-13.2f\n", "Total", report.collected);
+
+    return printRevenueByPeriod(from, to);
+}
+
+/* Prompt for a date range and print the revenue report */
+void revenueReportMenu(User *currentUser) {
+    char startDate[DATE_STRING_LEN], endDate[DATE_STRING_LEN];
+    Date from, last;
+
+    clearScreen();
+    displayHeader("Revenue Report");
+
+    printf("Enter first day (YYYY-MM-DD): ");
+    getStringInput(NULL, startDate, DATE_STRING_LEN);
+    printf("Enter last day (YYYY-MM-DD): ");
+    getStringInput(NULL, endDate, DATE_STRING_LEN);
+    if (!validateDate(startDate) || !validateDate(endDate) ||
+        !dateFromString(startDate, &from) || !dateFromString(endDate, &last) || last < from) {
+        printf("\nInvalid dates. The last day must not be before the first.\n");
+        return;
+    }
+
+    printRevenueReport(from, last + 1);
+}
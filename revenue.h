@@ -0,0 +1,84 @@
+/**
+ * Hotel Management System
+ * revenue.h - Revenue report header
+ *
+ * This file contains declarations for the revenue report. The report
+ * works on a column-oriented snapshot of the billing item and payment
+ * tables: each field it aggregates is copied into its own array, so
+ * every total is a single pass over a few flat arrays instead of over
+ * whole records.
+ *
+ * An item's revenue falls on the day it was posted for, so the night
+ * audit's nightly room charges land on their own nights. Items on
+ * cancelled invoices are left out. Payments fall on their transaction
+ * date.
+ */
+
+#ifndef REVENUE_H
+#define REVENUE_H
+
+#include "billing.h"
+
+/* Number of billing item types and payment methods */
+#define REVENUE_ITEM_TYPES (BILLING_ITEM_OTHER + 1)
+#define REVENUE_PAYMENT_METHODS (PAYMENT_METHOD_ONLINE + 1)
+
+/* Revenue totals for a range of days */
+typedef struct {
+    Date from;                                          /* First day of the range */
+    Date to;                                            /* Day after the last day */
+    double byType[REVENUE_ITEM_TYPES];                  /* Item amounts by type (discounts positive) */
+    double byMethod[REVENUE_PAYMENT_METHODS];           /* Completed payments by method */
+    double netRevenue;                                  /* Charges less discounts, before tax */
+    double collected;                                   /* All completed payments */
+    int roomNights;                                     /* Nights billed as room charges */
+    int roomsAvailable;                                 /* Active rooms */
+    double adr;                                         /* Average daily rate: room revenue per night sold */
+    double revpar;                                      /* Room revenue per available room night */
+} RevenueReport;
+
+/**
+ * Take a fresh snapshot of the billing tables
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int loadRevenueSnapshot(void);
+
+/**
+ * Total the current snapshot over a range of days
+ *
+ * @param from First day of the range
+ * @param to Day after the last day
+ * @param report Filled in with the totals
+ */
+void getRevenue(Date from, Date to, RevenueReport *report);
+
+/**
+ * Total net revenue for each day of a range from the current snapshot
+ *
+ * @param from First day of the range
+ * @param to Day after the last day
+ * @param daily Receives to - from totals, one per day
+ */
+void getDailyRevenue(Date from, Date to, double *daily);
+
+/**
+ * Snapshot the billing tables and print the revenue report for a range
+ *
+ * Days are listed for ranges up to two months; longer ranges are
+ * listed by month.
+ *
+ * @param from First day of the range
+ * @param to Day after the last day
+ * @return 1 if successful, 0 otherwise
+ */
+int printRevenueReport(Date from, Date to);
+
+/**
+ * Prompt for a date range and print the revenue report
+ *
+ * @param currentUser Logged-in user
+ */
+void revenueReportMenu(User *currentUser);
+
+#endif /* REVENUE_H */
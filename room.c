@@ -15,12 +15,21 @@
 #include "utils.h"
 #include "ui.h"
 #include "reservation.h"
+#include "table.h"
+#include "availability.h"
+#include "occupancy.h"
+#include "wal.h"
+#include "lock.h"
+#include "textheap.h"
 
 /* Forward declarations for static functions */
 static int isRoomExists(int roomId);
+static int findRoomSlot(int roomId);
+static int insertRoom(User *currentUser, Room *room, const char *description, const char *features);
+static int editRoom(User *currentUser, int roomId);
+static int removeRoom(User *currentUser, int roomId);
+static int setRoomStatus(int roomId, RoomStatus newStatus);
 
-#define ROOMS_FILE "data/rooms.dat"
-#define TEMP_FILE "data/temp.dat"
 #define MAX_ROOMS 1000
 
 /* Get the string representation of a room status */
@@ -59,10 +68,24 @@ const char* getRoomTypeString(RoomType type) {
     }
 }
 
+/* Sample room, with the text the room record refers to */
+typedef struct {
+    int id;
+    RoomType type;
+    RoomStatus status;
+    double rate;
+    const char *description;
+    const char *features;
+    int capacity;
+    int floor;
+    int isActive;
+} SampleRoom;
+
 /* Initialize room data with sample rooms */
 int initializeRoomData(void) {
     FILE *fp;
-    Room sampleRooms[10] = {
+    int ok;
+    SampleRoom sampleRooms[10] = {
         /* Standard Rooms */
         {
             .id = 101,
@@ -154,41 +177,59 @@ int initializeRoomData(void) {
         return 0;
     }
 
-    /* Check if rooms file already exists */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp != NULL) {
-        /* Check if file has content */
-        fseek(fp, 0, SEEK_END);
-        if (ftell(fp) > 0) {
-            fclose(fp);
-            return 1; /* Rooms already exist */
+    /* Create rooms file if it doesn't exist */
+    if (!fileExists(ROOMS_FILE)) {
+        fp = fopen(ROOMS_FILE, "wb");
+        if (!fp) {
+            printf("\nError: Could not create rooms file\n");
+            return 0;
         }
         fclose(fp);
     }
-
-    /* Create rooms file and write sample data */
-    fp = fopen(ROOMS_FILE, "wb");
-    if (!fp) {
-        printf("\nError: Could not create rooms file\n");
+    if (!loadTable(TABLE_ROOMS)) {
         return 0;
     }
+    if (getTable(TABLE_ROOMS)->count > 0) {
+        return 1; /* Rooms already exist */
+    }
 
-    /* Write sample rooms to file */
-    if (fwrite(sampleRooms, sizeof(Room), numSampleRooms, fp) != numSampleRooms) {
+    /* Add sample rooms, storing their text in the text heap */
+    walBegin();
+    ok = lockAppend(TABLE_ROOMS);
+    for (int i = 0; ok && i < numSampleRooms; i++) {
+        Room room;
+
+        memset(&room, 0, sizeof(room));
+        room.id = sampleRooms[i].id;
+        room.type = sampleRooms[i].type;
+        room.status = sampleRooms[i].status;
+        room.rate = sampleRooms[i].rate;
+        room.description = storeText(sampleRooms[i].description);
+        room.features = storeText(sampleRooms[i].features);
+        room.capacity = sampleRooms[i].capacity;
+        room.floor = sampleRooms[i].floor;
+        room.isActive = sampleRooms[i].isActive;
+        ok = room.description >= 0 && room.features >= 0 &&
+             tableAppend(getTable(TABLE_ROOMS), &room) >= 0;
+    }
+    if (!ok) {
         printf("\nError: Could not write sample room data\n");
-        fclose(fp);
+        walAbort();
+        return 0;
+    }
+    if (!walCommit()) {
         return 0;
     }
 
-    fclose(fp);
     printf("\nSample room data created successfully.\n");
     return 1;
 }
 
 /* Add a new room */
 int addRoom(User *currentUser) {
-    FILE *fp;
     Room newRoom;
+    char description[MAX_ROOM_DESC_LEN];
+    char features[MAX_ROOM_FEATURES_LEN];
     int roomId;
     
     /* Check if user has permission */
@@ -229,13 +270,13 @@ int addRoom(User *currentUser) {
     /* Get room description */
     printf("\nRoom Description: ");
     getchar(); /* Consume newline */
-    fgets(newRoom.description, MAX_ROOM_DESC_LEN, stdin);
-    newRoom.description[strcspn(newRoom.description, "\n")] = '\0'; /* Remove newline */
+    fgets(description, MAX_ROOM_DESC_LEN, stdin);
+    description[strcspn(description, "\n")] = '\0'; /* Remove newline */
     
     /* Get room features */
     printf("Room Features: ");
-    fgets(newRoom.features, MAX_ROOM_FEATURES_LEN, stdin);
-    newRoom.features[strcspn(newRoom.features, "\n")] = '\0'; /* Remove newline */
+    fgets(features, MAX_ROOM_FEATURES_LEN, stdin);
+    features[strcspn(features, "\n")] = '\0'; /* Remove newline */
     
     /* Get room capacity */
     printf("Room Capacity (max guests): ");
@@ -245,54 +286,91 @@ int addRoom(User *currentUser) {
     printf("Floor Number: ");
     newRoom.floor = getIntInput("", 1, 100);
     
+    return createRoom(currentUser, &newRoom, description, features);
+}
+
+/* Add a room whose details are already filled in */
+int createRoom(User *currentUser, Room *room, const char *description, const char *features) {
+    int ok;
+    
+    /* Another terminal cannot add the same room number meanwhile */
+    walBegin();
+    ok = lockAppend(TABLE_ROOMS) && insertRoom(currentUser, room, description, features);
+    if (!ok) {
+        walAbort();
+        return 0;
+    }
+    return walCommit();
+}
+
+/* Add a room with the rooms table locked against appends */
+static int insertRoom(User *currentUser, Room *room, const char *description, const char *features) {
+    if (currentUser->role != ROLE_ADMIN) {
+        printf("\nAccess denied. Admin privileges required.\n");
+        return 0;
+    }
+    
+    if (isRoomExists(room->id)) {
+        printf("\nRoom number %d already exists.\n", room->id);
+        return 0;
+    }
+    
     /* Set default values */
-    newRoom.status = ROOM_STATUS_AVAILABLE;
-    newRoom.isActive = 1;
+    room->status = ROOM_STATUS_AVAILABLE;
+    room->isActive = 1;
+    room->description = storeText(description);
+    room->features = storeText(features);
     
     /* Write new room to file */
-    fp = fopen(ROOMS_FILE, "ab");
-    if (fp == NULL) {
-        printf("\nError: Could not open rooms file.\n");
+    if (room->description < 0 || room->features < 0 ||
+        tableInsert(getTable(TABLE_ROOMS), room) < 0) {
+        printf("\nError: Could not save room.\n");
         return 0;
     }
     
-    fwrite(&newRoom, sizeof(Room), 1, fp);
-    fclose(fp);
-    
     printf("\nRoom added successfully.\n");
     return 1;
 }
 
 /* Check if room already exists */
 static int isRoomExists(int roomId) {
-    FILE *fp;
-    Room tempRoom;
-    
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        return 0; /* File doesn't exist, so room doesn't exist */
-    }
+    return findRoomSlot(roomId) >= 0;
+}
+
+/* Find the table slot of an active room, or -1 if there is none */
+static int findRoomSlot(int roomId) {
+    Table *rooms = getTable(TABLE_ROOMS);
+    int slot = tableLookup(rooms, roomId);
     
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.id == roomId && tempRoom.isActive) {
-            fclose(fp);
-            return 1; /* Room exists */
-        }
+    if (slot < 0 || !((Room *)tableRecord(rooms, slot))->isActive) {
+        return -1;
     }
-    
-    fclose(fp);
-    return 0; /* Room doesn't exist */
+    return slot;
 }
 
 /* Modify an existing room */
 int modifyRoom(User *currentUser, int roomId) {
-    FILE *fp, *tempFp;
-    Room tempRoom;
+    int ok;
+    
+    /* Other terminals wait for the room until the change commits */
+    walBegin();
+    ok = lockRecord(TABLE_ROOMS, roomId) && editRoom(currentUser, roomId);
+    if (!ok) {
+        walAbort();
+        return 0;
+    }
+    return walCommit();
+}
+
+/* Modify a room once it is locked */
+static int editRoom(User *currentUser, int roomId) {
+    Table *rooms;
+    Room *room;
+    int slot;
     int choice, newType, newCapacity, statusFilter;
     double newRate;
     char newDescription[MAX_ROOM_DESC_LEN];
     char newFeatures[MAX_ROOM_FEATURES_LEN];
-    int found = 0;
     
     /* Check if user has permission */
     if (currentUser->role != ROLE_ADMIN) {
@@ -300,39 +378,27 @@ int modifyRoom(User *currentUser, int roomId) {
         return 0;
     }
     
-    /* Open rooms file */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        printf("\nError: Could not open rooms file.\n");
-        return 0;
-    }
-    
     /* Find room to modify */
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.id == roomId && tempRoom.isActive) {
-            found = 1;
-            break;
-        }
-    }
-    
-    fclose(fp);
-    
-    if (!found) {
+    slot = findRoomSlot(roomId);
+    if (slot < 0) {
         printf("\nRoom with ID %d not found.\n", roomId);
         return 0;
     }
     
+    rooms = getTable(TABLE_ROOMS);
+    room = tableRecord(rooms, slot);
+    
     /* Display room details and modification menu */
     clearScreen();
     printf("===== MODIFY ROOM =====\n");
-    printf("Room Number: %d\n", tempRoom.id);
-    printf("Type: %s\n", getRoomTypeString(tempRoom.type));
-    printf("Status: %s\n", getRoomStatusString(tempRoom.status));
-    printf("Rate: $%.2f per night\n", tempRoom.rate);
-    printf("Description: %s\n", tempRoom.description);
-    printf("Features: %s\n", tempRoom.features);
-    printf("Capacity: %d guests\n", tempRoom.capacity);
-    printf("Floor: %d\n", tempRoom.floor);
+    printf("Room Number: %d\n", room->id);
+    printf("Type: %s\n", getRoomTypeString(room->type));
+    printf("Status: %s\n", getRoomStatusString(room->status));
+    printf("Rate: $%.2f per night\n", room->rate);
+    printf("Description: %s\n", getText(room->description, newDescription, sizeof(newDescription)));
+    printf("Features: %s\n", getText(room->features, newFeatures, sizeof(newFeatures)));
+    printf("Capacity: %d guests\n", room->capacity);
+    printf("Floor: %d\n", room->floor);
     
     printf("\nWhat would you like to modify?\n");
     printf("1. Room Type\n");
@@ -349,97 +415,92 @@ int modifyRoom(User *currentUser, int roomId) {
         return 0; /* Cancelled */
     }
     
-    /* Open files for modification */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        printf("\nError: Could not open rooms file.\n");
-        return 0;
-    }
-    
-    tempFp = fopen(TEMP_FILE, "wb");
-    if (tempFp == NULL) {
-        fclose(fp);
-        printf("\nError: Could not create temporary file.\n");
-        return 0;
-    }
-    
-    /* Process each room */
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.id == roomId && tempRoom.isActive) {
-            /* Modify room based on choice */
-            switch (choice) {
-                case 1: /* Modify room type */
-                    printf("\nRoom Type:\n");
-                    printf("1. Standard\n");
-                    printf("2. Deluxe\n");
-                    printf("3. Suite\n");
-                    printf("4. Executive\n");
-                    printf("5. Presidential\n");
-                    newType = getIntInput("Enter new room type (1-5): ", 1, 5);
-                    tempRoom.type = newType;
-                    break;
-                    
-                case 2: /* Modify room rate */
-                    printf("Enter new rate per night: $");
-                    newRate = getDoubleInput("", 0.0, 10000.0);
-                    tempRoom.rate = newRate;
-                    break;
-                    
-                case 3: /* Modify description */
-                    printf("Enter new description: ");
-                    getchar(); /* Consume newline */
-                    fgets(newDescription, MAX_ROOM_DESC_LEN, stdin);
-                    newDescription[strcspn(newDescription, "\n")] = '\0'; /* Remove newline */
-                    strcpy(tempRoom.description, newDescription);
-                    break;
-                    
-                case 4: /* Modify features */
-                    printf("Enter new features: ");
-                    getchar(); /* Consume newline */
-                    fgets(newFeatures, MAX_ROOM_FEATURES_LEN, stdin);
-                    newFeatures[strcspn(newFeatures, "\n")] = '\0'; /* Remove newline */
-                    strcpy(tempRoom.features, newFeatures);
-                    break;
-                    
-                case 5: /* Modify capacity */
-                    printf("Enter new capacity (max guests): ");
-                    newCapacity = getIntInput("", 1, 20);
-                    tempRoom.capacity = newCapacity;
-                    break;
-                    
-                case 6: /* Modify room status */
-                    printf("\nRoom Status:\n");
-                    printf("1. Available\n");
-                    printf("2. Occupied\n");
-                    printf("3. Maintenance\n");
-                    printf("4. Reserved\n");
-                    printf("5. Cleaning\n");
-                    statusFilter = getIntInput("Enter new status (1-5): ", 1, 5);
-                    changeRoomStatus(roomId, statusFilter);
-                    break;
+    /* Modify room based on choice */
+    switch (choice) {
+        case 1: /* Modify room type */
+            printf("\nRoom Type:\n");
+            printf("1. Standard\n");
+            printf("2. Deluxe\n");
+            printf("3. Suite\n");
+            printf("4. Executive\n");
+            printf("5. Presidential\n");
+            newType = getIntInput("Enter new room type (1-5): ", 1, 5);
+            room->type = newType;
+            invalidateOccupancy(); /* Nights were counted under the old type */
+            break;
+            
+        case 2: /* Modify room rate */
+            printf("Enter new rate per night: $");
+            newRate = getDoubleInput("", 0.0, 10000.0);
+            room->rate = newRate;
+            break;
+            
+        case 3: /* Modify description */
+            printf("Enter new description: ");
+            getchar(); /* Consume newline */
+            fgets(newDescription, MAX_ROOM_DESC_LEN, stdin);
+            newDescription[strcspn(newDescription, "\n")] = '\0'; /* Remove newline */
+            if (!replaceText(&room->description, newDescription)) {
+                return 0;
             }
-        }
-        
-        /* Write room to temp file */
-        fwrite(&tempRoom, sizeof(Room), 1, tempFp);
+            break;
+            
+        case 4: /* Modify features */
+            printf("Enter new features: ");
+            getchar(); /* Consume newline */
+            fgets(newFeatures, MAX_ROOM_FEATURES_LEN, stdin);
+            newFeatures[strcspn(newFeatures, "\n")] = '\0'; /* Remove newline */
+            if (!replaceText(&room->features, newFeatures)) {
+                return 0;
+            }
+            break;
+            
+        case 5: /* Modify capacity */
+            printf("Enter new capacity (max guests): ");
+            newCapacity = getIntInput("", 1, 20);
+            room->capacity = newCapacity;
+            break;
+            
+        case 6: /* Modify room status */
+            printf("\nRoom Status:\n");
+            printf("1. Available\n");
+            printf("2. Occupied\n");
+            printf("3. Maintenance\n");
+            printf("4. Reserved\n");
+            printf("5. Cleaning\n");
+            statusFilter = getIntInput("Enter new status (1-5): ", 1, 5);
+            return changeRoomStatus(roomId, statusFilter);
+    }
+    
+    /* Write the modified room back to file */
+    if (!tableWriteRecord(rooms, slot)) {
+        return 0;
     }
     
-    fclose(fp);
-    fclose(tempFp);
-    
-    /* Replace original file with temp file */
-    remove(ROOMS_FILE);
-    rename(TEMP_FILE, ROOMS_FILE);
-    
     printf("\nRoom modified successfully.\n");
     return 1;
 }
 
 /* Delete a room */
 int deleteRoom(User *currentUser, int roomId) {
-    FILE *fp, *tempFp;
-    Room tempRoom;
-    int found = 0;
+    int ok;
+    
+    /* No reservation can be made for the room while it is checked */
+    walBegin();
+    ok = lockRecord(TABLE_ROOMS, roomId) && lockAppend(TABLE_RESERVATIONS) &&
+         removeRoom(currentUser, roomId);
+    if (!ok) {
+        walAbort();
+        return 0;
+    }
+    return walCommit();
+}
+
+/* Delete a room once it and the reservations table are locked */
+static int removeRoom(User *currentUser, int roomId) {
+    Table *rooms;
+    Room *room;
+    int slot;
     char confirm;
     
     /* Check if user has permission */
@@ -448,24 +509,9 @@ int deleteRoom(User *currentUser, int roomId) {
         return 0;
     }
     
-    /* Open rooms file */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        printf("\nError: Could not open rooms file.\n");
-        return 0;
-    }
-    
     /* Find room to delete */
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.id == roomId && tempRoom.isActive) {
-            found = 1;
-            break;
-        }
-    }
-    
-    fclose(fp);
-    
-    if (!found) {
+    slot = findRoomSlot(roomId);
+    if (slot < 0) {
         printf("\nRoom with ID %d not found.\n", roomId);
         return 0;
     }
@@ -485,52 +531,50 @@ int deleteRoom(User *currentUser, int roomId) {
         return 0;
     }
     
-    /* Open files for deletion */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        printf("\nError: Could not open rooms file.\n");
+    /* Mark room as inactive; its slot is reused by the next room added */
+    rooms = getTable(TABLE_ROOMS);
+    room = tableRecord(rooms, slot);
+    if (!releaseText(room->description) || !releaseText(room->features)) {
         return 0;
     }
+    room->description = room->features = 0;
+    room->isActive = 0;
     
-    tempFp = fopen(TEMP_FILE, "wb");
-    if (tempFp == NULL) {
-        fclose(fp);
-        printf("\nError: Could not create temporary file.\n");
+    if (!tableWriteRecord(rooms, slot)) {
         return 0;
     }
     
-    /* Mark room as inactive instead of deleting */
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.id == roomId) {
-            tempRoom.isActive = 0; /* Mark as inactive */
+    printf("\nRoom deleted successfully.\n");
+    return 1;
+}
+
+/* Release the texts still held by deleted rooms (rooms table locked) */
+int releaseDeletedRoomTexts(void) {
+    Table *rooms = getTable(TABLE_ROOMS);
+    
+    for (int i = 0; i < rooms->count; i++) {
+        Room *room = tableRecord(rooms, i);
+        
+        if (room->isActive || (room->description == 0 && room->features == 0)) {
+            continue;
+        }
+        if (!releaseText(room->description) || !releaseText(room->features)) {
+            return 0;
+        }
+        room->description = room->features = 0;
+        if (!tableWriteRecord(rooms, i)) {
+            return 0;
         }
-        fwrite(&tempRoom, sizeof(Room), 1, tempFp);
     }
-    
-    fclose(fp);
-    fclose(tempFp);
-    
-    /* Replace original file with temp file */
-    remove(ROOMS_FILE);
-    rename(TEMP_FILE, ROOMS_FILE);
-    
-    printf("\nRoom deleted successfully.\n");
     return 1;
 }
 
 /* List all rooms */
 void listRooms(User *currentUser, RoomStatus statusFilter) {
-    FILE *fp;
-    Room tempRoom;
+    Table *rooms = getTable(TABLE_ROOMS);
+    char description[MAX_ROOM_DESC_LEN];
     int count = 0;
     
-    /* Open rooms file */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        printf("\nError: Could not open rooms file.\n");
-        return;
-    }
-    
     /* Display header */
     clearScreen();
     printf("===== ROOM LIST =====\n");
@@ -544,22 +588,21 @@ void listRooms(User *currentUser, RoomStatus statusFilter) {
     printf("---------------------------------------------------------------------------------\n");
     
     /* Display each room */
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.isActive && (statusFilter == 0 || tempRoom.status == statusFilter)) {
+    for (int i = 0; i < rooms->count; i++) {
+        Room *room = tableRecord(rooms, i);
+        if (room->isActive && (statusFilter == 0 || room->status == statusFilter)) {
             printf("%-6d %-12s %-12s $%-9.2f %-8d %-10d %s\n", 
-                   tempRoom.id, 
-                   getRoomTypeString(tempRoom.type), 
-                   getRoomStatusString(tempRoom.status), 
-                   tempRoom.rate,
-                   tempRoom.capacity,
-                   tempRoom.floor,
-                   tempRoom.description);
+                   room->id, 
+                   getRoomTypeString(room->type), 
+                   getRoomStatusString(room->status), 
+                   room->rate,
+                   room->capacity,
+                   room->floor,
+                   getText(room->description, description, sizeof(description)));
             count++;
         }
     }
     
-    fclose(fp);
-    
     /* Display footer */
     printf("---------------------------------------------------------------------------------\n");
     printf("Total rooms: %d\n", count);
@@ -567,11 +610,11 @@ void listRooms(User *currentUser, RoomStatus statusFilter) {
 
 /* Search for rooms based on criteria */
 void searchRooms(User *currentUser) {
-    FILE *fp;
-    Room tempRoom;
+    Table *rooms;
     int typeFilter = 0;
     int capacityFilter = 0;
     double maxRateFilter = 0.0;
+    char description[MAX_ROOM_DESC_LEN];
     int count = 0;
     
     /* Get search criteria */
@@ -592,12 +635,7 @@ void searchRooms(User *currentUser) {
     printf("\nMaximum Rate per Night (0 for any): $");
     maxRateFilter = getDoubleInput("", 0.0, 10000.0);
     
-    /* Open rooms file */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        printf("\nError: Could not open rooms file.\n");
-        return;
-    }
+    rooms = getTable(TABLE_ROOMS);
     
     /* Display header */
     printf("\n===== SEARCH RESULTS =====\n");
@@ -606,87 +644,152 @@ void searchRooms(User *currentUser) {
     printf("---------------------------------------------------------------------------------\n");
     
     /* Display matching rooms */
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.isActive && 
-            (typeFilter == 0 || tempRoom.type == typeFilter) &&
-            (capacityFilter == 0 || tempRoom.capacity >= capacityFilter) &&
-            (maxRateFilter == 0.0 || tempRoom.rate <= maxRateFilter)) {
+    for (int i = 0; i < rooms->count; i++) {
+        Room *room = tableRecord(rooms, i);
+        if (room->isActive && 
+            (typeFilter == 0 || room->type == typeFilter) &&
+            (capacityFilter == 0 || room->capacity >= capacityFilter) &&
+            (maxRateFilter == 0.0 || room->rate <= maxRateFilter)) {
             
             printf("%-6d %-12s %-12s $%-9.2f %-8d %-10d %s\n", 
-                   tempRoom.id, 
-                   getRoomTypeString(tempRoom.type), 
-                   getRoomStatusString(tempRoom.status), 
-                   tempRoom.rate,
-                   tempRoom.capacity,
-                   tempRoom.floor,
-                   tempRoom.description);
+                   room->id, 
+                   getRoomTypeString(room->type), 
+                   getRoomStatusString(room->status), 
+                   room->rate,
+                   room->capacity,
+                   room->floor,
+                   getText(room->description, description, sizeof(description)));
             count++;
         }
     }
     
-    fclose(fp);
-    
     /* Display footer */
     printf("---------------------------------------------------------------------------------\n");
     printf("Total matching rooms: %d\n", count);
 }
 
-/* Change the status of a room */
-int changeRoomStatus(int roomId, RoomStatus newStatus) {
-    FILE *fp, *tempFp;
-    Room tempRoom;
-    int found = 0;
-    
-    /* Open rooms file */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        printf("\nError: Could not open rooms file.\n");
+/* List rooms free for a date range that match the given filters */
+int listFreeRooms(Date checkInDate, Date checkOutDate, RoomType typeFilter,
+                  int capacityFilter, double maxRateFilter) {
+    Table *rooms = getTable(TABLE_ROOMS);
+    char startDate[DATE_STRING_LEN], endDate[DATE_STRING_LEN];
+    char description[MAX_ROOM_DESC_LEN];
+    int *roomIds;
+    int count;
+    
+    roomIds = malloc((size_t)(rooms->count + 1) * sizeof(int));
+    if (roomIds == NULL) {
+        printf("\nError: Out of memory.\n");
         return 0;
     }
     
-    /* Find room to modify */
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.id == roomId && tempRoom.isActive) {
-            found = 1;
+    count = findFreeRooms(checkInDate, checkOutDate, typeFilter, capacityFilter, maxRateFilter,
+                          roomIds, rooms->count);
+    
+    /* Display header */
+    dateToString(checkInDate, startDate);
+    dateToString(checkOutDate, endDate);
+    printf("\n===== ROOMS FREE FROM %s TO %s =====\n", startDate, endDate);
+    printf("%-6s %-12s %-12s %-10s %-8s %-10s %-s\n", 
+           "Room", "Type", "Status", "Rate", "Capacity", "Floor", "Description");
+    printf("---------------------------------------------------------------------------------\n");
+    
+    /* Display each free room */
+    for (int i = 0; i < count; i++) {
+        Room *room = tableRecord(rooms, findRoomSlot(roomIds[i]));
+        printf("%-6d %-12s %-12s $%-9.2f %-8d %-10d %s\n", 
+               room->id, 
+               getRoomTypeString(room->type), 
+               getRoomStatusString(room->status), 
+               room->rate,
+               room->capacity,
+               room->floor,
+               getText(room->description, description, sizeof(description)));
+    }
+    
+    /* Display footer */
+    printf("---------------------------------------------------------------------------------\n");
+    printf("Total free rooms: %d\n", count);
+    
+    free(roomIds);
+    return count;
+}
+
+/* Search for rooms free for a date range */
+void searchFreeRooms(User *currentUser) {
+    char startDate[DATE_STRING_LEN], endDate[DATE_STRING_LEN];
+    Date checkIn, checkOut;
+    int typeFilter;
+    int capacityFilter;
+    double maxRateFilter;
+    
+    clearScreen();
+    printf("===== FIND FREE ROOMS =====\n");
+    
+    do {
+        printf("Check-in Date (YYYY-MM-DD): ");
+        getStringInput(NULL, startDate, DATE_STRING_LEN);
+        printf("Check-out Date (YYYY-MM-DD): ");
+        getStringInput(NULL, endDate, DATE_STRING_LEN);
+        if (!validateDate(startDate) || !validateDate(endDate) ||
+            !dateFromString(startDate, &checkIn) || !dateFromString(endDate, &checkOut) ||
+            checkIn >= checkOut) {
+            printf("\nInvalid dates. Check-out must be after check-in.\n\n");
+        } else {
             break;
         }
-    }
+    } while (1);
     
-    fclose(fp);
+    printf("\nRoom Type (0 for any):\n");
+    printf("1. Standard\n");
+    printf("2. Deluxe\n");
+    printf("3. Suite\n");
+    printf("4. Executive\n");
+    printf("5. Presidential\n");
+    typeFilter = getIntInput("Enter room type (0-5): ", 0, 5);
     
-    if (!found) {
-        printf("\nRoom with ID %d not found.\n", roomId);
-        return 0;
-    }
+    printf("\nMinimum Capacity (0 for any): ");
+    capacityFilter = getIntInput("", 0, 20);
     
-    /* Open files for modification */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        printf("\nError: Could not open rooms file.\n");
-        return 0;
-    }
+    printf("\nMaximum Rate per Night (0 for any): $");
+    maxRateFilter = getDoubleInput("", 0.0, 10000.0);
     
-    tempFp = fopen(TEMP_FILE, "wb");
-    if (tempFp == NULL) {
-        fclose(fp);
-        printf("\nError: Could not create temporary file.\n");
+    listFreeRooms(checkIn, checkOut, typeFilter, capacityFilter, maxRateFilter);
+}
+
+/* Change the status of a room */
+int changeRoomStatus(int roomId, RoomStatus newStatus) {
+    int ok;
+    
+    walBegin();
+    ok = lockRecord(TABLE_ROOMS, roomId) && setRoomStatus(roomId, newStatus);
+    if (!ok) {
+        walAbort();
         return 0;
     }
+    return walCommit();
+}
+
+/* Change the status of a room once it is locked */
+static int setRoomStatus(int roomId, RoomStatus newStatus) {
+    Table *rooms;
+    Room *room;
+    int slot;
     
-    /* Process each room */
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.id == roomId && tempRoom.isActive) {
-            tempRoom.status = newStatus;
-        }
-        fwrite(&tempRoom, sizeof(Room), 1, tempFp);
+    /* Find room to modify */
+    slot = findRoomSlot(roomId);
+    if (slot < 0) {
+        printf("\nRoom with ID %d not found.\n", roomId);
+        return 0;
     }
     
-    fclose(fp);
-    fclose(tempFp);
+    rooms = getTable(TABLE_ROOMS);
+    room = tableRecord(rooms, slot);
+    room->status = newStatus;
     
-    /* Replace original file with temp file */
-    remove(ROOMS_FILE);
-    rename(TEMP_FILE, ROOMS_FILE);
+    if (!tableWriteRecord(rooms, slot)) {
+        return 0;
+    }
     
     printf("\nRoom status changed to %s.\n", getRoomStatusString(newStatus));
     return 1;
@@ -694,31 +797,18 @@ int changeRoomStatus(int roomId, RoomStatus newStatus) {
 
 /* Get a room by ID */
 int getRoomById(int roomId, Room *room) {
-    FILE *fp;
-    Room tempRoom;
-    int found = 0;
-    
-    /* Open rooms file */
-    fp = fopen(ROOMS_FILE, "rb");
-    if (fp == NULL) {
-        return 0; /* File not found */
-    }
+    int slot = findRoomSlot(roomId);
     
-    /* Find room */
-    while (fread(&tempRoom, sizeof(Room), 1, fp) == 1) {
-        if (tempRoom.id == roomId && tempRoom.isActive) {
-            *room = tempRoom;
-            found = 1;
-            break;
-        }
+    if (slot < 0) {
+        return 0; /* Room not found */
     }
     
-    fclose(fp);
-    return found;
+    *room = *(Room *)tableRecord(getTable(TABLE_ROOMS), slot);
+    return 1;
 }
 
 /* Check if a room is available for a given date range */
-int isRoomAvailable(int roomId, const char *startDate, const char *endDate) {
+int isRoomAvailable(int roomId, Date startDate, Date endDate) {
     /* This function will be implemented in reservation.c */
     /* It will check if there are any reservations for this room in the given date range */
     return checkRoomAvailability(roomId, startDate, endDate);
@@ -731,6 +821,7 @@ void roomManagementMenu(User *currentUser) {
     int statusFilter;
     
     do {
+        refreshTables();
         clearScreen();
         printf("===== ROOM MANAGEMENT =====\n");
         printf("1. List All Rooms\n");
@@ -740,10 +831,11 @@ void roomManagementMenu(User *currentUser) {
         printf("5. Modify Room\n");
         printf("6. Change Room Status\n");
         printf("7. Delete Room\n");
+        printf("8. Find Free Rooms for Dates\n");
         printf("0. Back to Main Menu\n");
         printf("============================\n");
         
-        choice = getIntInput("Enter your choice: ", 0, 7);
+        choice = getIntInput("Enter your choice: ", 0, 8);
         
         switch (choice) {
             case 1: /* List All Rooms */
@@ -812,6 +904,10 @@ void roomManagementMenu(User *currentUser) {
                 }
                 break;
                 
+            case 8: /* Find Free Rooms for Dates */
+                searchFreeRooms(currentUser);
+                break;
+                
             case 0: /* Back to Main Menu */
                 break;
                 
@@ -10,6 +10,8 @@
 #define ROOM_H
 
 #include "auth.h" /* For User type */
+#include "utils.h" /* For Date type */
+#include "textheap.h" /* For TextRef type */
 
 /* Room status definitions */
 typedef enum {
@@ -44,8 +46,8 @@ typedef struct {
     RoomType type;                              /* Room type */
     RoomStatus status;                          /* Current status */
     double rate;                                /* Rate per night */
-    char description[MAX_ROOM_DESC_LEN];        /* Room description */
-    char features[MAX_ROOM_FEATURES_LEN];       /* Room features */
+    TextRef description;                        /* Room description */
+    TextRef features;                           /* Room features */
     int capacity;                               /* Maximum occupancy */
     int floor;                                  /* Floor number */
     int isActive;                               /* Whether room is active in system */
@@ -56,12 +58,17 @@ const char* getRoomStatusString(RoomStatus status);
 const char* getRoomTypeString(RoomType type);
 int initializeRoomData(void);
 int addRoom(User *currentUser);
+int createRoom(User *currentUser, Room *room, const char *description, const char *features);
 int modifyRoom(User *currentUser, int roomId);
 int deleteRoom(User *currentUser, int roomId);
+int releaseDeletedRoomTexts(void);
 int changeRoomStatus(int roomId, RoomStatus newStatus);
 int getRoomById(int roomId, Room *room);
 void listRooms(User *currentUser, RoomStatus statusFilter);
 void searchRooms(User *currentUser);
+int listFreeRooms(Date checkInDate, Date checkOutDate, RoomType typeFilter,
+                  int capacityFilter, double maxRateFilter);
+void searchFreeRooms(User *currentUser);
 void roomManagementMenu(User *currentUser);
 
 #endif /* ROOM_H */
\ No newline at end of file
@@ -0,0 +1,688 @@
+/**
+ * Hotel Management System
+ * server.c - Local server implementation
+ *
+ * This file implements server mode and the client side of it. The
+ * server's main thread polls the listening socket and every idle
+ * connection. A connection with a request waiting is queued for the
+ * worker pool; the worker that takes it reads one request, answers it
+ * and hands the connection back to be polled again. A connection is
+ * served by one worker at a time, so its requests are answered in order.
+ *
+ * Snapshots and change lists hold their table's read-write lock for
+ * reading. A commit holds the locks of the tables it changes for
+ * writing, taken in TableId order, while it applies the entries and
+ * bumps each table's version in LOCK_FILE so other clients catch up.
+ * Checkpoints read every table, so they run with all locks held.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include "server.h"
+#include "wal.h"
+#include "lock.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+/* Unix domain sockets are not available: every terminal uses the data files */
+int runServer(void) {
+    printf("\nError: Server mode is not supported on this platform.\n");
+    return 1;
+}
+
+int connectServer(void) { return 0; }
+int serverConnected(void) { return 0; }
+
+long serverCall(ServerOp op, int table, int arg, int arg2, const void *data, size_t length, char **payload) {
+    (void)op; (void)table; (void)arg; (void)arg2; (void)data; (void)length;
+    *payload = NULL;
+    return -1;
+}
+
+int serverCommit(const char *data, size_t length) { (void)data; (void)length; return 0; }
+
+#else
+
+#define SERVER_MAX_THREADS 64
+#define SERVER_MAX_MESSAGE (1 << 30)   /* Largest request payload accepted */
+
+/* A list of connection descriptors */
+typedef struct {
+    int *fds;
+    int count;
+    int capacity;
+} FdList;
+
+static pthread_rwlock_t tableLocks[TABLE_COUNT];
+static pthread_mutex_t queueMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueReady = PTHREAD_COND_INITIALIZER;
+static FdList ready;                    /* Connections with a request waiting */
+static FdList returned;                 /* Connections answered, to be polled again */
+static int wakePipe[2] = { -1, -1 };    /* Wakes the poller */
+static volatile sig_atomic_t stopping = 0;
+
+static int serverFd = -1;               /* Client: connection to the server */
+static char *replyBuffer = NULL;        /* Client: payload of the last reply */
+static size_t replyCapacity = 0;
+
+/* Read exactly length bytes, failing at the end of the stream */
+static int readFully(int fd, void *data, size_t length) {
+    char *p = data;
+
+    while (length > 0) {
+        ssize_t n = read(fd, p, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        p += n;
+        length -= (size_t)n;
+    }
+    return 1;
+}
+
+/* Write exactly length bytes */
+static int writeFully(int fd, const void *data, size_t length) {
+    const char *p = data;
+
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        p += n;
+        length -= (size_t)n;
+    }
+    return 1;
+}
+
+/* Add a descriptor to a list */
+static int pushFd(FdList *list, int fd) {
+    if (list->count == list->capacity) {
+        int newCapacity = list->capacity > 0 ? list->capacity * 2 : 16;
+        int *newFds = realloc(list->fds, (size_t)newCapacity * sizeof(int));
+
+        if (newFds == NULL) {
+            return 0;
+        }
+        list->fds = newFds;
+        list->capacity = newCapacity;
+    }
+    list->fds[list->count++] = fd;
+    return 1;
+}
+
+/* Close every descriptor in a list and empty it */
+static void closeFds(FdList *list) {
+    for (int i = 0; i < list->count; i++) {
+        close(list->fds[i]);
+    }
+    list->count = 0;
+}
+
+/* Lock every table in TableId order, one of them for writing, or none if -1 */
+static void lockTables(int writer) {
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        if (i == writer) {
+            pthread_rwlock_wrlock(&tableLocks[i]);
+        } else {
+            pthread_rwlock_rdlock(&tableLocks[i]);
+        }
+    }
+}
+
+/* Release the locks taken by lockTables */
+static void unlockTables(void) {
+    for (int i = TABLE_COUNT - 1; i >= 0; i--) {
+        pthread_rwlock_unlock(&tableLocks[i]);
+    }
+}
+
+/* Write the log to the data files while no table can change */
+static int checkpointAll(void) {
+    int ok;
+
+    lockTables(-1);
+    ok = walCheckpoint();
+    unlockTables();
+    return ok;
+}
+
+/* Send a reply */
+static int sendReply(int fd, int status, const void *data, size_t length) {
+    ServerMessage reply;
+
+    memset(&reply, 0, sizeof(reply));
+    reply.op = status;
+    reply.length = (int)length;
+    return writeFully(fd, &reply, sizeof(reply)) && (length == 0 || writeFully(fd, data, length));
+}
+
+/* Send an error message as the reply */
+static int sendError(int fd, const char *message) {
+    return sendReply(fd, SERVER_ERROR, message, strlen(message));
+}
+
+/* Fill in the state of a table at the start of a reply */
+static void describeTable(Table *table, ServerTableState *state, int records, int reset) {
+    memset(state, 0, sizeof(*state));
+    state->count = table->count;
+    state->nextId = table->nextId;
+    state->version = table->version;
+    state->records = records;
+    state->reset = reset;
+}
+
+/* Send every record of a table (lock held) */
+static int sendSnapshot(int fd, Table *table) {
+    ServerMessage reply;
+    ServerTableState state;
+    size_t bytes = (size_t)table->count * table->recordSize;
+
+    memset(&reply, 0, sizeof(reply));
+    reply.op = SERVER_OK;
+    reply.length = (int)(sizeof(state) + bytes);
+    describeTable(table, &state, table->count, 0);
+
+    /* The records go straight from the table to the socket */
+    return writeFully(fd, &reply, sizeof(reply)) && writeFully(fd, &state, sizeof(state)) &&
+           (bytes == 0 || writeFully(fd, table->records, bytes));
+}
+
+/* Send the records in the given slots, each preceded by its slot (lock held) */
+static int sendSlots(int fd, Table *table, const int *slots, int count, int reset) {
+    ServerTableState state;
+    size_t entrySize = sizeof(int) + table->recordSize;
+    size_t length = sizeof(state) + (size_t)count * entrySize;
+    char *payload = malloc(length);
+    int ok;
+
+    if (payload == NULL) {
+        return sendError(fd, "The server is out of memory.");
+    }
+    describeTable(table, &state, count, reset);
+    memcpy(payload, &state, sizeof(state));
+    for (int i = 0; i < count; i++) {
+        char *entry = payload + sizeof(state) + (size_t)i * entrySize;
+        memcpy(entry, &slots[i], sizeof(int));
+        memcpy(entry + sizeof(int), tableRecord(table, slots[i]), table->recordSize);
+    }
+    ok = sendReply(fd, SERVER_OK, payload, length);
+    free(payload);
+    return ok;
+}
+
+/* Send the records changed since a version, or ask for a snapshot (lock held) */
+static int sendChanges(int fd, Table *table, int since) {
+    int *slots = malloc(TABLE_CHANGE_LOG * sizeof(int));
+    int count, ok;
+
+    if (slots == NULL) {
+        return sendError(fd, "The server is out of memory.");
+    }
+    count = tableChangedSlots(table, since, slots);
+    ok = count < 0 ? sendSlots(fd, table, NULL, 0, 1) : sendSlots(fd, table, slots, count, 0);
+    free(slots);
+    return ok;
+}
+
+/* Send one record and every record from a slot on (lock held) */
+static int sendRecords(int fd, Table *table, int slot, int from) {
+    int *slots;
+    int count = 0, ok;
+
+    if (from < 0 || from > table->count) {
+        from = table->count;
+    }
+    slots = malloc(((size_t)(table->count - from) + 1) * sizeof(int));
+    if (slots == NULL) {
+        return sendError(fd, "The server is out of memory.");
+    }
+    if (slot >= 0 && slot < from) {
+        slots[count++] = slot;
+    }
+    for (int s = from; s < table->count; s++) {
+        slots[count++] = s;
+    }
+    ok = sendSlots(fd, table, slots, count, 0);
+    free(slots);
+    return ok;
+}
+
+/* Apply a client's transaction and send back each table's version before and after */
+static int commitForClient(int fd, const char *data, size_t length) {
+    int touched[TABLE_COUNT] = {0};
+    int versions[TABLE_COUNT * 3];
+    int count = 0, ok;
+
+    if (!walCheckTransaction(data, length, touched)) {
+        return sendError(fd, "The server received a damaged transaction.");
+    }
+
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        if (touched[i]) {
+            pthread_rwlock_wrlock(&tableLocks[i]);
+            versions[count * 3] = i;
+            versions[count * 3 + 1] = getTable((TableId)i)->version;
+            count++;
+        }
+    }
+    ok = walApply(data, length);
+    for (int i = 0; i < count; i++) {
+        TableId id = (TableId)versions[i * 3];
+
+        versions[i * 3 + 2] = getTable(id)->version;
+        if (versions[i * 3 + 2] != versions[i * 3 + 1]) {
+            /* Tell the other clients before they can read the table again */
+            noteTableWritten(id, 1);
+        }
+    }
+    for (int i = TABLE_COUNT - 1; i >= 0; i--) {
+        if (touched[i]) {
+            pthread_rwlock_unlock(&tableLocks[i]);
+        }
+    }
+
+    if (!ok) {
+        return sendError(fd, "The server could not apply the transaction.");
+    }
+    ok = sendReply(fd, SERVER_OK, versions, (size_t)count * 3 * sizeof(int));
+    if (walCheckpointDue()) {
+        checkpointAll();
+    }
+    return ok;
+}
+
+/* Drop a table's deleted records for a client and reply with how many were dropped */
+static int compactForClient(int fd, TableId id) {
+    int dropped;
+
+    /* Compaction checkpoints the log, which reads every table */
+    lockTables((int)id);
+    dropped = tableCompact(getTable(id));
+    unlockTables();
+    return dropped >= 0 ? sendReply(fd, SERVER_OK, &dropped, sizeof(dropped))
+                        : sendError(fd, "The server could not compact the table.");
+}
+
+/* Read one request from a connection and answer it; 0 means close the connection */
+static int handleRequest(int fd) {
+    ServerMessage request;
+    char *data = NULL;
+    Table *table;
+    int ok;
+
+    if (!readFully(fd, &request, sizeof(request))) {
+        return 0; /* The client has gone */
+    }
+    if (request.length < 0 || request.length > SERVER_MAX_MESSAGE ||
+        request.table < 0 || request.table >= TABLE_COUNT) {
+        return 0;
+    }
+    if (request.length > 0) {
+        data = malloc((size_t)request.length);
+        if (data == NULL || !readFully(fd, data, (size_t)request.length)) {
+            free(data);
+            return 0;
+        }
+    }
+
+    table = getTable((TableId)request.table);
+    switch (request.op) {
+        case SERVER_OP_SNAPSHOT:
+            pthread_rwlock_rdlock(&tableLocks[request.table]);
+            ok = sendSnapshot(fd, table);
+            pthread_rwlock_unlock(&tableLocks[request.table]);
+            break;
+        case SERVER_OP_CHANGES:
+            pthread_rwlock_rdlock(&tableLocks[request.table]);
+            ok = sendChanges(fd, table, request.arg);
+            pthread_rwlock_unlock(&tableLocks[request.table]);
+            break;
+        case SERVER_OP_RECORDS:
+            pthread_rwlock_rdlock(&tableLocks[request.table]);
+            ok = sendRecords(fd, table, request.arg, request.arg2);
+            pthread_rwlock_unlock(&tableLocks[request.table]);
+            break;
+        case SERVER_OP_COMMIT:
+            ok = commitForClient(fd, data, (size_t)request.length);
+            break;
+        case SERVER_OP_COMPACT:
+            ok = compactForClient(fd, (TableId)request.table);
+            break;
+        case SERVER_OP_CHECKPOINT:
+            ok = checkpointAll() ? sendReply(fd, SERVER_OK, NULL, 0)
+                                 : sendError(fd, "The server could not write the data files.");
+            break;
+        default:
+            ok = sendError(fd, "The server does not know this request.");
+            break;
+    }
+    free(data);
+    return ok;
+}
+
+/* Worker thread: answer queued requests until the server stops */
+static void *workerMain(void *arg) {
+    (void)arg;
+    for (;;) {
+        int fd;
+
+        pthread_mutex_lock(&queueMutex);
+        while (ready.count == 0 && !stopping) {
+            pthread_cond_wait(&queueReady, &queueMutex);
+        }
+        if (ready.count == 0) {
+            pthread_mutex_unlock(&queueMutex);
+            break;
+        }
+        fd = ready.fds[--ready.count];
+        pthread_mutex_unlock(&queueMutex);
+
+        if (handleRequest(fd)) {
+            pthread_mutex_lock(&queueMutex);
+            if (!pushFd(&returned, fd)) {
+                close(fd);
+            }
+            pthread_mutex_unlock(&queueMutex);
+            if (write(wakePipe[1], "", 1) < 0) {
+                /* The poller is already awake */
+            }
+        } else {
+            close(fd);
+        }
+    }
+    return NULL;
+}
+
+/* Stop the server on SIGINT or SIGTERM */
+static void onSignal(int signal) {
+    (void)signal;
+    stopping = 1;
+    if (write(wakePipe[1], "", 1) < 0) {
+        /* The poller is already awake */
+    }
+}
+
+/* Open the listening socket, replacing one left by a server that did not stop cleanly */
+static int openListener(void) {
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        printf("\nError: Could not create a socket.\n");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SERVER_SOCKET, sizeof(addr.sun_path) - 1);
+    unlink(SERVER_SOCKET);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        printf("\nError: Could not listen on %s.\n", SERVER_SOCKET);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Serve the data directory until interrupted */
+int runServer(void) {
+    pthread_t threads[SERVER_MAX_THREADS];
+    struct pollfd *polls = NULL;
+    FdList idle = { NULL, 0, 0 };
+    sigset_t signals, previous;
+    long threadCount;
+    int listenFd;
+
+    if (serverConnected()) {
+        printf("\nError: A server is already running for this data directory.\n");
+        return 1;
+    }
+    if (otherTerminalsActive()) {
+        printf("\nError: Other terminals are using the data directory. Close them before starting the server.\n");
+        return 1;
+    }
+
+    /* Every table is kept in memory for the clients */
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        if (!getTable((TableId)i)->loaded) {
+            return 1;
+        }
+        pthread_rwlock_init(&tableLocks[i], NULL);
+    }
+    tableTrackChanges();
+    walManualCheckpoints();
+
+    listenFd = openListener();
+    if (listenFd < 0 || pipe(wakePipe) != 0) {
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threadCount < 2) {
+        threadCount = 2;
+    } else if (threadCount > SERVER_MAX_THREADS) {
+        threadCount = SERVER_MAX_THREADS;
+    }
+
+    /* Only the poller handles signals */
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous);
+    for (long i = 0; i < threadCount; i++) {
+        if (pthread_create(&threads[i], NULL, workerMain, NULL) != 0) {
+            threadCount = i;
+            break;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (threadCount == 0) {
+        printf("\nError: Could not start worker threads.\n");
+        return 1;
+    }
+
+    printf("Serving %s with %ld worker threads. Press Ctrl+C to stop.\n", SERVER_SOCKET, threadCount);
+    fflush(stdout);
+
+    while (!stopping) {
+        int polled = idle.count;
+        struct pollfd *newPolls = realloc(polls, (size_t)(polled + 2) * sizeof(struct pollfd));
+        int kept = 0;
+
+        if (newPolls == NULL) {
+            printf("\nError: Out of memory.\n");
+            break;
+        }
+        polls = newPolls;
+        polls[0].fd = listenFd;
+        polls[0].events = POLLIN;
+        polls[1].fd = wakePipe[0];
+        polls[1].events = POLLIN;
+        for (int i = 0; i < polled; i++) {
+            polls[i + 2].fd = idle.fds[i];
+            polls[i + 2].events = POLLIN;
+        }
+        if (poll(polls, (nfds_t)(polled + 2), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (polls[0].revents & POLLIN) {
+            int fd = accept(listenFd, NULL, NULL);
+            if (fd >= 0 && !pushFd(&idle, fd)) {
+                close(fd);
+            }
+        }
+
+        pthread_mutex_lock(&queueMutex);
+        if (polls[1].revents & POLLIN) {
+            char drain[64];
+            if (read(wakePipe[0], drain, sizeof(drain)) < 0) {
+                /* Nothing to drain */
+            }
+            for (int i = 0; i < returned.count; i++) {
+                if (!pushFd(&idle, returned.fds[i])) {
+                    close(returned.fds[i]);
+                }
+            }
+            returned.count = 0;
+        }
+
+        /* Connections polled with a request waiting go to the workers;
+           the ones added above were not polled and come after them */
+        for (int i = 0; i < idle.count; i++) {
+            if (i < polled && (polls[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) &&
+                pushFd(&ready, idle.fds[i])) {
+                continue;
+            }
+            idle.fds[kept++] = idle.fds[i];
+        }
+        idle.count = kept;
+        pthread_cond_broadcast(&queueReady);
+        pthread_mutex_unlock(&queueMutex);
+    }
+
+    /* Let the workers finish what they are answering */
+    pthread_mutex_lock(&queueMutex);
+    stopping = 1;
+    closeFds(&ready);
+    pthread_cond_broadcast(&queueReady);
+    pthread_mutex_unlock(&queueMutex);
+    for (long i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    closeFds(&returned);
+    closeFds(&idle);
+    free(idle.fds);
+    free(polls);
+    close(listenFd);
+    unlink(SERVER_SOCKET);
+
+    if (!checkpointAll()) {
+        return 1;
+    }
+    printf("\nServer stopped.\n");
+    return 0;
+}
+
+/* Connect to the server for the data directory, if one is running */
+int connectServer(void) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (serverFd >= 0) {
+        return 1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SERVER_SOCKET, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return 0;
+    }
+
+    /* A server that goes away is reported by the next request */
+    signal(SIGPIPE, SIG_IGN);
+    serverFd = fd;
+    return 1;
+}
+
+/* Check whether this process is a client of a server */
+int serverConnected(void) {
+    return serverFd >= 0;
+}
+
+/* Give up after losing the server: the cached tables can no longer be trusted */
+static void lostServer(void) {
+    printf("\nError: Lost the connection to the server.\n");
+    exit(1);
+}
+
+/* Send a request to the server and wait for the reply */
+long serverCall(ServerOp op, int table, int arg, int arg2, const void *data, size_t length, char **payload) {
+    ServerMessage message;
+
+    memset(&message, 0, sizeof(message));
+    message.op = op;
+    message.table = table;
+    message.arg = arg;
+    message.arg2 = arg2;
+    message.length = (int)length;
+    if (!writeFully(serverFd, &message, sizeof(message)) ||
+        (length > 0 && !writeFully(serverFd, data, length)) ||
+        !readFully(serverFd, &message, sizeof(message)) || message.length < 0) {
+        lostServer();
+    }
+
+    if ((size_t)message.length + 1 > replyCapacity) {
+        char *newBuffer = realloc(replyBuffer, (size_t)message.length + 1);
+        if (newBuffer == NULL) {
+            printf("\nError: Out of memory while reading from the server.\n");
+            exit(1);
+        }
+        replyBuffer = newBuffer;
+        replyCapacity = (size_t)message.length + 1;
+    }
+    if (message.length > 0 && !readFully(serverFd, replyBuffer, (size_t)message.length)) {
+        lostServer();
+    }
+    replyBuffer[message.length] = '\0';
+    *payload = replyBuffer;
+
+    if (message.op != SERVER_OK) {
+        printf("\nError: %s\n", replyBuffer);
+        return -1;
+    }
+    return message.length;
+}
+
+/* Send a transaction to the server and wait until it is committed */
+int serverCommit(const char *data, size_t length) {
+    char *payload;
+    long replyLength = serverCall(SERVER_OP_COMMIT, 0, 0, 0, data, length, &payload);
+
+    if (replyLength < 0) {
+        return 0;
+    }
+
+    /* A table no other client changed meanwhile now matches the server's copy */
+    for (long pos = 0; pos + (long)(3 * sizeof(int)) <= replyLength; pos += (long)(3 * sizeof(int))) {
+        int versions[3];
+
+        memcpy(versions, payload + pos, sizeof(versions));
+        if (versions[0] >= 0 && versions[0] < TABLE_COUNT) {
+            Table *table = getTable((TableId)versions[0]);
+            if (table->version == versions[1]) {
+                table->version = versions[2];
+            }
+        }
+    }
+    return 1;
+}
+
+#endif
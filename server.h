@@ -0,0 +1,108 @@
+/**
+ * Hotel Management System
+ * server.h - Local server header
+ *
+ * This file contains declarations for server mode, in which one process
+ * keeps every table in memory and serves the other terminals over a
+ * Unix domain socket. Requests are read by a pool of worker threads;
+ * reads of a table run in parallel and changes to it are serialised by
+ * a read-write lock per table.
+ *
+ * A client runs the usual menus on a copy of the tables fetched from
+ * the server. It locks records through lock.h as any terminal does,
+ * catches up on changes by asking for the records changed since the
+ * version it holds, and sends each committed transaction to the server
+ * as the entries it would have written to the log.
+ *
+ * Every message is a ServerMessage header followed by length bytes of
+ * payload. Replies to table requests start with a ServerTableState.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+#include "table.h"
+
+/* File paths */
+#define SERVER_SOCKET "data/hotel.sock"
+
+/* Request types */
+typedef enum {
+    SERVER_OP_SNAPSHOT = 1,     /* Every record of a table */
+    SERVER_OP_CHANGES,          /* Records changed since version arg */
+    SERVER_OP_RECORDS,          /* Records from slot arg2 on, and the record in slot arg */
+    SERVER_OP_COMMIT,           /* Apply the logged transaction in the payload */
+    SERVER_OP_COMPACT,          /* Drop the deleted records of a table */
+    SERVER_OP_CHECKPOINT        /* Write the log to the data files */
+} ServerOp;
+
+/* Reply status, sent in the op field */
+#define SERVER_OK 0
+#define SERVER_ERROR 1          /* Payload is the error message */
+
+/* Message header */
+typedef struct {
+    int op;                     /* ServerOp, or the status of a reply */
+    int table;                  /* TableId the request is about */
+    int arg;
+    int arg2;
+    int length;                 /* Bytes of payload after the header */
+} ServerMessage;
+
+/* Start of the reply to a table request */
+typedef struct {
+    int count;                  /* Records in the table */
+    int nextId;                 /* Next id the table hands out */
+    int version;                /* Version the records sent bring the caller to */
+    int records;                /* Records that follow */
+    int reset;                  /* Changes are no longer known; fetch a snapshot */
+} ServerTableState;
+
+/**
+ * Serve the data directory until interrupted
+ *
+ * @return Exit status for the process
+ */
+int runServer(void);
+
+/**
+ * Connect to the server for the data directory, if one is running
+ *
+ * @return 1 if connected, 0 otherwise
+ */
+int connectServer(void);
+
+/**
+ * Check whether this process is a client of a server
+ *
+ * @return 1 if connected to a server, 0 otherwise
+ */
+int serverConnected(void);
+
+/**
+ * Send a request to the server and wait for the reply
+ *
+ * Exits the process if the connection to the server is lost.
+ *
+ * @param op Request type
+ * @param table Table the request is about
+ * @param arg First argument
+ * @param arg2 Second argument
+ * @param data Request payload, or NULL
+ * @param length Bytes of request payload
+ * @param payload Set to the reply payload, valid until the next request
+ * @return Bytes of reply payload, or -1 if the server reported an error
+ */
+long serverCall(ServerOp op, int table, int arg, int arg2, const void *data, size_t length, char **payload);
+
+/**
+ * Send a transaction to the server and wait until it is committed
+ *
+ * @param data Log entries of the transaction
+ * @param length Bytes of log entries
+ * @return 1 if successful, 0 otherwise
+ */
+int serverCommit(const char *data, size_t length);
+
+#endif /* SERVER_H */
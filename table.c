@@ -0,0 +1,1420 @@
+/**
+ * Hotel Management System
+ * table.c - In-memory record table implementation
+ *
+ * This file implements the process-wide table cache. Each data file
+ * is mapped privately into a contiguous array (read into the heap on
+ * Windows) and lookups and scans run against that array. Address space
+ * is reserved past the end of the file so appends extend the array in
+ * place, in chunks, and only move it when the reservation runs out.
+ * Every mutation is appended to the write-ahead log; the changed slot
+ * range is written back to the data file in place at the next
+ * checkpoint.
+ *
+ * Every data file starts with a header (see datafile.h). The records
+ * follow it, and the file is mapped from its start so the mapping
+ * stays page-aligned. The header's record count and next id only ever
+ * grow outside a rewrite, so it is rewritten only when one of them
+ * does: a terminal merely changing records never touches it, and
+ * appends and id allocations hold the table's append lock.
+ *
+ * The slots of deleted records are kept on a free list, rebuilt along
+ * with the indexes and extended as records are deleted. Entries are
+ * checked when they are taken, so a slot reused or read again since it
+ * was listed is simply skipped. A reused slot keeps its place in the
+ * file but takes a new id, so the primary index entry is moved.
+ *
+ * Another terminal's changes are picked up by mapping the data file
+ * again over the cached records, or by reading single records into
+ * place, which also replaces any private copies of changed pages.
+ *
+ * In a server the slot of every change is kept in a ring per table,
+ * indexed by the table's version. A client fills its arrays from the
+ * server's replies instead of the data files.
+ *
+ * Secondary indexes chain the slots that share a foreign key through a
+ * per-slot next array; a hash table maps each key to the head and tail
+ * of its chain, so appends extend the chain in slot order in O(1).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "table.h"
+#include "datafile.h"
+#include "migrate.h"
+#include "wal.h"
+#include "lock.h"
+#include "server.h"
+#include "auth.h"
+#include "room.h"
+#include "guest.h"
+#include "reservation.h"
+#include "billing.h"
+#include "audit.h"
+#include "textheap.h"
+
+#define TABLE_INITIAL_CAPACITY 64
+#define TABLE_MAP_RESERVE (64 * 1024 * 1024)  /* Initial address space per table */
+#define TABLE_MAP_CHUNK (64 * 1024)           /* Growth step of the usable part */
+#define INDEX_EMPTY -1
+
+static Table tables[TABLE_COUNT] = {
+    [TABLE_ROOMS]         = { ROOMS_FILE,         sizeof(Room),        offsetof(Room, isActive) },
+    [TABLE_GUESTS]        = { GUESTS_FILE,        sizeof(Guest),       offsetof(Guest, isActive) },
+    [TABLE_RESERVATIONS]  = { RESERVATIONS_FILE,  sizeof(Reservation), offsetof(Reservation, isActive) },
+    [TABLE_INVOICES]      = { INVOICES_FILE,      sizeof(Invoice),     offsetof(Invoice, isActive) },
+    [TABLE_BILLING_ITEMS] = { BILLING_ITEMS_FILE, sizeof(BillingItem), offsetof(BillingItem, isActive) },
+    [TABLE_PAYMENTS]      = { PAYMENTS_FILE,      sizeof(Payment),     offsetof(Payment, isActive) },
+    /* A deactivated user can be reactivated; only deletion clears the role */
+    [TABLE_USERS]         = { USERS_FILE,         sizeof(User),        offsetof(User, role) },
+    [TABLE_AUDITS]        = { AUDITS_FILE,        sizeof(AuditRun),    offsetof(AuditRun, isActive) },
+    [TABLE_TEXTS]         = { TEXTS_FILE,         sizeof(TextBlock),   offsetof(TextBlock, isActive) }
+};
+
+/* Hash bucket of a secondary index: one chain of slots per key */
+typedef struct {
+    int key;
+    int head;               /* First slot with this key, or INDEX_EMPTY */
+    int tail;               /* Last slot with this key */
+} IndexBucket;
+
+/* Secondary index structure */
+typedef struct {
+    TableId table;          /* Table whose records are indexed */
+    size_t keyOffset;       /* Offset of the int key in the record */
+    IndexBucket *buckets;   /* Open-addressing hash from key to chain */
+    int bucketCapacity;     /* Number of buckets (power of two) */
+    int *next;              /* Next slot with the same key, per slot */
+    int *keys;              /* Key each slot was indexed under */
+    int slotCapacity;       /* Number of allocated next/keys entries */
+} SecondaryIndex;
+
+static SecondaryIndex indexes[INDEX_COUNT] = {
+    [INDEX_RESERVATION_GUEST]   = { TABLE_RESERVATIONS,  offsetof(Reservation, guestId) },
+    [INDEX_INVOICE_RESERVATION] = { TABLE_INVOICES,      offsetof(Invoice, reservationId) },
+    [INDEX_ITEM_INVOICE]        = { TABLE_BILLING_ITEMS, offsetof(BillingItem, invoiceId) },
+    [INDEX_PAYMENT_INVOICE]     = { TABLE_PAYMENTS,      offsetof(Payment, invoiceId) }
+};
+
+/* Get the offset of a slot's record in the data file */
+static long slotOffset(Table *table, int slot) {
+    return (long)sizeof(DataHeader) + (long)slot * (long)table->recordSize;
+}
+
+/* Read the header of a table's data file; 0 if it has none yet or it is damaged */
+static int readFileHeader(Table *table, DataHeader *header) {
+    FILE *fp = fopen(table->path, "rb");
+    int ok;
+
+    if (fp == NULL) {
+        return 0;
+    }
+    ok = readDataHeader(fp, header);
+    fclose(fp);
+    return ok;
+}
+
+/* Get the number of records in a table's data file */
+static int fileRecordCount(Table *table) {
+    DataHeader header;
+    return readFileHeader(table, &header) ? header.count : 0;
+}
+
+/* Get the next id recorded in a table's data file, or 0 if there is none */
+static int fileNextId(Table *table) {
+    DataHeader header;
+    return readFileHeader(table, &header) ? header.nextId : 0;
+}
+
+/* Get the id of the record in a slot (every record starts with its id) */
+static int recordId(Table *table, int slot) {
+    return *(int *)tableRecord(table, slot);
+}
+
+/* Check whether the record in a slot is active */
+static int recordIsActive(Table *table, int slot) {
+    return *(int *)((char *)tableRecord(table, slot) + table->activeOffset);
+}
+
+/* Hash a record id to an index bucket */
+static unsigned int hashId(Table *table, int id) {
+    unsigned int h = (unsigned int)id * 2654435761u;
+    h ^= h >> 16;
+    return h & (unsigned int)(table->indexCapacity - 1);
+}
+
+/* Add a slot to the primary index */
+static void indexInsert(Table *table, int slot) {
+    int id = recordId(table, slot);
+    unsigned int mask = (unsigned int)(table->indexCapacity - 1);
+    unsigned int pos = hashId(table, id);
+
+    while (table->index[pos] != INDEX_EMPTY) {
+        int other = table->index[pos];
+        if (recordId(table, other) == id) {
+            /* Id reused (e.g. a deleted room re-added): keep the active record */
+            if (recordIsActive(table, slot) || !recordIsActive(table, other)) {
+                table->index[pos] = slot;
+            }
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+    table->index[pos] = slot;
+}
+
+/* Remove a slot from the primary index, where it was filed under an id */
+static void indexRemove(Table *table, int slot, int id) {
+    unsigned int mask = (unsigned int)(table->indexCapacity - 1);
+    unsigned int pos = hashId(table, id);
+    unsigned int next;
+
+    while (table->index[pos] != slot) {
+        if (table->index[pos] == INDEX_EMPTY) {
+            return; /* Not indexed: another record has the same id */
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    /* Move later entries of the probe run back into the gap if their
+       home bucket does not lie between the gap and where they are */
+    for (next = (pos + 1) & mask; table->index[next] != INDEX_EMPTY; next = (next + 1) & mask) {
+        unsigned int home = hashId(table, recordId(table, table->index[next]));
+        if (((next - home) & mask) >= ((next - pos) & mask)) {
+            table->index[pos] = table->index[next];
+            pos = next;
+        }
+    }
+    table->index[pos] = INDEX_EMPTY;
+}
+
+/* Re-file a slot in the primary index if the record in it has a new id */
+static void reindexSlot(Table *table, int slot, int oldId) {
+    if (recordId(table, slot) != oldId && table->indexCapacity > 0) {
+        indexRemove(table, slot, oldId);
+        indexInsert(table, slot);
+    }
+}
+
+/* Rebuild the primary index, sized for at least the given number of records */
+static int rebuildIndex(Table *table, int records) {
+    int newCapacity = 64;
+    int *newIndex;
+
+    /* Keep the load factor at or below one half */
+    while (newCapacity < records * 2) {
+        newCapacity *= 2;
+    }
+
+    newIndex = malloc((size_t)newCapacity * sizeof(int));
+    if (newIndex == NULL) {
+        printf("\nError: Out of memory while indexing %s\n", table->path);
+        return 0;
+    }
+
+    free(table->index);
+    table->index = newIndex;
+    table->indexCapacity = newCapacity;
+    for (int i = 0; i < newCapacity; i++) {
+        table->index[i] = INDEX_EMPTY;
+    }
+
+    for (int slot = 0; slot < table->count; slot++) {
+        indexInsert(table, slot);
+    }
+    return 1;
+}
+
+/* Get the key of the record in a slot for a secondary index */
+static int secondaryKey(SecondaryIndex *index, int slot) {
+    Table *table = &tables[index->table];
+    return *(int *)((char *)tableRecord(table, slot) + index->keyOffset);
+}
+
+/* Find the bucket holding a key, or the empty bucket where it belongs */
+static IndexBucket *findBucket(SecondaryIndex *index, int key) {
+    unsigned int mask = (unsigned int)(index->bucketCapacity - 1);
+    unsigned int pos = (unsigned int)key * 2654435761u;
+
+    pos = (pos ^ (pos >> 16)) & mask;
+    while (index->buckets[pos].head != INDEX_EMPTY && index->buckets[pos].key != key) {
+        pos = (pos + 1) & mask;
+    }
+    return &index->buckets[pos];
+}
+
+/* Add a slot to the end of its key's chain in a secondary index */
+static int secondaryInsert(SecondaryIndex *index, int slot) {
+    int key = secondaryKey(index, slot);
+    IndexBucket *bucket;
+
+    if (slot >= index->slotCapacity) {
+        int newCapacity = index->slotCapacity > 0 ? index->slotCapacity : TABLE_INITIAL_CAPACITY;
+        int *newNext, *newKeys;
+
+        while (newCapacity <= slot) {
+            newCapacity *= 2;
+        }
+        newNext = realloc(index->next, (size_t)newCapacity * sizeof(int));
+        if (newNext != NULL) {
+            index->next = newNext;
+        }
+        newKeys = realloc(index->keys, (size_t)newCapacity * sizeof(int));
+        if (newKeys != NULL) {
+            index->keys = newKeys;
+        }
+        if (newNext == NULL || newKeys == NULL) {
+            printf("\nError: Out of memory while indexing %s\n", tables[index->table].path);
+            return 0;
+        }
+        index->slotCapacity = newCapacity;
+    }
+
+    index->next[slot] = INDEX_EMPTY;
+    index->keys[slot] = key;
+
+    bucket = findBucket(index, key);
+    if (bucket->head == INDEX_EMPTY) {
+        bucket->key = key;
+        bucket->head = slot;
+    } else {
+        index->next[bucket->tail] = slot;
+    }
+    bucket->tail = slot;
+    return 1;
+}
+
+/* Rebuild a secondary index from every record of its table */
+static int rebuildSecondary(SecondaryIndex *index) {
+    Table *table = &tables[index->table];
+    int newCapacity = 64;
+    IndexBucket *newBuckets;
+
+    /* A table never has more distinct keys than records */
+    while (newCapacity < table->count * 2) {
+        newCapacity *= 2;
+    }
+
+    newBuckets = malloc((size_t)newCapacity * sizeof(IndexBucket));
+    if (newBuckets == NULL) {
+        printf("\nError: Out of memory while indexing %s\n", table->path);
+        return 0;
+    }
+
+    free(index->buckets);
+    index->buckets = newBuckets;
+    index->bucketCapacity = newCapacity;
+    for (int i = 0; i < newCapacity; i++) {
+        index->buckets[i].head = INDEX_EMPTY;
+    }
+
+    for (int slot = 0; slot < table->count; slot++) {
+        if (!secondaryInsert(index, slot)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Rebuild every secondary index defined on a table */
+static int rebuildSecondaryIndexes(Table *table) {
+    int ok = 1;
+
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        if (&tables[indexes[i].table] == table && !rebuildSecondary(&indexes[i])) {
+            ok = 0;
+        }
+    }
+    return ok;
+}
+
+/* Add a slot to the free list */
+static void pushFreeSlot(Table *table, int slot) {
+    if (table->freeCount == table->freeCapacity) {
+        int newCapacity = table->freeCapacity > 0 ? table->freeCapacity * 2 : TABLE_INITIAL_CAPACITY;
+        int *newSlots = realloc(table->freeSlots, (size_t)newCapacity * sizeof(int));
+        if (newSlots == NULL) {
+            return; /* The slot waits for the next rebuild or a compaction */
+        }
+        table->freeSlots = newSlots;
+        table->freeCapacity = newCapacity;
+    }
+    table->freeSlots[table->freeCount++] = slot;
+}
+
+/* Rebuild the free list from the deleted records, lowest slot to be reused first */
+static void rebuildFreeList(Table *table) {
+    table->freeCount = 0;
+    for (int slot = table->count - 1; slot >= 0; slot--) {
+        if (!recordIsActive(table, slot)) {
+            pushFreeSlot(table, slot);
+        }
+    }
+}
+
+/* Rebuild the primary and secondary indexes and the free list of a table */
+static int reindexTable(Table *table) {
+    rebuildFreeList(table);
+    return rebuildIndex(table, table->count) && rebuildSecondaryIndexes(table);
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+/* Make sure a table has room for at least the given number of records */
+static int ensureCapacity(Table *table, int needed) {
+    int newCapacity;
+    char *newRecords;
+
+    if (needed <= table->capacity) {
+        return 1;
+    }
+
+    newCapacity = table->capacity > 0 ? table->capacity : TABLE_INITIAL_CAPACITY;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
+
+    newRecords = realloc(table->records, (size_t)newCapacity * table->recordSize);
+    if (newRecords == NULL) {
+        printf("\nError: Out of memory while loading %s\n", table->path);
+        return 0;
+    }
+
+    table->records = newRecords;
+    table->capacity = newCapacity;
+    return 1;
+}
+
+/* Release a table's record array */
+static void releaseRecords(Table *table) {
+    free(table->records);
+    table->records = NULL;
+    table->capacity = 0;
+}
+#else
+/* Round a size up to a multiple of unit */
+static size_t roundUp(size_t size, size_t unit) {
+    return (size + unit - 1) / unit * unit;
+}
+
+/* Get the start of a table's mapping, where the file header is mapped */
+static char *mapBase(Table *table) {
+    return table->records - sizeof(DataHeader);
+}
+
+/* Set the usable part of the mapping and the record capacity it gives */
+static void setCommitted(Table *table, size_t committed) {
+    table->mapCommitted = committed;
+    table->capacity = committed > sizeof(DataHeader)
+                          ? (int)((committed - sizeof(DataHeader)) / table->recordSize) : 0;
+}
+
+/* Reserve address space for a table and map its whole data file privately at the start */
+static int mapRecords(Table *table, size_t fileSize, size_t minBytes) {
+    size_t reserve = TABLE_MAP_RESERVE;
+    char *base;
+
+    minBytes += sizeof(DataHeader);
+    while (reserve < minBytes * 2) {
+        reserve *= 2;
+    }
+
+    base = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        printf("\nError: Could not reserve memory for %s\n", table->path);
+        return 0;
+    }
+
+    /* Changes stay private to the process until a checkpoint writes them */
+    if (fileSize > 0) {
+        int fd = open(table->path, O_RDONLY);
+        if (fd < 0 || mmap(base, fileSize, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            printf("\nError: Could not map %s\n", table->path);
+            if (fd >= 0) close(fd);
+            munmap(base, reserve);
+            return 0;
+        }
+        close(fd);
+    }
+
+    table->records = base + sizeof(DataHeader);
+    table->mapSize = reserve;
+    setCommitted(table, roundUp(fileSize, (size_t)sysconf(_SC_PAGESIZE)));
+    return 1;
+}
+
+/* Make the reserved address space usable for at least the given bytes of records */
+static int commitRecords(Table *table, size_t bytes) {
+    size_t committed = roundUp(sizeof(DataHeader) + bytes, TABLE_MAP_CHUNK);
+
+    if (committed > table->mapSize) {
+        committed = table->mapSize;
+    }
+    if (committed > table->mapCommitted) {
+        if (mprotect(mapBase(table) + table->mapCommitted, committed - table->mapCommitted,
+                     PROT_READ | PROT_WRITE) != 0) {
+            printf("\nError: Out of memory while loading %s\n", table->path);
+            return 0;
+        }
+        setCommitted(table, committed);
+    }
+    return 1;
+}
+
+/* Make sure a table has room for at least the given number of records */
+static int ensureCapacity(Table *table, int needed) {
+    size_t bytes = (size_t)needed * table->recordSize;
+
+    if (needed <= table->capacity) {
+        return 1;
+    }
+
+    if (table->mapSize == 0) {
+        if (!mapRecords(table, 0, bytes)) {
+            return 0;
+        }
+    } else if (sizeof(DataHeader) + bytes > table->mapSize) {
+        /* Reservation exhausted: move the records to a larger one */
+        char *oldRecords = table->records;
+        size_t oldSize = table->mapSize;
+        size_t used = (size_t)table->count * table->recordSize;
+
+        if (!mapRecords(table, 0, bytes) || !commitRecords(table, used)) {
+            table->records = oldRecords;
+            table->mapSize = oldSize;
+            return 0;
+        }
+        memcpy(table->records, oldRecords, used);
+        munmap(oldRecords - sizeof(DataHeader), oldSize);
+    }
+    return commitRecords(table, bytes);
+}
+
+/* Release a table's record mapping */
+static void releaseRecords(Table *table) {
+    if (table->mapSize > 0) {
+        munmap(mapBase(table), table->mapSize);
+    }
+    table->records = NULL;
+    table->mapSize = 0;
+    table->mapCommitted = 0;
+    table->capacity = 0;
+}
+#endif
+
+/* Close the table's data file descriptor if it is open */
+static void closeTableFile(Table *table) {
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (table->fd >= 0) {
+        close(table->fd);
+    }
+#endif
+    table->fd = -1;
+}
+
+/* Write bytes at an offset in the data file */
+static int writeAt(Table *table, long offset, const void *data, size_t length) {
+    DataHeader header;
+#if defined(_WIN32) || defined(_WIN64)
+    FILE *fp = fopen(table->path, "r+b");
+    if (fp == NULL) {
+        fp = fopen(table->path, "w+b");
+    }
+    if (fp == NULL) {
+        printf("\nError: Could not open %s for writing.\n", table->path);
+        return 0;
+    }
+    /* A new file gets an empty header before its first records, so a
+       crash in between still leaves a file that loads */
+    initDataHeader(&header, table->recordSize, 0, table->nextId);
+    if (fseek(fp, 0, SEEK_END) != 0 ||
+        (ftell(fp) == 0 && offset > 0 &&
+         (fwrite(&header, sizeof(header), 1, fp) != 1 || fflush(fp) != 0 ||
+          _commit(_fileno(fp)) != 0)) ||
+        fseek(fp, offset, SEEK_SET) != 0 || fwrite(data, 1, length, fp) != length ||
+        fflush(fp) != 0) {
+        printf("\nError: Could not write to %s.\n", table->path);
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+#else
+    if (table->fd < 0) {
+        struct stat st;
+
+        table->fd = open(table->path, O_RDWR | O_CREAT, 0644);
+        if (table->fd < 0) {
+            printf("\nError: Could not open %s for writing.\n", table->path);
+            return 0;
+        }
+        /* The file may have just been created */
+        if (fstat(table->fd, &st) == 0) {
+            table->fileId = (unsigned long)st.st_ino;
+            /* A new file gets an empty header before its first records, so a
+               crash in between still leaves a file that loads */
+            initDataHeader(&header, table->recordSize, 0, table->nextId);
+            if (st.st_size == 0 && offset > 0 &&
+                (pwrite(table->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+                 fsync(table->fd) != 0)) {
+                printf("\nError: Could not write to %s.\n", table->path);
+                return 0;
+            }
+        }
+    }
+    if (pwrite(table->fd, data, length, (off_t)offset) != (ssize_t)length) {
+        printf("\nError: Could not write to %s.\n", table->path);
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+/* Sync what has been written to the data file */
+static int syncFile(Table *table) {
+#if defined(_WIN32) || defined(_WIN64)
+    FILE *fp = fopen(table->path, "r+b");
+    int ok = fp != NULL && _commit(_fileno(fp)) == 0;
+
+    if (fp != NULL) {
+        fclose(fp);
+    }
+#else
+    int ok = table->fd < 0 || fsync(table->fd) == 0;
+#endif
+    if (!ok) {
+        printf("\nError: Could not write to %s.\n", table->path);
+    }
+    return ok;
+}
+
+/* Raise the record count and next id in the data file's header to at least the given values */
+static int updateHeader(Table *table, int count, int nextId) {
+    DataHeader header;
+
+    if (serverConnected()) {
+        return 1; /* The server keeps the header as it applies our commits */
+    }
+    if (readFileHeader(table, &header)) {
+        if (header.count >= count && header.nextId >= nextId) {
+            return 1;
+        }
+        /* Keep what another terminal has added meanwhile */
+        if (header.count > count) count = header.count;
+        if (header.nextId > nextId) nextId = header.nextId;
+    }
+    initDataHeader(&header, table->recordSize, count, nextId);
+    return writeAt(table, 0, &header, sizeof(header));
+}
+
+/* Write a run of records at their fixed offset in the data file and sync it */
+static int writeRecordsAt(Table *table, int slot, int count) {
+    /* The header only counts records once they have been written */
+    return writeAt(table, slotOffset(table, slot), tableRecord(table, slot),
+                   (size_t)count * table->recordSize) &&
+           updateHeader(table, slot + count, table->nextId) &&
+           syncFile(table);
+}
+
+/* Read the record in a slot from the data file into the cache */
+static int readRecordAt(Table *table, int slot) {
+    FILE *fp = fopen(table->path, "rb");
+    int ok;
+
+    if (fp == NULL) {
+        printf("\nError: Could not open %s for reading.\n", table->path);
+        return 0;
+    }
+    ok = fseek(fp, slotOffset(table, slot), SEEK_SET) == 0 &&
+         fread(tableRecord(table, slot), table->recordSize, 1, fp) == 1;
+    fclose(fp);
+    if (!ok) {
+        printf("\nError: Could not read %s.\n", table->path);
+    }
+    return ok;
+}
+
+/* Add a newly stored slot to the table's primary and secondary indexes */
+static void indexAppended(Table *table, int slot) {
+    if (table->count * 2 > table->indexCapacity) {
+        rebuildIndex(table, table->count);
+    } else {
+        indexInsert(table, slot);
+    }
+
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        if (&tables[indexes[i].table] != table) {
+            continue;
+        }
+        if (table->count * 2 > indexes[i].bucketCapacity) {
+            rebuildSecondary(&indexes[i]);
+        } else {
+            secondaryInsert(&indexes[i], slot);
+        }
+    }
+}
+
+/* Re-chain a slot in every secondary index whose key it no longer matches */
+static void rechainChangedKeys(Table *table, int slot) {
+    /* Foreign keys rarely change; when one does, re-chain that index */
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        if (&tables[indexes[i].table] == table &&
+            indexes[i].keys[slot] != secondaryKey(&indexes[i], slot)) {
+            rebuildSecondary(&indexes[i]);
+        }
+    }
+}
+
+/* Extend the range of slots waiting to be written to the data file */
+static void markDirty(Table *table, int slot) {
+    if (table->dirtyFrom == table->dirtyTo) {
+        table->dirtyFrom = slot;
+        table->dirtyTo = slot + 1;
+    } else if (slot < table->dirtyFrom) {
+        table->dirtyFrom = slot;
+    } else if (slot >= table->dirtyTo) {
+        table->dirtyTo = slot + 1;
+    }
+}
+
+/* Number a change to a slot and remember the slot for clients (server) */
+static void noteChange(Table *table, int slot) {
+    if (table->changeLog != NULL) {
+        table->version++;
+        table->changeLog[table->version % TABLE_CHANGE_LOG] = slot;
+    }
+}
+
+/* Note that a table's slots may all have changed, so clients fetch it whole (server) */
+static void noteRewrite(Table *table) {
+    if (table->changeLog != NULL) {
+        table->resetVersion = ++table->version;
+    }
+}
+
+/* Check a table reply from the server and copy out its state (client) */
+static int readState(Table *table, long length, const char *payload, size_t entrySize,
+                     ServerTableState *state) {
+    if (length < (long)sizeof(*state)) {
+        return 0;
+    }
+    memcpy(state, payload, sizeof(*state));
+    if (state->records < 0 ||
+        (size_t)length < sizeof(*state) + (size_t)state->records * entrySize) {
+        printf("\nError: The server sent a truncated copy of %s.\n", table->path);
+        return 0;
+    }
+    return 1;
+}
+
+/* Replace a table's records with the server's copy (client) */
+static int fetchTable(Table *table) {
+    ServerTableState state;
+    char *payload;
+    long length = serverCall(SERVER_OP_SNAPSHOT, (int)(table - tables), 0, 0, NULL, 0, &payload);
+
+    if (!readState(table, length, payload, table->recordSize, &state) ||
+        !ensureCapacity(table, state.records)) {
+        return 0;
+    }
+    if (state.records > 0) {
+        memcpy(table->records, payload + sizeof(state), (size_t)state.records * table->recordSize);
+    }
+    table->count = state.records;
+    table->nextId = state.nextId;
+    table->version = state.version;
+    return reindexTable(table);
+}
+
+/* Store records the server sent as slot and record pairs (client) */
+static int applyFetched(Table *table, const ServerTableState *state, const char *data) {
+    size_t entrySize = sizeof(int) + table->recordSize;
+
+    for (int i = 0; i < state->records; i++) {
+        const char *entry = data + (size_t)i * entrySize;
+        int slot;
+
+        memcpy(&slot, entry, sizeof(slot));
+        if (slot >= 0 && slot < table->count) {
+            int oldId = recordId(table, slot);
+
+            memcpy(tableRecord(table, slot), entry + sizeof(slot), table->recordSize);
+            reindexSlot(table, slot, oldId);
+            rechainChangedKeys(table, slot);
+        } else if (slot == table->count && ensureCapacity(table, slot + 1)) {
+            /* Appended slots arrive in order */
+            memcpy(tableRecord(table, slot), entry + sizeof(slot), table->recordSize);
+            table->count++;
+            indexAppended(table, slot);
+        } else {
+            return 0;
+        }
+    }
+    if (state->nextId > table->nextId) {
+        table->nextId = state->nextId;
+    }
+    return 1;
+}
+
+/* Bring a table up to date with the server's copy (client) */
+static int fetchChanges(Table *table) {
+    TableId id = (TableId)(table - tables);
+    ServerTableState state;
+    char *payload;
+    long length = serverCall(SERVER_OP_CHANGES, (int)id, table->version, 0, NULL, 0, &payload);
+
+    if (!readState(table, length, payload, sizeof(int) + table->recordSize, &state)) {
+        return 0;
+    }
+    if (state.reset || !applyFetched(table, &state, payload + sizeof(state))) {
+        return loadTable(id);
+    }
+    table->version = state.version;
+    return 1;
+}
+
+/* Check the header of a data file against the table; the number of records, or -1 */
+static int checkHeader(Table *table, FILE *fp, long fileSize) {
+    DataHeader header;
+    long stored;
+
+    if (!readDataHeader(fp, &header)) {
+        printf("\nError: %s has no valid data file header.\n", table->path);
+        return -1;
+    }
+    if (header.schemaVersion != CURRENT_FORMAT_VERSION) {
+        printf("\nError: %s is in format %d, but this program reads format %d.\n",
+               table->path, header.schemaVersion, CURRENT_FORMAT_VERSION);
+        return -1;
+    }
+    if (header.recordSize != (int)table->recordSize || header.count < 0) {
+        printf("\nError: %s holds %d-byte records, but this program expects %d-byte records.\n",
+               table->path, header.recordSize, (int)table->recordSize);
+        return -1;
+    }
+
+    /* Records counted before an interrupted write reached the file are replayed from the log */
+    stored = (fileSize - (long)sizeof(header)) / (long)table->recordSize;
+    if (header.nextId > table->nextId) {
+        table->nextId = header.nextId;
+    }
+    return header.count < stored ? header.count : (int)stored;
+}
+
+/* Load a table from its data file */
+int loadTable(TableId id) {
+    Table *table = &tables[id];
+    FILE *fp;
+    long fileSize;
+    int count = 0;
+
+    if (table->loaded) {
+        closeTableFile(table);
+        releaseRecords(table);
+    }
+    table->fd = -1;
+    table->count = 0;
+    table->dirtyFrom = table->dirtyTo = 0;
+    table->fileId = 0;
+    table->loaded = 1;
+    noteTableLoaded(id);
+    noteRewrite(table);
+    if (serverConnected()) {
+        return fetchTable(table);
+    }
+    table->nextId = 1;
+
+    fp = fopen(table->path, "rb");
+    if (fp == NULL) {
+        /* No file yet, so the table is empty */
+        return reindexTable(table);
+    }
+
+    fseek(fp, 0, SEEK_END);
+    fileSize = ftell(fp);
+
+    /* A file just created is empty; it gets its header when a record is added */
+    if (fileSize > 0 && (count = checkHeader(table, fp, fileSize)) < 0) {
+        fclose(fp);
+        return 0;
+    }
+#if defined(_WIN32) || defined(_WIN64)
+    if (!ensureCapacity(table, count)) {
+        fclose(fp);
+        return 0;
+    }
+
+    fseek(fp, (long)sizeof(DataHeader), SEEK_SET);
+    table->count = (int)fread(table->records, table->recordSize, (size_t)count, fp);
+    fclose(fp);
+#else
+    fclose(fp);
+    {
+        struct stat st;
+        if (stat(table->path, &st) == 0) {
+            table->fileId = (unsigned long)st.st_ino;
+        }
+    }
+
+    /* Records are read through the mapping; pages load on first access */
+    if (!mapRecords(table, (size_t)fileSize, (size_t)fileSize)) {
+        return 0;
+    }
+    table->count = count;
+#endif
+
+    /* Never hand out an id already present in the file */
+    for (int slot = 0; slot < table->count; slot++) {
+        if (recordId(table, slot) >= table->nextId) {
+            table->nextId = recordId(table, slot) + 1;
+        }
+    }
+    return reindexTable(table);
+}
+
+/* Get a table, loading it on first use */
+Table *getTable(TableId id) {
+    if (!tables[id].loaded) {
+        loadTable(id);
+    }
+    return &tables[id];
+}
+
+/* Get a pointer to the record in a slot */
+void *tableRecord(Table *table, int slot) {
+    return table->records + (size_t)slot * table->recordSize;
+}
+
+/* Find the slot of a record by id using the primary hash index */
+int tableLookup(Table *table, int id) {
+    unsigned int mask;
+    unsigned int pos;
+
+    if (table->indexCapacity == 0) {
+        return -1;
+    }
+
+    mask = (unsigned int)(table->indexCapacity - 1);
+    pos = hashId(table, id);
+    while (table->index[pos] != INDEX_EMPTY) {
+        if (recordId(table, table->index[pos]) == id) {
+            return table->index[pos];
+        }
+        pos = (pos + 1) & mask;
+    }
+    return -1;
+}
+
+/* Get the id the next record appended to a table should use */
+int tableNextId(Table *table) {
+    return table->nextId;
+}
+
+/* Write the record in a slot back to its place in the data file */
+int tableWriteRecord(Table *table, int slot) {
+    rechainChangedKeys(table, slot);
+
+    if (!walLogRecord((TableId)(table - tables), slot, tableRecord(table, slot), table->recordSize)) {
+        return 0;
+    }
+    markDirty(table, slot);
+    noteChange(table, slot);
+    if (!recordIsActive(table, slot)) {
+        pushFreeSlot(table, slot);
+    }
+    return 1;
+}
+
+/* Store a new record in the slot of a deleted record, or append it */
+int tableInsert(Table *table, const void *record) {
+    TableId id = (TableId)(table - tables);
+
+    while (table->freeCount > 0) {
+        int slot = table->freeSlots[--table->freeCount];
+        int deadId;
+
+        if (slot >= table->count || recordIsActive(table, slot)) {
+            continue; /* Reused since it was listed */
+        }
+        deadId = recordId(table, slot);
+        if (tableLookup(table, deadId) != slot) {
+            continue; /* Its id belongs to another record, so it cannot be locked; left for compaction */
+        }
+        if (!lockRecord(id, deadId)) {
+            return -1;
+        }
+        if (tableLookup(table, deadId) != slot || recordIsActive(table, slot)) {
+            continue; /* Another terminal reused it */
+        }
+
+        if (!walLogRecord(id, slot, record, table->recordSize)) {
+            return -1;
+        }
+        memcpy(tableRecord(table, slot), record, table->recordSize);
+        reindexSlot(table, slot, deadId);
+        rechainChangedKeys(table, slot);
+        markDirty(table, slot);
+        noteChange(table, slot);
+
+        if (recordId(table, slot) >= table->nextId) {
+            table->nextId = recordId(table, slot) + 1;
+            updateHeader(table, 0, table->nextId);
+        }
+        return slot;
+    }
+    return tableAppend(table, record);
+}
+
+/* Append a record to a table and its data file */
+int tableAppend(Table *table, const void *record) {
+    int slot;
+
+    if (!ensureCapacity(table, table->count + 1)) {
+        return -1;
+    }
+
+    slot = table->count;
+    memcpy(tableRecord(table, slot), record, table->recordSize);
+    if (!walLogRecord((TableId)(table - tables), slot, record, table->recordSize)) {
+        return -1;
+    }
+    table->count++;
+    markDirty(table, slot);
+    noteChange(table, slot);
+
+    if (recordId(table, slot) >= table->nextId) {
+        table->nextId = recordId(table, slot) + 1;
+        updateHeader(table, 0, table->nextId);
+    }
+
+    indexAppended(table, slot);
+    return slot;
+}
+
+/* Put a slot back to its committed contents */
+int tableRevert(Table *table, int slot, const void *record) {
+    int oldId;
+
+    if (slot < 0 || slot >= table->count) {
+        return 1;
+    }
+    if (record == NULL && serverConnected()) {
+        return tableRefreshRecord(table, slot);
+    }
+    oldId = recordId(table, slot);
+    if (record != NULL) {
+        memcpy(tableRecord(table, slot), record, table->recordSize);
+    } else if (!readRecordAt(table, slot)) {
+        return 0;
+    }
+    reindexSlot(table, slot, oldId);
+    rechainChangedKeys(table, slot);
+    noteChange(table, slot);
+    if (!recordIsActive(table, slot)) {
+        pushFreeSlot(table, slot);
+    }
+    return 1;
+}
+
+/* Drop the records from a slot on, appended by an abandoned transaction */
+int tableTruncate(Table *table, int count) {
+    if (count < 0 || count >= table->count) {
+        return 1;
+    }
+    table->count = count;
+    /* The dropped slots must not be written out at the next checkpoint */
+    if (table->dirtyTo > count) {
+        table->dirtyTo = count;
+        if (table->dirtyFrom >= table->dirtyTo) {
+            table->dirtyFrom = table->dirtyTo = 0;
+        }
+    }
+    noteRewrite(table);
+    return reindexTable(table);
+}
+
+/* Write the cached contents of a table back to its data file */
+int tableSave(Table *table) {
+    char tempPath[256];
+    DataHeader header;
+    int nextId = fileNextId(table);
+    FILE *fp;
+
+    sprintf(tempPath, "%s.tmp", table->path);
+    initDataHeader(&header, table->recordSize, table->count,
+                   nextId > table->nextId ? nextId : table->nextId);
+
+    fp = fopen(tempPath, "wb");
+    if (fp == NULL) {
+        printf("\nError: Could not create temporary file.\n");
+        return 0;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        (table->count > 0 &&
+         fwrite(table->records, table->recordSize, (size_t)table->count, fp) != (size_t)table->count) ||
+        fflush(fp) != 0) {
+        printf("\nError: Could not write %s.\n", tempPath);
+        fclose(fp);
+        remove(tempPath);
+        return 0;
+    }
+#if defined(_WIN32) || defined(_WIN64)
+    _commit(_fileno(fp));
+#else
+    fsync(fileno(fp));
+#endif
+    fclose(fp);
+
+    /* The open descriptor refers to the file being replaced */
+    closeTableFile(table);
+
+    /* Replace original file with temp file; rename replaces it atomically
+       except on Windows, where the target has to be removed first */
+#if defined(_WIN32) || defined(_WIN64)
+    remove(table->path);
+#endif
+    if (rename(tempPath, table->path) != 0) {
+        printf("\nError: Could not replace %s.\n", table->path);
+        return 0;
+    }
+#if !defined(_WIN32) && !defined(_WIN64)
+    {
+        struct stat st;
+        if (stat(table->path, &st) == 0) {
+            table->fileId = (unsigned long)st.st_ino;
+        }
+    }
+#endif
+    table->dirtyFrom = table->dirtyTo = 0;
+    noteTableWritten((TableId)(table - tables), 1);
+    return 1;
+}
+
+/* Drop a table's deleted records and rewrite the data file */
+int tableCompact(Table *table) {
+    int kept = 0;
+    int dropped;
+
+    if (serverConnected()) {
+        /* The server rewrites the file; its copy replaces ours */
+        char *payload;
+        TableId id = (TableId)(table - tables);
+        long length = serverCall(SERVER_OP_COMPACT, (int)id, 0, 0, NULL, 0, &payload);
+
+        if (length < (long)sizeof(int)) {
+            return -1;
+        }
+        /* Reloading reuses the reply buffer */
+        memcpy(&dropped, payload, sizeof(int));
+        return loadTable(id) ? dropped : -1;
+    }
+
+    /* Compaction rewrites the file, so pending log entries must reach it first */
+    if (!walCheckpoint()) {
+        return -1;
+    }
+
+    for (int slot = 0; slot < table->count; slot++) {
+        if (recordIsActive(table, slot)) {
+            if (kept < slot) {
+                memcpy(tableRecord(table, kept), tableRecord(table, slot), table->recordSize);
+            }
+            kept++;
+        }
+    }
+    dropped = table->count - kept;
+    if (dropped == 0) {
+        return 0;
+    }
+    table->count = kept;
+    noteRewrite(table);
+
+    /* The remaining records have moved */
+    if (!reindexTable(table) || !tableSave(table)) {
+        return -1;
+    }
+    return dropped;
+}
+
+/* Write the slots changed since the last flush to the data file */
+int tableFlush(Table *table) {
+    if (table->dirtyFrom == table->dirtyTo) {
+        return 1;
+    }
+    if (!writeRecordsAt(table, table->dirtyFrom, table->dirtyTo - table->dirtyFrom)) {
+        return 0;
+    }
+    table->dirtyFrom = table->dirtyTo = 0;
+    noteTableWritten((TableId)(table - tables), 1);
+    return 1;
+}
+
+/* Flush every loaded table */
+int tableFlushAll(void) {
+    int ok = 1;
+
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        if (tables[i].loaded && !tableFlush(&tables[i])) {
+            ok = 0;
+        }
+    }
+    return ok;
+}
+
+/* Re-read a table after another terminal has written its data file */
+int tableRefresh(Table *table) {
+#if defined(_WIN32) || defined(_WIN64)
+    return loadTable((TableId)(table - tables));
+#else
+    struct stat st;
+    size_t used;
+    int fd, count, nextId, oldCount = table->count;
+    long stored;
+
+    if (!table->loaded) {
+        return 1;
+    }
+    if (serverConnected()) {
+        return fetchChanges(table);
+    }
+    if (stat(table->path, &st) != 0) {
+        return table->count == 0 ? 1 : loadTable((TableId)(table - tables));
+    }
+
+    /* The header gives the count; a record it counts that is not in the file yet is read next time */
+    count = fileRecordCount(table);
+    stored = ((long)st.st_size - (long)sizeof(DataHeader)) / (long)table->recordSize;
+    if (count > stored) {
+        count = stored > 0 ? (int)stored : 0;
+    }
+    used = sizeof(DataHeader) + (size_t)count * table->recordSize;
+
+    /* A rewritten file is a new inode whose records may have moved */
+    if ((unsigned long)st.st_ino != table->fileId || count < table->count ||
+        (table->mapSize > 0 && used > table->mapSize)) {
+        return loadTable((TableId)(table - tables));
+    }
+    if (count == 0 || !ensureCapacity(table, count)) {
+        return count == 0;
+    }
+
+    /* Mapping the file again drops private copies of pages changed elsewhere */
+    fd = open(table->path, O_RDONLY);
+    if (fd < 0 || mmap(mapBase(table), used, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        printf("\nError: Could not map %s\n", table->path);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    close(fd);
+
+    table->count = count;
+    for (int slot = oldCount; slot < count; slot++) {
+        if (recordId(table, slot) >= table->nextId) {
+            table->nextId = recordId(table, slot) + 1;
+        }
+    }
+    nextId = fileNextId(table);
+    if (nextId > table->nextId) {
+        table->nextId = nextId;
+    }
+    return reindexTable(table);
+#endif
+}
+
+/* Read records another terminal has put in reused slots, i.e. with ids from a given one on */
+static int readReusedSlots(Table *table, int firstNewId) {
+    FILE *fp;
+    char *record;
+
+    fp = fopen(table->path, "rb");
+    if (fp == NULL) {
+        printf("\nError: Could not open %s for reading.\n", table->path);
+        return 0;
+    }
+    record = malloc(table->recordSize);
+    if (record == NULL) {
+        fclose(fp);
+        return 0;
+    }
+
+    fseek(fp, (long)sizeof(DataHeader), SEEK_SET);
+    for (int slot = 0; slot < table->count && fread(record, table->recordSize, 1, fp) == 1; slot++) {
+        int id, oldId = recordId(table, slot);
+
+        memcpy(&id, record, sizeof(id));
+        if (id >= firstNewId && id != oldId) {
+            memcpy(tableRecord(table, slot), record, table->recordSize);
+            reindexSlot(table, slot, oldId);
+            rechainChangedKeys(table, slot);
+            if (id >= table->nextId) {
+                table->nextId = id + 1;
+            }
+        }
+    }
+    fclose(fp);
+    free(record);
+    return 1;
+}
+
+/* Read records appended by another terminal, and one changed record */
+int tableRefreshRecord(Table *table, int slot) {
+    int count;
+    int seenNextId = table->nextId;
+
+    if (serverConnected()) {
+        ServerTableState state;
+        char *payload;
+        long length = serverCall(SERVER_OP_RECORDS, (int)(table - tables), slot, table->count,
+                                 NULL, 0, &payload);
+
+        return readState(table, length, payload, sizeof(int) + table->recordSize, &state) &&
+               applyFetched(table, &state, payload + sizeof(state));
+    }
+
+    count = fileRecordCount(table);
+
+    while (table->count < count) {
+        int newSlot = table->count;
+
+        if (!ensureCapacity(table, newSlot + 1) || !readRecordAt(table, newSlot)) {
+            return 0;
+        }
+        table->count++;
+        if (recordId(table, newSlot) >= table->nextId) {
+            table->nextId = recordId(table, newSlot) + 1;
+        }
+        indexAppended(table, newSlot);
+    }
+
+    /* Ids allocated elsewhere but not appended went into reused slots */
+    if (fileNextId(table) > table->nextId && !readReusedSlots(table, seenNextId)) {
+        return 0;
+    }
+
+    if (slot >= 0 && slot < table->count) {
+        int oldId = recordId(table, slot);
+
+        if (!readRecordAt(table, slot)) {
+            return 0;
+        }
+        reindexSlot(table, slot, oldId);
+        rechainChangedKeys(table, slot);
+    }
+    return 1;
+}
+
+/* Write a record straight to its slot in the data file */
+int tableWriteLogged(Table *table, int slot, const void *record) {
+    int nextId;
+
+    if (slot < 0 || slot > fileRecordCount(table)) {
+        return 0;
+    }
+    memcpy(&nextId, record, sizeof(nextId));
+    nextId = nextId >= table->nextId ? nextId + 1 : table->nextId;
+    return writeAt(table, slotOffset(table, slot), record, table->recordSize) &&
+           updateHeader(table, slot + 1, nextId);
+}
+
+/* Sync a table's data file after tableWriteLogged */
+int tableSync(Table *table, int current) {
+    if (!syncFile(table)) {
+        return 0;
+    }
+    noteTableWritten((TableId)(table - tables), current);
+    return 1;
+}
+
+/* Store a record sent by a client in a slot and log it */
+int tableStore(Table *table, int slot, const void *record) {
+    int oldId;
+
+    if (slot == table->count) {
+        return tableAppend(table, record) >= 0;
+    }
+    if (slot < 0 || slot > table->count) {
+        return 0;
+    }
+    oldId = recordId(table, slot);
+    memcpy(tableRecord(table, slot), record, table->recordSize);
+
+    /* A client reusing a deleted record's slot gives it a new id */
+    reindexSlot(table, slot, oldId);
+    if (recordId(table, slot) >= table->nextId) {
+        table->nextId = recordId(table, slot) + 1;
+        updateHeader(table, 0, table->nextId);
+    }
+    return tableWriteRecord(table, slot);
+}
+
+/* Start numbering changes and remembering their slots */
+void tableTrackChanges(void) {
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        if (tables[i].changeLog == NULL) {
+            /* Without a ring every request for changes is answered with a reset */
+            tables[i].changeLog = calloc(TABLE_CHANGE_LOG, sizeof(int));
+            tables[i].resetVersion = tables[i].version;
+        }
+    }
+}
+
+/* Order slots for qsort */
+static int compareSlots(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* List the slots changed since a version of a table */
+int tableChangedSlots(Table *table, int since, int *slots) {
+    int count = 0, unique = 0;
+
+    if (table->changeLog == NULL || since < table->resetVersion || since > table->version ||
+        table->version - since > TABLE_CHANGE_LOG) {
+        return -1;
+    }
+    for (int v = since + 1; v <= table->version; v++) {
+        slots[count++] = table->changeLog[v % TABLE_CHANGE_LOG];
+    }
+
+    /* A slot changed several times is sent once */
+    qsort(slots, (size_t)count, sizeof(int), compareSlots);
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || slots[unique - 1] != slots[i]) {
+            slots[unique++] = slots[i];
+        }
+    }
+    return unique;
+}
+
+/* Forget the slots waiting to be written to every table's data file */
+void tableMarkAllClean(void) {
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        tables[i].dirtyFrom = tables[i].dirtyTo = 0;
+    }
+}
+
+/* Find the first record whose indexed key equals a value */
+int indexFirst(IndexId id, int key) {
+    SecondaryIndex *index = &indexes[id];
+
+    getTable(index->table);
+    if (index->bucketCapacity == 0) {
+        return -1;
+    }
+    return findBucket(index, key)->head;
+}
+
+/* Find the next record with the same indexed key as a slot */
+int indexNext(IndexId id, int slot) {
+    return indexes[id].next[slot];
+}
@@ -0,0 +1,342 @@
+/**
+ * Hotel Management System
+ * table.h - In-memory record table header
+ *
+ * This file contains declarations for the process-wide table cache.
+ * Each data file is mapped once into a contiguous record array, which
+ * TABLE_RECORDS exposes as a typed array; reads are served from memory.
+ *
+ * Mutations are made durable by the write-ahead log (see wal.h). The
+ * data file is brought up to date at checkpoints; records are
+ * fixed-size, so only the changed slot range is written, in place.
+ *
+ * Each data file starts with a header (see datafile.h) holding the
+ * number of records and the next id, so a table is sized without
+ * scanning its file and ids are not reused after records are removed.
+ * A file whose header does not match the table is refused.
+ *
+ * When several terminals share the data directory, tableRefresh and
+ * tableRefreshRecord bring the cache up to date with changes another
+ * terminal has written; lock.h decides when that is needed.
+ *
+ * A server (see server.h) numbers the changes made to each table and
+ * remembers the slots of the latest ones, so a client can catch up by
+ * fetching only those. In a client the tables are read from the server
+ * instead of the data files, and the same functions fetch from it.
+ *
+ * A record whose active flag is 0 has been deleted. tableInsert puts
+ * new records in the slots of deleted ones before growing the file,
+ * and tableCompact drops them from the file altogether.
+ *
+ * Every record type stored in a table begins with its int id, which
+ * is used as the key of the table's primary hash index. Secondary
+ * indexes map a foreign key field to the slots of the records that
+ * carry it, in slot order, and are kept up to date by every mutation.
+ */
+
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <stddef.h>
+
+/* Number of recent changes per table a server can list for its clients */
+#define TABLE_CHANGE_LOG 4096
+
+/* Tables managed by the cache */
+typedef enum {
+    TABLE_ROOMS,
+    TABLE_GUESTS,
+    TABLE_RESERVATIONS,
+    TABLE_INVOICES,
+    TABLE_BILLING_ITEMS,
+    TABLE_PAYMENTS,
+    TABLE_USERS,
+    TABLE_AUDITS,
+    TABLE_TEXTS,
+    TABLE_COUNT
+} TableId;
+
+/* Secondary indexes from a foreign key to the records that refer to it */
+typedef enum {
+    INDEX_RESERVATION_GUEST,    /* Reservation.guestId */
+    INDEX_INVOICE_RESERVATION,  /* Invoice.reservationId */
+    INDEX_ITEM_INVOICE,         /* BillingItem.invoiceId */
+    INDEX_PAYMENT_INVOICE,      /* Payment.invoiceId */
+    INDEX_COUNT
+} IndexId;
+
+/* Table structure */
+typedef struct {
+    const char *path;       /* Backing data file */
+    size_t recordSize;      /* Size of one record in bytes */
+    size_t activeOffset;    /* Offset of an int that is 0 once the record is deleted */
+    char *records;          /* Contiguous record array */
+    int count;              /* Number of records in the table */
+    int capacity;           /* Number of usable record slots */
+    size_t mapSize;         /* Bytes of address space reserved for the file header and records */
+    size_t mapCommitted;    /* Bytes of the reservation usable so far */
+    int loaded;             /* Whether the file has been read */
+    int *index;             /* Open-addressing hash index from id to slot */
+    int indexCapacity;      /* Number of index buckets (power of two) */
+    int fd;                 /* Open data file descriptor, or -1 */
+    int nextId;             /* Id for the next appended record */
+    int dirtyFrom;          /* First slot not yet written to the data file */
+    int dirtyTo;            /* End of the unwritten slot range (exclusive) */
+    unsigned long fileId;   /* Inode of the data file the records were read from */
+    int version;            /* Changes made on the server; a client's copy matches this */
+    int resetVersion;       /* Version before which changes cannot be listed (server) */
+    int *changeLog;         /* Slot of each of the last TABLE_CHANGE_LOG changes (server) */
+    int *freeSlots;         /* Slots of deleted records, the next to reuse last */
+    int freeCount;          /* Number of entries in freeSlots */
+    int freeCapacity;       /* Number of allocated freeSlots entries */
+} Table;
+
+/* View a table's records as an array of the given record type */
+#define TABLE_RECORDS(table, type) ((type *)(table)->records)
+
+/**
+ * Load a table from its data file, replacing any cached contents
+ *
+ * Fails if the file's header is damaged or describes another format
+ * version or record size.
+ *
+ * @param id Table to load
+ * @return 1 if successful, 0 otherwise
+ */
+int loadTable(TableId id);
+
+/**
+ * Get a table, loading it on first use
+ *
+ * @param id Table to get
+ * @return Pointer to the table
+ */
+Table *getTable(TableId id);
+
+/**
+ * Get a pointer to the record stored in a slot
+ *
+ * The pointer is only valid until the next append to the same table.
+ *
+ * @param table Table to read from
+ * @param slot Record slot (0 to count-1)
+ * @return Pointer to the record
+ */
+void *tableRecord(Table *table, int slot);
+
+/**
+ * Find the slot of a record by id using the primary hash index
+ *
+ * If an id has been reused, the active record is returned in
+ * preference to inactive ones. Callers must still check the record's
+ * active flag.
+ *
+ * @param table Table to search
+ * @param id Record id to look up
+ * @return Slot of the record, or -1 if no record has that id
+ */
+int tableLookup(Table *table, int id);
+
+/**
+ * Append a record to a table and log it
+ *
+ * @param table Table to append to
+ * @param record Record to append
+ * @return Slot of the new record, or -1 on failure
+ */
+int tableAppend(Table *table, const void *record);
+
+/**
+ * Store a new record in the slot of a deleted record, or append it
+ *
+ * Call with the table locked against appends. The deleted record's
+ * slot is locked for the rest of the transaction, which also re-reads
+ * it in case another terminal has reused it.
+ *
+ * @param table Table to insert into
+ * @param record Record to insert
+ * @return Slot of the new record, or -1 on failure
+ */
+int tableInsert(Table *table, const void *record);
+
+/**
+ * Get the id the next record appended to a table should use
+ *
+ * The sequence only advances when a record with that id is appended,
+ * so an abandoned insert does not consume an id.
+ *
+ * @param table Table to allocate from
+ * @return Next free record id
+ */
+int tableNextId(Table *table);
+
+/**
+ * Log the changed record in a slot
+ *
+ * Call this after changing a record obtained from tableRecord. The
+ * record reaches its place in the data file at the next checkpoint.
+ *
+ * @param table Table containing the record
+ * @param slot Slot of the changed record
+ * @return 1 if successful, 0 otherwise
+ */
+int tableWriteRecord(Table *table, int slot);
+
+/**
+ * Put a slot back to its committed contents (see walAbort)
+ *
+ * @param table Table containing the record
+ * @param slot Slot to restore; slots past the end are left alone
+ * @param record Contents to restore, or NULL to read them from the
+ *        data file (or the server, in a client)
+ * @return 1 if successful, 0 otherwise
+ */
+int tableRevert(Table *table, int slot, const void *record);
+
+/**
+ * Drop the records from a slot on, appended by an abandoned transaction
+ *
+ * @param table Table to shorten
+ * @param count Number of records to keep
+ * @return 1 if successful, 0 otherwise
+ */
+int tableTruncate(Table *table, int count);
+
+/**
+ * Write the cached contents of a table back to its data file
+ *
+ * @param table Table to save
+ * @return 1 if successful, 0 otherwise
+ */
+int tableSave(Table *table);
+
+/**
+ * Drop a table's deleted records and rewrite the data file
+ *
+ * The remaining records move down over the deleted ones, so previously
+ * obtained slots for this table are no longer valid. The log is
+ * checkpointed first, so this must not be called inside a transaction;
+ * lock the table with lockTable.
+ *
+ * @param table Table to compact
+ * @return Number of records dropped, or -1 on failure
+ */
+int tableCompact(Table *table);
+
+/**
+ * Write the slots changed since the last flush to the data file
+ *
+ * @param table Table to flush
+ * @return 1 if successful, 0 otherwise
+ */
+int tableFlush(Table *table);
+
+/**
+ * Flush every loaded table
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int tableFlushAll(void);
+
+/**
+ * Re-read a table after another terminal has written its data file
+ *
+ * Records appended since are added and changed records replace the
+ * cached ones. If the file has been rewritten the table is reloaded,
+ * so previously obtained slots are no longer valid. Changes not yet
+ * written to the data file are lost, so only call this outside a
+ * transaction that has changed the table.
+ *
+ * @param table Table to refresh
+ * @return 1 if successful, 0 otherwise
+ */
+int tableRefresh(Table *table);
+
+/**
+ * Read records appended by another terminal, and one changed record
+ *
+ * Unlike tableRefresh this leaves other cached records alone, so it is
+ * safe inside a transaction.
+ *
+ * @param table Table to refresh
+ * @param slot Slot to re-read from the data file, or -1 for none
+ * @return 1 if successful, 0 otherwise
+ */
+int tableRefreshRecord(Table *table, int slot);
+
+/**
+ * Write a record straight to its slot in the data file
+ *
+ * The cached table is not changed and the write is not synced; call
+ * tableSync once all records have been written.
+ *
+ * @param table Table the record belongs to
+ * @param slot Slot of the record; at most the number of records in the file
+ * @param record Record contents
+ * @return 1 if successful, 0 otherwise
+ */
+int tableWriteLogged(Table *table, int slot, const void *record);
+
+/**
+ * Sync a table's data file after tableWriteLogged
+ *
+ * @param table Table to sync
+ * @param current Whether the cached table holds what was written
+ * @return 1 if successful, 0 otherwise
+ */
+int tableSync(Table *table, int current);
+
+/**
+ * Forget the slots waiting to be written to every table's data file
+ *
+ * Used once the log has been written to the data files directly.
+ */
+void tableMarkAllClean(void);
+
+/**
+ * Store a record sent by a client of the server in a slot and log it
+ *
+ * @param table Table to store into
+ * @param slot Slot to overwrite, or the slot after the last to append
+ * @param record Record contents
+ * @return 1 if successful, 0 otherwise
+ */
+int tableStore(Table *table, int slot, const void *record);
+
+/**
+ * Start numbering changes and remembering their slots, for a server
+ */
+void tableTrackChanges(void);
+
+/**
+ * List the slots changed since a version of a table
+ *
+ * @param table Table to list changes of
+ * @param since Version the caller's copy of the table matches
+ * @param slots Array of TABLE_CHANGE_LOG entries to fill, in slot order
+ * @return Number of slots listed, or -1 if the changes are no longer known
+ */
+int tableChangedSlots(Table *table, int since, int *slots);
+
+/**
+ * Find the first record whose indexed key equals a value
+ *
+ * Iterate over all matches with indexNext. Inactive records are
+ * included, so callers must still check the record's active flag.
+ *
+ * @param id Secondary index to search
+ * @param key Foreign key value to look up
+ * @return Slot of the first matching record, or -1 if there is none
+ */
+int indexFirst(IndexId id, int key);
+
+/**
+ * Find the next record with the same indexed key as a slot
+ *
+ * @param id Secondary index being iterated
+ * @param slot Slot returned by indexFirst or a previous indexNext
+ * @return Slot of the next matching record, or -1 if there are no more
+ */
+int indexNext(IndexId id, int slot);
+
+#endif /* TABLE_H */
@@ -0,0 +1,345 @@
+/**
+ * Hotel Management System
+ * textheap.c - Text heap implementation
+ *
+ * This file implements the text heap. A text is split over fixed-size
+ * blocks appended under one append lock, so its blocks get consecutive
+ * ids and are read back through the table's primary index. Texts are
+ * interned: a hash of every stored text, built as blocks are appended,
+ * finds an equal text to share before a new one is stored. Released
+ * blocks are marked inactive, and later texts take over their slots.
+ *
+ * Every change to the heap is made under its append lock, and a change
+ * to a text's reference count also locks its first block.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "textheap.h"
+#include "fileio.h"
+#include "table.h"
+#include "wal.h"
+#include "lock.h"
+
+/* Entry in the intern hash: the first block of a stored text */
+typedef struct {
+    unsigned int hash;
+    int id;
+    int next;                   /* Next entry in the same bucket, or -1 */
+} InternEntry;
+
+static InternEntry *internEntries = NULL;
+static int internCount = 0;
+static int internCapacity = 0;
+static int *internBuckets = NULL;
+static int bucketCount = 0;
+static int internedUpTo = 0;        /* Highest block id added to the hash */
+
+/* Create the text heap file if needed and load it */
+int initializeTextData(void) {
+    if (!fileExists(TEXTS_FILE)) {
+        FILE *fp = fopen(TEXTS_FILE, "wb");
+        if (!fp) {
+            printf("\nError: Could not create text heap file.\n");
+            return 0;
+        }
+        fclose(fp);
+    }
+    return loadTable(TABLE_TEXTS);
+}
+
+/* Find the slot of a block, reading blocks stored by another terminal if needed */
+static int findBlock(Table *table, int id) {
+    int slot = tableLookup(table, id);
+
+    if (slot < 0 && id >= table->nextId) {
+        tableRefreshRecord(table, -1);
+        slot = tableLookup(table, id);
+    }
+    return slot;
+}
+
+/* Hash a text with FNV-1a */
+static unsigned int hashText(const char *text) {
+    unsigned int h = 2166136261u;
+
+    while (*text != '\0') {
+        h ^= (unsigned char)*text++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Hash the text starting at a block */
+static unsigned int hashStoredText(Table *table, int id) {
+    unsigned int h = 2166136261u;
+
+    while (id > 0) {
+        int slot = findBlock(table, id);
+        const TextBlock *block;
+        size_t part;
+
+        if (slot < 0) {
+            break;
+        }
+        block = tableRecord(table, slot);
+        part = strnlen(block->text, TEXT_BLOCK_LEN);
+        for (size_t i = 0; i < part; i++) {
+            h ^= (unsigned char)block->text[i];
+            h *= 16777619u;
+        }
+        id = block->next;
+    }
+    return h;
+}
+
+/* Add the first block of a text to the intern hash */
+static int internAdd(unsigned int hash, int id) {
+    if (internCount >= internCapacity) {
+        int capacity = internCapacity > 0 ? internCapacity * 2 : 256;
+        InternEntry *entries = realloc(internEntries, (size_t)capacity * sizeof(InternEntry));
+        if (entries == NULL) {
+            return 0;
+        }
+        internEntries = entries;
+        internCapacity = capacity;
+    }
+    if (internCount >= bucketCount) {
+        int count = bucketCount > 0 ? bucketCount * 2 : 256;
+        int *buckets = malloc((size_t)count * sizeof(int));
+        if (buckets == NULL) {
+            return 0;
+        }
+        free(internBuckets);
+        internBuckets = buckets;
+        bucketCount = count;
+        for (int b = 0; b < bucketCount; b++) {
+            internBuckets[b] = -1;
+        }
+        for (int e = 0; e < internCount; e++) {
+            unsigned int b = internEntries[e].hash & (unsigned int)(bucketCount - 1);
+            internEntries[e].next = internBuckets[b];
+            internBuckets[b] = e;
+        }
+    }
+    internEntries[internCount].hash = hash;
+    internEntries[internCount].id = id;
+    internEntries[internCount].next = internBuckets[hash & (unsigned int)(bucketCount - 1)];
+    internBuckets[hash & (unsigned int)(bucketCount - 1)] = internCount;
+    internCount++;
+    return 1;
+}
+
+/* Add texts appended since the hash was last brought up to date (append lock held) */
+static void internCatchUp(Table *table) {
+    int continued = 0;      /* Id of the block the previous block continues in */
+
+    for (int id = internedUpTo + 1; id < table->nextId; id++) {
+        int slot = tableLookup(table, id);
+        const TextBlock *block;
+
+        if (slot < 0) {
+            continued = 0;
+            continue;
+        }
+        block = tableRecord(table, slot);
+        /* The blocks of a text are consecutive, so a block another continues in is no text's first */
+        if (id != continued && block->isActive > 0 && !internAdd(hashStoredText(table, id), id)) {
+            return;
+        }
+        continued = block->next;
+        internedUpTo = id;
+    }
+}
+
+/* Check whether a stored text equals a string */
+static int textEquals(TextRef ref, const char *text) {
+    Table *table = getTable(TABLE_TEXTS);
+    int id = ref;
+
+    while (id > 0) {
+        int slot = findBlock(table, id);
+        const TextBlock *block;
+        size_t part;
+
+        if (slot < 0) {
+            return 0;
+        }
+        block = tableRecord(table, slot);
+        part = strnlen(block->text, TEXT_BLOCK_LEN);
+        if (strncmp(block->text, text, part) != 0) {
+            return 0;
+        }
+        text += part;
+        id = block->next;
+    }
+    return *text == '\0';
+}
+
+/* Take another reference to an equal stored text, if there is one (append lock held) */
+static TextRef shareText(Table *table, const char *text, unsigned int hash) {
+    if (bucketCount == 0) {
+        return 0;
+    }
+    for (int e = internBuckets[hash & (unsigned int)(bucketCount - 1)]; e >= 0; e = internEntries[e].next) {
+        int id = internEntries[e].id;
+        int slot;
+        TextBlock *block;
+
+        if (internEntries[e].hash != hash || !textEquals(id, text)) {
+            continue;
+        }
+        /* Locking re-reads the count in case another terminal changed it */
+        if (!lockRecord(TABLE_TEXTS, id)) {
+            return -1;
+        }
+        slot = tableLookup(table, id);
+        if (slot < 0) {
+            continue;
+        }
+        block = tableRecord(table, slot);
+        if (block->isActive <= 0) {
+            continue;   /* Released since it was hashed */
+        }
+        block->isActive++;
+        return tableWriteRecord(table, slot) ? id : -1;
+    }
+    return 0;
+}
+
+/* Append the blocks of a new text (append lock held) */
+static TextRef appendText(Table *table, const char *text, size_t length, unsigned int hash) {
+    int blocks = (int)((length + TEXT_BLOCK_LEN - 1) / TEXT_BLOCK_LEN);
+    TextRef first = tableNextId(table);
+
+    for (int i = 0; i < blocks; i++) {
+        TextBlock block;
+        size_t offset = (size_t)i * TEXT_BLOCK_LEN;
+        size_t part = length - offset < TEXT_BLOCK_LEN ? length - offset : TEXT_BLOCK_LEN;
+
+        memset(&block, 0, sizeof(block));
+        block.id = first + i;
+        block.next = i + 1 < blocks ? first + i + 1 : 0;
+        memcpy(block.text, text + offset, part);
+        block.isActive = 1;
+        if (tableInsert(table, &block) < 0) {
+            return -1;
+        }
+    }
+    if (internedUpTo == first - 1) {
+        internAdd(hash, first);
+        internedUpTo = first + blocks - 1;
+    }
+    return first;
+}
+
+/* Store a text in the heap */
+TextRef storeText(const char *text) {
+    Table *table = getTable(TABLE_TEXTS);
+    size_t length = text != NULL ? strlen(text) : 0;
+    unsigned int hash;
+    TextRef ref = -1;
+
+    if (length == 0) {
+        return 0;
+    }
+
+    hash = hashText(text);
+    walBegin();
+    if (lockAppend(TABLE_TEXTS)) {
+        internCatchUp(table);
+        ref = shareText(table, text, hash);
+        if (ref == 0) {
+            ref = appendText(table, text, length, hash);
+        }
+    }
+    if (ref < 0) {
+        walAbort();
+        return -1;
+    }
+    return walCommit() ? ref : -1;
+}
+
+/* Copy a stored text into a buffer */
+const char *getText(TextRef ref, char *buffer, size_t size) {
+    Table *table = getTable(TABLE_TEXTS);
+    size_t used = 0;
+    int id = ref;
+
+    while (id > 0 && used + 1 < size) {
+        int slot = findBlock(table, id);
+        const TextBlock *block;
+        size_t part;
+
+        if (slot < 0) {
+            break;
+        }
+        block = tableRecord(table, slot);
+        part = strnlen(block->text, TEXT_BLOCK_LEN);
+        if (part > size - 1 - used) {
+            part = size - 1 - used;
+        }
+        memcpy(buffer + used, block->text, part);
+        used += part;
+        id = block->next;
+    }
+    if (size > 0) {
+        buffer[used] = '\0';
+    }
+    return buffer;
+}
+
+/* Drop a reference to a text, releasing its blocks with the last one */
+int releaseText(TextRef ref) {
+    Table *table = getTable(TABLE_TEXTS);
+    int id = ref;
+    int ok;
+
+    if (ref <= 0) {
+        return 1;
+    }
+
+    walBegin();
+    ok = lockAppend(TABLE_TEXTS) && lockRecord(TABLE_TEXTS, ref);
+    while (ok && id > 0) {
+        int slot = findBlock(table, id);
+        TextBlock *block;
+
+        if (slot < 0) {
+            break;
+        }
+        block = tableRecord(table, slot);
+        if (id == ref && block->isActive > 1) {
+            block->isActive--;      /* Still shared */
+            ok = tableWriteRecord(table, slot);
+            break;
+        }
+        id = block->next;
+        block->isActive = 0;
+        ok = tableWriteRecord(table, slot);
+    }
+    if (!ok) {
+        walAbort();
+        return 0;
+    }
+    return walCommit();
+}
+
+/* Store a new text for a field and release the old one */
+int replaceText(TextRef *ref, const char *text) {
+    TextRef stored;
+
+    if (textEquals(*ref, text)) {
+        return 1;
+    }
+    stored = storeText(text);
+    if (stored < 0) {
+        return 0;
+    }
+    if (!releaseText(*ref)) {
+        return 0;
+    }
+    *ref = stored;
+    return 1;
+}
@@ -0,0 +1,94 @@
+/**
+ * Hotel Management System
+ * textheap.h - Text heap header
+ *
+ * This file contains declarations for the text heap, which keeps the
+ * free-text fields of rooms, guests, reservations, invoices and
+ * payments out of their records. A record holds a TextRef, the id of
+ * the first block of its text in TEXTS_FILE; longer texts continue in
+ * further blocks. With the text out of line the records stay small, so
+ * scans over ids, statuses, dates and amounts read far fewer bytes.
+ *
+ * The blocks are an ordinary table, so they are logged, locked and
+ * served to clients like any other records. A stored text never
+ * changes: editing a field stores a new text and releases the old one.
+ * Equal texts are stored once and shared, so values repeated across
+ * many records, such as an ID type or a room type's feature list, cost
+ * one reference each.
+ */
+
+#ifndef TEXTHEAP_H
+#define TEXTHEAP_H
+
+#include <stddef.h>
+
+/* File path */
+#define TEXTS_FILE "data/texts.dat"
+
+/* Characters of text held by one block */
+#define TEXT_BLOCK_LEN 52
+
+/* Reference to a stored text: the id of its first block, or 0 for an empty text */
+typedef int TextRef;
+
+/* Text block structure */
+typedef struct {
+    int id;
+    int next;                   /* Id of the block the text continues in, or 0 */
+    char text[TEXT_BLOCK_LEN];  /* Part of the text, NUL-padded in the last block */
+    int isActive;               /* First block: number of references to the text; others: 1 */
+} TextBlock;
+
+/**
+ * Create the text heap file if needed and load it
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int initializeTextData(void);
+
+/**
+ * Store a text in the heap
+ *
+ * If an equal text is already stored, a reference to it is taken
+ * instead. Release the result with releaseText when it is replaced.
+ *
+ * @param text Text to store, or NULL for an empty text
+ * @return Reference to the stored text (0 for an empty text), or -1 on failure
+ */
+TextRef storeText(const char *text);
+
+/**
+ * Copy a stored text into a buffer
+ *
+ * The text is truncated to fit the buffer.
+ *
+ * @param ref Reference to the text
+ * @param buffer Buffer to copy into
+ * @param size Size of the buffer
+ * @return The buffer, for use as an argument
+ */
+const char *getText(TextRef ref, char *buffer, size_t size);
+
+/**
+ * Drop a reference to a text
+ *
+ * The blocks are released with the last reference. The caller must
+ * hold the lock on the record that referred to the text.
+ *
+ * @param ref Reference to the text
+ * @return 1 if successful, 0 otherwise
+ */
+int releaseText(TextRef ref);
+
+/**
+ * Store a new text for a field and release the old one
+ *
+ * Does nothing if the field already holds the text.
+ *
+ * @param ref Field holding the reference; updated on success
+ * @param text New text
+ * @return 1 if successful, 0 otherwise
+ */
+int replaceText(TextRef *ref, const char *text);
+
+#endif /* TEXTHEAP_H */
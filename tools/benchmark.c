@@ -0,0 +1,270 @@
+/**
+ * Hotel Management System
+ * benchmark.c - Scale benchmark for the module APIs
+ *
+ * For each requested size, generates a data set in its own directory
+ * (bench_<reservations>/data), loads it and times repeated calls to the
+ * public module functions, reporting the median and 99th percentile.
+ * Each size runs in a child process so the table cache starts cold.
+ * Output of the module functions is discarded while they are timed.
+ *
+ * Usage: benchmark [reservations ...]   (default: 1000 100000 1000000)
+ *
+ * This tool uses fork and POSIX clocks and does not build on Windows.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "datagen.h"
+#include "auth.h"
+#include "room.h"
+#include "guest.h"
+#include "reservation.h"
+#include "billing.h"
+#include "availability.h"
+#include "fileio.h"
+#include "table.h"
+#include "wal.h"
+#include "utils.h"
+
+#define MAX_MUTATIONS 200
+
+static FILE *out;           /* Benchmark report; stdout itself is discarded */
+
+/* Current time in microseconds */
+static double nowMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+}
+
+/* Compare two samples for qsort */
+static int compareSamples(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Print the median and 99th percentile of a set of samples */
+static void report(const char *name, double *samples, int count) {
+    if (count == 0) {
+        fprintf(out, "%-30s %8s\n", name, "-");
+        return;
+    }
+    qsort(samples, (size_t)count, sizeof(double), compareSamples);
+    fprintf(out, "%-30s %8d %12.2f %12.2f\n", name, count,
+            samples[count / 2], samples[count * 99 / 100 < count ? count * 99 / 100 : count - 1]);
+}
+
+/* Pick a random stay within the next half year */
+static void randomStay(Date *checkIn, Date *checkOut) {
+    *checkIn = getCurrentDay() - 30 + rand() % 210;
+    *checkOut = *checkIn + 1 + rand() % 7;
+}
+
+/* Generate, load and time one data set size */
+static int benchmarkSize(int reservations) {
+    DataGenOptions options;
+    User admin;
+    char dir[64];
+    double start, *samples;
+    int *created, createdCount = 0, *invoiceIds, invoiceCount = 0;
+    int *roomIds, n;
+    Table *rooms, *guests;
+
+    samples = malloc(10000 * sizeof(double));
+    created = malloc(MAX_MUTATIONS * sizeof(int));
+    invoiceIds = malloc(MAX_MUTATIONS * sizeof(int));
+    if (samples == NULL || created == NULL || invoiceIds == NULL) {
+        fprintf(out, "Out of memory\n");
+        return 1;
+    }
+
+    snprintf(dir, sizeof(dir), "bench_%d", reservations);
+    mkdir(dir, 0755);
+    if (chdir(dir) != 0) {
+        fprintf(out, "Could not enter %s\n", dir);
+        return 1;
+    }
+
+    defaultDataGenOptions(&options, reservations);
+    fprintf(out, "\n=== %d reservations, %d rooms, %d guests (%s/data) ===\n",
+            options.reservations, options.rooms, options.guests, dir);
+
+    start = nowMicros();
+    if (!generateData(&options)) {
+        fprintf(out, "Data generation failed\n");
+        return 1;
+    }
+    fprintf(out, "%-30s %21.1f ms\n", "generate data", (nowMicros() - start) / 1000.0);
+
+    setInteractive(0);
+    start = nowMicros();
+    if (!initializeDataFiles()) {
+        fprintf(out, "Loading the data files failed\n");
+        return 1;
+    }
+    fprintf(out, "%-30s %21.1f ms\n", "load tables and indexes", (nowMicros() - start) / 1000.0);
+
+    memset(&admin, 0, sizeof(admin));
+    admin.id = 1;
+    admin.role = ROLE_ADMIN;
+    rooms = getTable(TABLE_ROOMS);
+    guests = getTable(TABLE_GUESTS);
+    roomIds = malloc((size_t)rooms->count * sizeof(int));
+    srand(12345);
+
+    fprintf(out, "%-30s %8s %12s %12s\n", "operation", "calls", "p50 (us)", "p99 (us)");
+
+    for (n = 0; n < 10000; n++) {
+        Room room;
+        int roomId = ((Room *)tableRecord(rooms, rand() % rooms->count))->id;
+        start = nowMicros();
+        getRoomById(roomId, &room);
+        samples[n] = nowMicros() - start;
+    }
+    report("getRoomById", samples, n);
+
+    for (n = 0; n < 10000; n++) {
+        int roomId = ((Room *)tableRecord(rooms, rand() % rooms->count))->id;
+        Date checkIn, checkOut;
+        randomStay(&checkIn, &checkOut);
+        start = nowMicros();
+        checkRoomAvailability(roomId, checkIn, checkOut);
+        samples[n] = nowMicros() - start;
+    }
+    report("checkRoomAvailability", samples, n);
+
+    for (n = 0; n < 200; n++) {
+        Date checkIn, checkOut;
+        randomStay(&checkIn, &checkOut);
+        start = nowMicros();
+        findFreeRooms(checkIn, checkOut, 0, 0, 0.0, roomIds, rooms->count);
+        samples[n] = nowMicros() - start;
+    }
+    report("findFreeRooms", samples, n);
+
+    for (n = 0; n < 10000; n++) {
+        Guest guest;
+        start = nowMicros();
+        getGuestById(1 + rand() % guests->count, &guest);
+        samples[n] = nowMicros() - start;
+    }
+    report("getGuestById", samples, n);
+
+    for (n = 0; n < 10000; n++) {
+        start = nowMicros();
+        hasActiveReservationsByGuest(1 + rand() % guests->count);
+        samples[n] = nowMicros() - start;
+    }
+    report("hasActiveReservationsByGuest", samples, n);
+
+    {
+        int *guestIds = malloc(((size_t)guests->count + 1) * sizeof(int));
+        for (n = 0; n < 50 && guestIds != NULL; n++) {
+            /* Search for three letters of a random guest's name */
+            Guest *guest = tableRecord(guests, rand() % guests->count);
+            char term[4];
+            size_t len = strlen(guest->name);
+            strncpy(term, guest->name + (len > 3 ? (size_t)rand() % (len - 3) : 0), 3);
+            term[3] = '\0';
+            start = nowMicros();
+            findGuests(term, guestIds, guests->count);
+            samples[n] = nowMicros() - start;
+        }
+        free(guestIds);
+        report("findGuests (searchGuests)", samples, n);
+    }
+
+    for (n = 0; n < 5; n++) {
+        start = nowMicros();
+        listReservations(&admin, 0);
+        fflush(stdout);
+        samples[n] = nowMicros() - start;
+    }
+    report("listReservations", samples, n);
+
+    for (n = 0; n < MAX_MUTATIONS; n++) {
+        int roomId = ((Room *)tableRecord(rooms, rand() % rooms->count))->id;
+        Date checkIn = getCurrentDay() + 400 + rand() % 300;
+        int id;
+        start = nowMicros();
+        id = createReservation(&admin, 1 + rand() % guests->count, roomId, checkIn, checkIn + 2, 1, 0.0, "");
+        samples[n] = nowMicros() - start;
+        if (id > 0) created[createdCount++] = id;
+    }
+    report("createReservation", samples, n);
+
+    for (n = 0; n < createdCount; n++) {
+        int id;
+        start = nowMicros();
+        id = createInvoice(&admin, created[n]);
+        samples[n] = nowMicros() - start;
+        if (id > 0) invoiceIds[invoiceCount++] = id;
+    }
+    report("createInvoice", samples, n);
+
+    for (n = 0; n < invoiceCount; n++) {
+        start = nowMicros();
+        recordPayment(&admin, invoiceIds[n], PAYMENT_METHOD_CASH, 1.0, "BENCH", "");
+        samples[n] = nowMicros() - start;
+    }
+    report("recordPayment", samples, n);
+
+    for (n = 0; n < 5; n++) {
+        start = nowMicros();
+        checkOverdueInvoices(getCurrentDay());
+        samples[n] = nowMicros() - start;
+    }
+    report("checkOverdueInvoices", samples, n);
+
+    walCheckpoint();
+    free(roomIds);
+    free(samples);
+    free(created);
+    free(invoiceIds);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const int defaultSizes[] = { 1000, 100000, 1000000 };
+    int sizeCount = argc > 1 ? argc - 1 : 3;
+    int status = 0;
+    int devNull;
+
+    /* Report on the real stdout; send the modules' own output to /dev/null */
+    out = fdopen(dup(STDOUT_FILENO), "w");
+    setvbuf(out, NULL, _IONBF, 0);
+    devNull = open("/dev/null", O_WRONLY);
+    if (out == NULL || devNull < 0) {
+        perror("benchmark");
+        return 1;
+    }
+    fflush(stdout);
+    dup2(devNull, STDOUT_FILENO);
+
+    for (int i = 0; i < sizeCount; i++) {
+        int size = argc > 1 ? atoi(argv[i + 1]) : defaultSizes[i];
+        pid_t pid = fork();
+
+        if (pid == 0) {
+            exit(benchmarkSize(size));
+        } else if (pid > 0) {
+            int childStatus;
+            waitpid(pid, &childStatus, 0);
+            if (!WIFEXITED(childStatus) || WEXITSTATUS(childStatus) != 0) {
+                fprintf(out, "Benchmark for %d reservations failed\n", size);
+                status = 1;
+            }
+        } else {
+            perror("fork");
+            return 1;
+        }
+    }
+    return status;
+}
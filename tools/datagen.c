@@ -0,0 +1,474 @@
+/**
+ * Hotel Management System
+ * datagen.c - Synthetic data generator implementation
+ *
+ * This file implements the synthetic data generator. Reservations,
+ * invoices, billing items and payments are streamed to their files as
+ * they are generated; only rooms and per-guest totals are kept in
+ * memory, so generating millions of records needs little memory.
+ * Free-text fields are streamed to the text heap file the same way.
+ * Each file's header is written once its records have been counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/stat.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <direct.h>
+#define MKDIR(path) _mkdir(path)
+#else
+#define MKDIR(path) mkdir(path, 0755)
+#endif
+#include "datagen.h"
+#include "datafile.h"
+#include "room.h"
+#include "guest.h"
+#include "reservation.h"
+#include "billing.h"
+#include "audit.h"
+#include "textheap.h"
+#include "table.h"
+#include "wal.h"
+#include "migrate.h"
+#include "utils.h"
+
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+#define ROOMS_PER_FLOOR 20
+#define MAX_SHARED_TEXTS 16
+
+static const char *firstNames[] = {
+    "James", "Mary", "Robert", "Patricia", "John", "Jennifer", "Michael", "Linda",
+    "David", "Elizabeth", "William", "Barbara", "Richard", "Susan", "Joseph", "Jessica",
+    "Thomas", "Sarah", "Carlos", "Maria", "Wei", "Yuki", "Ahmed", "Fatima",
+    "Ivan", "Olga", "Pierre", "Amelie", "Raj", "Priya", "Kwame", "Amara"
+};
+static const char *lastNames[] = {
+    "Smith", "Johnson", "Williams", "Brown", "Jones", "Garcia", "Miller", "Davis",
+    "Rodriguez", "Martinez", "Hernandez", "Lopez", "Wilson", "Anderson", "Taylor", "Thomas",
+    "Moore", "Jackson", "Martin", "Lee", "Chen", "Tanaka", "Khan", "Ivanov",
+    "Dubois", "Patel", "Mensah", "Okafor", "Schmidt", "Rossi", "Silva", "Kowalski"
+};
+static const char *streets[] = {
+    "Main St", "Oak Ave", "Pine Rd", "Maple Dr", "Cedar Ln", "Elm St", "Lake View", "Hill Rd"
+};
+static const char *idTypes[] = { "Passport", "License", "National ID" };
+static const char *roomDescriptions[] = {
+    "Comfortable standard room", "Spacious deluxe room", "Suite with separate living area",
+    "Executive suite with work area", "Presidential suite with panoramic view"
+};
+static const char *roomFeatures[] = {
+    "WiFi, TV, Air conditioning", "WiFi, TV, Minibar, City view", "WiFi, TV, Minibar, Sofa, Bathtub",
+    "WiFi, TV, Minibar, Desk, Lounge access", "WiFi, TV, Minibar, Jacuzzi, Butler service"
+};
+static const char *generatedInvoiceNote = "Generated invoice.";
+static const char *extraDescriptions[] = { "Room service", "Laundry", "Minibar", "Spa treatment" };
+
+static unsigned int rngState = 1;
+static FILE *textFp = NULL;
+static int nextTextId = 1;
+
+/* A text from one of the lists above, written once and shared */
+typedef struct {
+    const char *text;
+    TextRef ref;
+    int refs;
+} SharedText;
+
+static SharedText sharedTexts[MAX_SHARED_TEXTS];
+static int sharedTextCount = 0;
+
+/* Next pseudo-random number (xorshift32) */
+static unsigned int nextRandom(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+/* Pseudo-random integer in [low, high] */
+static int randomBetween(int low, int high) {
+    return low + (int)(nextRandom() % (unsigned int)(high - low + 1));
+}
+
+/* Number of nights in a stay: mostly short, occasionally a week or more */
+static int randomStayLength(void) {
+    int r = randomBetween(0, 99);
+    if (r < 25) return 1;
+    if (r < 50) return 2;
+    if (r < 68) return 3;
+    if (r < 80) return 4;
+    if (r < 86) return 5;
+    if (r < 90) return 6;
+    if (r < 95) return 7;
+    return randomBetween(8, 14);
+}
+
+/* Empty nights between two stays in the same room */
+static int randomGap(void) {
+    int r = randomBetween(0, 99);
+    if (r < 50) return 0;
+    if (r < 80) return 1;
+    if (r < 95) return randomBetween(2, 4);
+    return randomBetween(5, 14);
+}
+
+/* Open a data file for writing with a large buffer, leaving room for its header */
+static FILE *openOutput(const char *path) {
+    DataHeader header;
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        printf("\nError: Could not create %s\n", path);
+        return NULL;
+    }
+    setvbuf(fp, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+    memset(&header, 0, sizeof(header));
+    fwrite(&header, sizeof(header), 1, fp);
+    return fp;
+}
+
+/* Write a data file's header now its records are counted, and close it */
+static int closeOutput(FILE *fp, const char *path, size_t recordSize, int count, int nextId) {
+    DataHeader header;
+    int ok;
+
+    initDataHeader(&header, recordSize, count, nextId);
+    ok = fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+    if (fclose(fp) != 0 || !ok) {
+        printf("\nError: Could not write %s\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+/* Append a text to the text heap file and return its reference */
+static TextRef writeText(const char *text) {
+    size_t length = strlen(text);
+    TextRef first = nextTextId;
+
+    if (length == 0) {
+        return 0;
+    }
+    for (size_t offset = 0; offset < length; offset += TEXT_BLOCK_LEN) {
+        TextBlock block;
+        size_t part = length - offset < TEXT_BLOCK_LEN ? length - offset : TEXT_BLOCK_LEN;
+
+        memset(&block, 0, sizeof(block));
+        block.id = nextTextId++;
+        block.next = offset + part < length ? nextTextId : 0;
+        memcpy(block.text, text + offset, part);
+        block.isActive = 1;
+        fwrite(&block, sizeof(block), 1, textFp);
+    }
+    return first;
+}
+
+/* Write a text from one of the fixed lists once and return a shared reference */
+static TextRef writeSharedText(const char *text) {
+    SharedText *shared;
+
+    for (int i = 0; i < sharedTextCount; i++) {
+        if (sharedTexts[i].text == text) {
+            sharedTexts[i].refs++;
+            return sharedTexts[i].ref;
+        }
+    }
+    if (sharedTextCount == MAX_SHARED_TEXTS) {
+        return writeText(text);
+    }
+    shared = &sharedTexts[sharedTextCount++];
+    shared->text = text;
+    shared->ref = writeText(text);
+    shared->refs = 1;
+    return shared->ref;
+}
+
+/* Store the reference counts of the shared texts in their first blocks */
+static int finishSharedTexts(void) {
+    for (int i = 0; i < sharedTextCount; i++) {
+        long offset = (long)sizeof(DataHeader) + (long)(sharedTexts[i].ref - 1) * (long)sizeof(TextBlock) +
+                      (long)offsetof(TextBlock, isActive);
+
+        if (fseek(textFp, offset, SEEK_SET) != 0 ||
+            fwrite(&sharedTexts[i].refs, sizeof(int), 1, textFp) != 1) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Fill in options scaled from a reservation count */
+void defaultDataGenOptions(DataGenOptions *options, int reservations) {
+    options->reservations = reservations;
+    options->rooms = reservations / 100 > 50 ? reservations / 100 : 50;
+    options->guests = reservations / 2 > 100 ? reservations / 2 : 100;
+    options->seed = 12345;
+}
+
+/* Build the room list */
+static void generateRooms(Room *rooms, int count) {
+    for (int i = 0; i < count; i++) {
+        Room *room = &rooms[i];
+        int r = randomBetween(0, 99);
+        int type = r < 50 ? 0 : r < 75 ? 1 : r < 87 ? 2 : r < 95 ? 3 : 4;
+        static const double baseRates[] = { 100.0, 150.0, 250.0, 350.0, 500.0 };
+        static const int capacities[] = { 2, 2, 3, 4, 6 };
+
+        memset(room, 0, sizeof(Room));
+        room->id = (i / ROOMS_PER_FLOOR + 1) * 100 + i % ROOMS_PER_FLOOR + 1;
+        room->type = (RoomType)(type + 1);
+        room->status = ROOM_STATUS_AVAILABLE;
+        room->rate = baseRates[type] + randomBetween(0, 10) * 5.0;
+        room->description = writeSharedText(roomDescriptions[type]);
+        room->features = writeSharedText(roomFeatures[type]);
+        room->capacity = capacities[type];
+        room->floor = i / ROOMS_PER_FLOOR + 1;
+        room->isActive = 1;
+    }
+}
+
+/* Build a guest record with the given stay totals */
+static void buildGuest(Guest *guest, int id, Date today, int stays, double spent) {
+    char address[MAX_ADDRESS_LEN];
+    const char *first = firstNames[randomBetween(0, (int)(sizeof(firstNames) / sizeof(firstNames[0])) - 1)];
+    const char *last = lastNames[randomBetween(0, (int)(sizeof(lastNames) / sizeof(lastNames[0])) - 1)];
+
+    memset(guest, 0, sizeof(Guest));
+    guest->id = id;
+    snprintf(guest->name, sizeof(guest->name), "%s %s", first, last);
+    snprintf(address, sizeof(address), "%d %s", randomBetween(1, 999),
+             streets[randomBetween(0, (int)(sizeof(streets) / sizeof(streets[0])) - 1)]);
+    guest->address = writeText(address);
+    snprintf(guest->phone, sizeof(guest->phone), "555-%07d", id % 10000000);
+    snprintf(guest->email, sizeof(guest->email), "%.12s.%.12s%d@example.com", first, last, id);
+    snprintf(guest->idNumber, sizeof(guest->idNumber), "X%08d", id);
+    guest->idType = writeSharedText(idTypes[randomBetween(0, 2)]);
+    dateToString(today - randomBetween(0, 1000), guest->registrationDate);
+    guest->totalStays = stays;
+    guest->totalSpent = spent;
+    guest->isActive = 1;
+    guest->vipStatus = spent > 20000 ? VIP_STATUS_GOLD : spent > 10000 ? VIP_STATUS_SILVER :
+                       spent > 5000 ? VIP_STATUS_BRONZE : VIP_STATUS_REGULAR;
+}
+
+/* Generate rooms, guests, reservations, invoices, billing items and payments */
+int generateData(const DataGenOptions *options) {
+    FILE *resFp, *invFp, *itemFp, *payFp, *fp;
+    Room *rooms;
+    Date *nextFree;
+    int *guestStays;
+    double *guestSpent;
+    Date today = getCurrentDay();
+    int staysPerRoom, span;
+    Date firstDay;
+    int invoiceCount = 0, itemCount = 0, paymentCount = 0;
+    int ok = 1;
+
+    if (options->rooms < 1 || options->guests < 1 || options->reservations < 0) {
+        printf("\nError: Need at least one room and one guest.\n");
+        return 0;
+    }
+
+    MKDIR("data");
+    rngState = options->seed != 0 ? options->seed : 1;
+    textFp = openOutput(TEXTS_FILE);
+    if (textFp == NULL) {
+        return 0;
+    }
+    nextTextId = 1;
+    sharedTextCount = 0;
+
+    rooms = malloc((size_t)options->rooms * sizeof(Room));
+    nextFree = malloc((size_t)options->rooms * sizeof(Date));
+    guestStays = calloc((size_t)options->guests, sizeof(int));
+    guestSpent = calloc((size_t)options->guests, sizeof(double));
+    if (rooms == NULL || nextFree == NULL || guestStays == NULL || guestSpent == NULL) {
+        printf("\nError: Out of memory.\n");
+        fclose(textFp);
+        free(rooms);
+        free(nextFree);
+        free(guestStays);
+        free(guestSpent);
+        return 0;
+    }
+
+    generateRooms(rooms, options->rooms);
+
+    /* About 4.2 days per stay including gaps; put four fifths of them in the past */
+    staysPerRoom = (options->reservations + options->rooms - 1) / options->rooms;
+    span = staysPerRoom * 42 / 10 + 1;
+    firstDay = today - span * 4 / 5;
+    for (int i = 0; i < options->rooms; i++) {
+        nextFree[i] = firstDay + randomBetween(0, 3);
+    }
+
+    resFp = openOutput(RESERVATIONS_FILE);
+    invFp = openOutput(INVOICES_FILE);
+    itemFp = openOutput(BILLING_ITEMS_FILE);
+    payFp = openOutput(PAYMENTS_FILE);
+    if (resFp == NULL || invFp == NULL || itemFp == NULL || payFp == NULL) {
+        ok = 0;
+    }
+
+    for (int i = 0; ok && i < options->reservations; i++) {
+        int roomIndex = i % options->rooms;
+        Room *room = &rooms[roomIndex];
+        Reservation res;
+        int nights, guestIndex, r;
+
+        /* A tenth of the guests account for a third of the stays */
+        guestIndex = randomBetween(0, 2) == 0 ? randomBetween(0, (options->guests - 1) / 10)
+                                              : randomBetween(0, options->guests - 1);
+
+        nights = randomStayLength();
+        memset(&res, 0, sizeof(res));
+        res.id = i + 1;
+        res.guestId = guestIndex + 1;
+        res.roomId = room->id;
+        res.checkInDate = nextFree[roomIndex] + randomGap();
+        res.checkOutDate = res.checkInDate + nights;
+        nextFree[roomIndex] = res.checkOutDate;
+        res.numGuests = randomBetween(1, room->capacity);
+        res.totalAmount = room->rate * nights;
+        dateToString(res.checkInDate - randomBetween(1, 60), res.creationDate);
+        strcat(res.creationDate, " 12:00:00");
+        res.createdBy = 1;
+        res.isActive = 1;
+
+        r = randomBetween(0, 99);
+        if (res.checkOutDate <= today) {
+            res.status = r < 3 ? RESERVATION_STATUS_CANCELLED :
+                         r < 5 ? RESERVATION_STATUS_NO_SHOW : RESERVATION_STATUS_CHECKED_OUT;
+        } else if (res.checkInDate <= today) {
+            res.status = RESERVATION_STATUS_CHECKED_IN;
+            room->status = ROOM_STATUS_OCCUPIED;
+        } else {
+            res.status = r < 2 ? RESERVATION_STATUS_CANCELLED : RESERVATION_STATUS_CONFIRMED;
+            res.paidAmount = r < 30 ? room->rate : 0.0;
+        }
+
+        /* Stays that took place get an invoice with the room charge and extras */
+        if (res.status == RESERVATION_STATUS_CHECKED_OUT || res.status == RESERVATION_STATUS_CHECKED_IN) {
+            Invoice inv;
+            BillingItem item;
+            Payment pay;
+            char transactionId[MAX_PAYMENT_REF_LEN];
+            int extras = randomBetween(0, 3);
+
+            memset(&inv, 0, sizeof(inv));
+            inv.id = ++invoiceCount;
+            inv.guestId = res.guestId;
+            inv.reservationId = res.id;
+            inv.issueDate = res.checkInDate;
+            inv.dueDate = res.checkOutDate;
+            inv.createdBy = 1;
+            inv.isActive = 1;
+            inv.notes = writeSharedText(generatedInvoiceNote);
+
+            for (int e = 0; e <= extras; e++) {
+                memset(&item, 0, sizeof(item));
+                item.id = ++itemCount;
+                item.invoiceId = inv.id;
+                if (e == 0) {
+                    item.type = BILLING_ITEM_ROOM_CHARGE;
+                    snprintf(item.description, sizeof(item.description), "Room %d stay (%d nights)", room->id, nights);
+                    item.unitPrice = room->rate;
+                    item.quantity = nights;
+                } else {
+                    item.type = (BillingItemType)randomBetween(BILLING_ITEM_FOOD_SERVICE, BILLING_ITEM_SPA);
+                    strcpy(item.description, extraDescriptions[item.type - BILLING_ITEM_FOOD_SERVICE]);
+                    item.unitPrice = randomBetween(5, 80);
+                    item.quantity = randomBetween(1, 3);
+                }
+                item.amount = item.unitPrice * item.quantity;
+                item.serviceDate = inv.issueDate;
+                item.isActive = 1;
+                inv.subtotal += item.amount;
+                fwrite(&item, sizeof(item), 1, itemFp);
+            }
+            inv.totalAmount = inv.subtotal;
+
+            memset(&pay, 0, sizeof(pay));
+            pay.id = ++paymentCount;
+            pay.invoiceId = inv.id;
+            pay.method = (PaymentMethod)randomBetween(PAYMENT_METHOD_CASH, PAYMENT_METHOD_ONLINE);
+            pay.status = PAYMENT_STATUS_COMPLETED;
+            pay.createdBy = 1;
+            pay.isActive = 1;
+            snprintf(transactionId, sizeof(transactionId), "TX%08d", pay.id);
+            pay.transactionId = writeText(transactionId);
+            if (res.status == RESERVATION_STATUS_CHECKED_OUT) {
+                pay.amount = inv.totalAmount;
+                pay.transactionDate = res.checkOutDate;
+                inv.status = INVOICE_STATUS_PAID;
+                res.paidAmount = res.totalAmount;
+                guestStays[guestIndex]++;
+                guestSpent[guestIndex] += inv.totalAmount;
+            } else {
+                pay.amount = room->rate;
+                pay.transactionDate = res.checkInDate;
+                inv.status = INVOICE_STATUS_ISSUED;
+                res.paidAmount = room->rate;
+            }
+            inv.paidAmount = pay.amount;
+
+            fwrite(&pay, sizeof(pay), 1, payFp);
+            fwrite(&inv, sizeof(inv), 1, invFp);
+        }
+
+        if (fwrite(&res, sizeof(res), 1, resFp) != 1) {
+            printf("\nError: Could not write %s\n", RESERVATIONS_FILE);
+            ok = 0;
+        }
+    }
+
+    if (resFp != NULL && !closeOutput(resFp, RESERVATIONS_FILE, sizeof(Reservation),
+                                      options->reservations, options->reservations + 1)) ok = 0;
+    if (invFp != NULL && !closeOutput(invFp, INVOICES_FILE, sizeof(Invoice), invoiceCount, invoiceCount + 1)) ok = 0;
+    if (itemFp != NULL && !closeOutput(itemFp, BILLING_ITEMS_FILE, sizeof(BillingItem), itemCount, itemCount + 1)) ok = 0;
+    if (payFp != NULL && !closeOutput(payFp, PAYMENTS_FILE, sizeof(Payment), paymentCount, paymentCount + 1)) ok = 0;
+
+    if (ok && (fp = openOutput(ROOMS_FILE)) != NULL) {
+        fwrite(rooms, sizeof(Room), (size_t)options->rooms, fp);
+        ok = closeOutput(fp, ROOMS_FILE, sizeof(Room), options->rooms, rooms[options->rooms - 1].id + 1);
+    } else {
+        ok = 0;
+    }
+
+    if (ok && (fp = openOutput(GUESTS_FILE)) != NULL) {
+        Guest guest;
+        for (int i = 0; i < options->guests; i++) {
+            buildGuest(&guest, i + 1, today, guestStays[i], guestSpent[i]);
+            fwrite(&guest, sizeof(guest), 1, fp);
+        }
+        ok = closeOutput(fp, GUESTS_FILE, sizeof(Guest), options->guests, options->guests + 1);
+    } else {
+        ok = 0;
+    }
+    if (!finishSharedTexts()) {
+        printf("\nError: Could not write %s\n", TEXTS_FILE);
+        ok = 0;
+    }
+    if (!closeOutput(textFp, TEXTS_FILE, sizeof(TextBlock), nextTextId - 1, nextTextId)) {
+        ok = 0;
+    }
+
+    /* A stale log must not be replayed over the new files, the business date
+       starts again from today, and the new headers replace older format files */
+    remove(WAL_FILE);
+    remove(AUDITS_FILE);
+    remove(SEQUENCES_FILE);
+    remove(FORMAT_FILE);
+
+    free(rooms);
+    free(nextFree);
+    free(guestStays);
+    free(guestSpent);
+
+    if (ok) {
+        printf("Generated %d rooms, %d guests, %d reservations, %d invoices, %d billing items, %d payments.\n",
+               options->rooms, options->guests, options->reservations, invoiceCount, itemCount, paymentCount);
+    }
+    return ok;
+}
@@ -0,0 +1,50 @@
+/**
+ * Hotel Management System
+ * datagen.h - Synthetic data generator header
+ *
+ * This file contains declarations for writing synthetic data files at
+ * scale. Records are written straight into the data files in the record
+ * layouts of room.h, guest.h, reservation.h and billing.h, bypassing
+ * the write-ahead log, so the generator must not run while the system
+ * is using the same data directory.
+ */
+
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+/* Generator options */
+typedef struct {
+    int rooms;              /* Number of rooms */
+    int guests;             /* Number of guests */
+    int reservations;       /* Number of reservations */
+    unsigned int seed;      /* Random seed; the same seed gives the same data */
+} DataGenOptions;
+
+/**
+ * Fill in options scaled from a reservation count
+ *
+ * Uses one room per 100 reservations (at least 50) and one guest per
+ * two reservations (at least 100).
+ *
+ * @param options Options to fill in
+ * @param reservations Number of reservations
+ */
+void defaultDataGenOptions(DataGenOptions *options, int reservations);
+
+/**
+ * Generate rooms, guests, reservations, invoices, billing items and payments
+ *
+ * Each room gets a sequence of non-overlapping stays of mostly one to
+ * four nights with short gaps, spread so that about four fifths of the
+ * stays lie in the past. Past stays are checked out (a few cancelled
+ * or no-shows) and fully paid, stays in progress are checked in and
+ * partly paid, and future stays are confirmed without an invoice.
+ * Existing data files, the log and the night audit
+ * history are replaced; the users file is left alone.
+ *
+ * @param options Generator options
+ * @return 1 if successful, 0 otherwise
+ */
+int generateData(const DataGenOptions *options);
+
+#endif /* DATAGEN_H */
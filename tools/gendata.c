@@ -0,0 +1,28 @@
+/**
+ * Hotel Management System
+ * gendata.c - Synthetic data generator command
+ *
+ * Writes synthetic data files into data/ under the current directory.
+ *
+ * Usage: gendata <reservations> [rooms] [guests] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "datagen.h"
+
+int main(int argc, char *argv[]) {
+    DataGenOptions options;
+
+    if (argc < 2 || argc > 5) {
+        printf("Usage: %s <reservations> [rooms] [guests] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    defaultDataGenOptions(&options, atoi(argv[1]));
+    if (argc > 2) options.rooms = atoi(argv[2]);
+    if (argc > 3) options.guests = atoi(argv[3]);
+    if (argc > 4) options.seed = (unsigned int)strtoul(argv[4], NULL, 10);
+
+    return generateData(&options) ? 0 : 1;
+}
@@ -12,6 +12,10 @@
  #include "ui.h"
  #include "utils.h"
  #include "billing.h"
+ #include "audit.h"
+ #include "occupancy.h"
+ #include "revenue.h"
+ #include "lock.h"
  
  
  /**
@@ -57,26 +61,35 @@
      int choice;
      
      do {
+         refreshTables();
          clearScreen();
          displayHeader("Reports Menu");
          
          printf("1. Overdue Payments Report\n");
-         printf("2. Occupancy Report (Not Implemented)\n");
-         printf("3. Revenue Report (Not Implemented)\n");
+         printf("2. Occupancy Report\n");
+         printf("3. Revenue Report\n");
+         printf("4. Run Night Audit\n");
          printf("0. Back to Main Menu\n");
          
-         choice = getIntInput("\nEnter your choice: ", 0, 3);
+         choice = getIntInput("\nEnter your choice: ", 0, 4);
          
          switch (choice) {
              case 1:
-                 checkOverdueInvoices();
+                 if (checkOverdueInvoices(getCurrentDay()) < 0) {
+                     break;
+                 }
                  // To-do: Create a dedicated listing function for the report
                  printf("\nOverdue invoices check complete. Invoices are now updated.\n");
                  listInvoices(currentUser, INVOICE_STATUS_OVERDUE);
                  break;
              case 2:
+                 occupancyReportMenu(currentUser);
+                 break;
              case 3:
-                 printf("\nThis report is not yet implemented.\n");
+                 revenueReportMenu(currentUser);
+                 break;
+             case 4:
+                 nightAuditMenu(currentUser);
                  break;
              case 0:
                  return;
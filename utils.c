@@ -33,6 +33,9 @@
  
  #include "utils.h"
  
+ // Whether a user is at the console; batch mode turns this off
+ static int interactive = 1;
+ 
  // Helper function to clear the input buffer safely
  static void clear_input_buffer() {
      int c;
@@ -106,8 +109,15 @@
      }
  
      if (fgets(output, maxLen, stdin) != NULL) {
-         // Remove newline character if present
-         output[strcspn(output, "\n")] = '\0';
+         size_t len = strcspn(output, "\n");
+         if (output[len] == '\n') {
+             // Remove newline character if present
+             output[len] = '\0';
+         } else {
+             // Input was longer than the buffer, so discard the rest of the line
+             int c;
+             while ((c = getchar()) != '\n' && c != EOF);
+         }
      } else {
          // Handle potential input error
          output[0] = '\0';
@@ -160,31 +170,81 @@
      }
  }
   
+ /**
+   * Get the current date as a day number
+   */
+ Date getCurrentDay(void) {
+     time_t now = time(NULL);
+     struct tm *t = localtime(&now);
+     if (t == NULL) {
+         return 0;
+     }
+     return daysFromCivil(t->tm_year + 1900, t->tm_mon + 1, t->tm_mday);
+ }
+  
  /**
    * Calculate the number of days between two dates
    */
  int calculateDateDifference(const char *startDate, const char *endDate) {
-     struct tm start_tm = {0}, end_tm = {0};
+     Date start, end;
      
-     if (sscanf(startDate, "%d-%d-%d", &start_tm.tm_year, &start_tm.tm_mon, &start_tm.tm_mday) != 3 ||
-         sscanf(endDate, "%d-%d-%d", &end_tm.tm_year, &end_tm.tm_mon, &end_tm.tm_mday) != 3) {
+     if (!dateFromString(startDate, &start) || !dateFromString(endDate, &end)) {
          return -1; // Invalid format
      }
-      
-     start_tm.tm_year -= 1900;
-     start_tm.tm_mon -= 1;
-     end_tm.tm_year -= 1900;
-     end_tm.tm_mon -= 1;
-      
-     time_t start_time = mktime(&start_tm);
-     time_t end_time = mktime(&end_tm);
- 
-     if (start_time == -1 || end_time == -1) {
-         return -1; // Invalid date
+     return end - start;
+ }
+  
+ /**
+   * Convert a civil date to days since 1970-01-01
+   */
+ Date daysFromCivil(int year, int month, int day) {
+     /* Count days in 400-year eras, with each year starting in March */
+     year -= month <= 2;
+     int era = (year >= 0 ? year : year - 399) / 400;
+     int yearOfEra = year - era * 400;
+     int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+     int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+     
+     return era * 146097 + dayOfEra - 719468;
+ }
+  
+ /**
+   * Convert days since 1970-01-01 to a civil date
+   */
+ void civilFromDays(Date date, int *year, int *month, int *day) {
+     int z = date + 719468;
+     int era = (z >= 0 ? z : z - 146096) / 146097;
+     int dayOfEra = z - era * 146097;
+     int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+     int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+     int monthIndex = (5 * dayOfYear + 2) / 153; // March = 0
+     
+     *day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+     *month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+     *year = yearOfEra + era * 400 + (*month <= 2);
+ }
+  
+ /**
+   * Parse a date in YYYY-MM-DD format into days since 1970-01-01
+   */
+ int dateFromString(const char *dateStr, Date *date) {
+     int year, month, day;
+     
+     if (sscanf(dateStr, "%d-%d-%d", &year, &month, &day) != 3) {
+         return 0;
      }
-      
-     double difference = difftime(end_time, start_time);
-     return (int)(difference / (60 * 60 * 24));
+     *date = daysFromCivil(year, month, day);
+     return 1;
+ }
+  
+ /**
+   * Format days since 1970-01-01 as YYYY-MM-DD
+   */
+ void dateToString(Date date, char *dateStr) {
+     int year, month, day;
+     
+     civilFromDays(date, &year, &month, &day);
+     sprintf(dateStr, "%04d-%02d-%02d", year, month, day);
  }
   
  /**
@@ -201,14 +261,34 @@
      if (year < 1900 || year > 2100 || month < 1 || month > 12 || day < 1 || day > 31) {
          return 0;
      }
-     // This is a basic check; a more robust one would check days in month.
-     return 1;
+     
+     // Reject days past the end of the month (e.g. 2026-02-30) by round-tripping
+     int checkYear, checkMonth, checkDay;
+     civilFromDays(daysFromCivil(year, month, day), &checkYear, &checkMonth, &checkDay);
+     return checkMonth == month && checkDay == day;
+ }
+  
+ /**
+   * Set whether a user is at the console
+   */
+ void setInteractive(int isUserPresent) {
+      interactive = isUserPresent;
+ }
+  
+ /**
+   * Check whether a user is at the console
+   */
+ int isInteractive(void) {
+      return interactive;
  }
   
  /**
    * Clear the console screen
    */
  void clearScreen(void) {
+     if (!interactive) {
+         return; // No one to look at the screen, and no shell to fork
+     }
      #if defined(_WIN32) || defined(_WIN64)
          system("cls");
      #else
@@ -220,6 +300,9 @@
    * Pause execution until user presses Enter
    */
  void pauseExecution(void) {
+      if (!interactive) {
+          return;
+      }
       printf("\nPress Enter to continue...");
       clear_input_buffer();
  }
\ No newline at end of file
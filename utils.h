@@ -9,6 +9,12 @@
  #ifndef UTILS_H
  #define UTILS_H
  
+ /* Calendar date stored as the number of days since 1970-01-01 */
+ typedef int Date;
+ 
+ /* Buffer size for a date in YYYY-MM-DD format */
+ #define DATE_STRING_LEN 11
+ 
  /**
   * Get integer input from user with validation
   */
@@ -44,11 +50,46 @@ int validateDate(const char *dateStr);
   */
  void getCurrentDateTime(char *dateTimeStr);
  
+ /**
+  * Get the current date as a day number
+  */
+ Date getCurrentDay(void);
+ 
  /**
   * Calculate the number of days between two dates in YYYY-MM-DD format
   */
  int calculateDateDifference(const char *startDate, const char *endDate);
  
+ /**
+  * Convert a civil year, month and day to a day number
+  */
+ Date daysFromCivil(int year, int month, int day);
+ 
+ /**
+  * Convert a day number to a civil year, month and day
+  */
+ void civilFromDays(Date date, int *year, int *month, int *day);
+ 
+ /**
+  * Parse a date in YYYY-MM-DD format into a day number
+  */
+ int dateFromString(const char *dateStr, Date *date);
+ 
+ /**
+  * Format a day number as YYYY-MM-DD (buffer of DATE_STRING_LEN bytes)
+  */
+ void dateToString(Date date, char *dateStr);
+ 
+ /**
+  * Set whether a user is at the console (screen clears and pauses are skipped otherwise)
+  */
+ void setInteractive(int interactive);
+ 
+ /**
+  * Check whether a user is at the console
+  */
+ int isInteractive(void);
+ 
  /**
   * Clear the console screen
   */
@@ -0,0 +1,827 @@
+/**
+ * Hotel Management System
+ * wal.c - Write-ahead log implementation
+ *
+ * This file implements the write-ahead log. Each thread collects the
+ * entries of its current transaction in a private buffer; at commit the
+ * buffer and a commit marker are appended to the log in one write.
+ *
+ * Commits are grouped: the first committer to find the log unsynced
+ * becomes the leader and issues one fsync covering everything written
+ * so far, while later committers wait for it instead of issuing their
+ * own. A checkpoint writes the changed slots of every table to the data
+ * files, syncs them and truncates the log.
+ *
+ * While other terminals share the data directory (see lock.h), the log
+ * is written under a lock in LOCK_FILE, and each commit is written
+ * through: its entries are synced to the log, copied to their slots in
+ * the data files and the log is emptied before the lock is released.
+ * Entries another terminal left in the log, if it stopped half way, are
+ * replayed first.
+ *
+ * A client of a server hands each committed transaction to the server,
+ * whose worker threads apply it and commit it to their own log.
+ *
+ * walAbort undoes a transaction, or the part of it since the matching
+ * walBegin, by putting each slot it changed back to its contents at
+ * that point: from an earlier entry of the same transaction, the last
+ * committed entry in the log, or the data file. Records it appended
+ * are dropped from the table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include "wal.h"
+#include "lock.h"
+#include "server.h"
+
+/* Entry types */
+#define WAL_ENTRY_RECORD 1
+#define WAL_ENTRY_COMMIT 2
+
+/* Entry header, followed by length bytes of record data */
+typedef struct {
+    unsigned int checksum;  /* Covers the rest of the header and the data */
+    int type;
+    int table;
+    int slot;
+    int length;
+} WalEntry;
+
+/* Deepest nesting of walBegin calls that walAbort can undo separately */
+#define WAL_MAX_DEPTH 32
+
+/* A record appended by the calling thread's open transaction */
+typedef struct {
+    size_t offset;          /* Where its entry starts in the transaction buffer */
+    int table;
+    int slot;
+} WalAppend;
+
+/* Entries of the calling thread's open transaction */
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    int depth;              /* Nesting depth of walBegin calls */
+    size_t marks[WAL_MAX_DEPTH];    /* Buffer length at each open walBegin */
+    WalAppend *appends;     /* Appends logged so far, in order */
+    int appendCount;
+    int appendCapacity;
+    int unlogged;           /* Whether a changed slot could not be logged */
+    int unloggedTable;
+    int unloggedSlot;
+    size_t unloggedOffset;  /* Buffer length when it failed */
+} WalTransaction;
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WAL_THREAD_LOCAL
+#define WAL_LOCK()
+#define WAL_UNLOCK()
+static FILE *walFile = NULL;
+#else
+#define WAL_THREAD_LOCAL _Thread_local
+#define WAL_LOCK() pthread_mutex_lock(&walMutex)
+#define WAL_UNLOCK() pthread_mutex_unlock(&walMutex)
+static pthread_mutex_t walMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t walSynced = PTHREAD_COND_INITIALIZER;
+static int walFd = -1;
+static int walSyncing = 0;  /* Whether a leader is running fsync */
+#endif
+
+static WAL_THREAD_LOCAL WalTransaction txn;
+static long walWritten = 0;    /* Bytes appended to the log */
+static long walDurable = 0;    /* Bytes known to be on disk */
+static long walGeneration = 0; /* Incremented each time the log is truncated */
+static int manualCheckpoints = 0; /* Whether commits leave checkpoints to the caller */
+
+/* FNV-1a checksum of an entry header (after the checksum) and its data */
+static unsigned int entryChecksum(const WalEntry *entry, const void *data) {
+    const unsigned char *p = (const unsigned char *)&entry->type;
+    size_t headerLength = sizeof(WalEntry) - offsetof(WalEntry, type);
+    unsigned int h = 2166136261u;
+
+    for (size_t i = 0; i < headerLength; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    p = data;
+    for (int i = 0; i < entry->length; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+/* Append an entry to the calling thread's transaction buffer */
+static int bufferEntry(int type, int table, int slot, const void *data, size_t length) {
+    WalEntry entry;
+    size_t needed = txn.length + sizeof(WalEntry) + length;
+
+    if (needed > txn.capacity) {
+        size_t newCapacity = txn.capacity > 0 ? txn.capacity : 4096;
+        char *newData;
+
+        while (newCapacity < needed) {
+            newCapacity *= 2;
+        }
+        newData = realloc(txn.data, newCapacity);
+        if (newData == NULL) {
+            printf("\nError: Out of memory while logging a change.\n");
+            return 0;
+        }
+        txn.data = newData;
+        txn.capacity = newCapacity;
+    }
+
+    memset(&entry, 0, sizeof(entry));
+    entry.type = type;
+    entry.table = table;
+    entry.slot = slot;
+    entry.length = (int)length;
+    entry.checksum = entryChecksum(&entry, data);
+
+    memcpy(txn.data + txn.length, &entry, sizeof(entry));
+    if (length > 0) {
+        memcpy(txn.data + txn.length + sizeof(entry), data, length);
+    }
+    txn.length = needed;
+    return 1;
+}
+
+/* Remember that the entry about to be buffered appends a record */
+static int bufferAppend(int table, int slot) {
+    if (txn.appendCount == txn.appendCapacity) {
+        int newCapacity = txn.appendCapacity > 0 ? txn.appendCapacity * 2 : 16;
+        WalAppend *newAppends = realloc(txn.appends, (size_t)newCapacity * sizeof(WalAppend));
+
+        if (newAppends == NULL) {
+            printf("\nError: Out of memory while logging a change.\n");
+            return 0;
+        }
+        txn.appends = newAppends;
+        txn.appendCapacity = newCapacity;
+    }
+    txn.appends[txn.appendCount].offset = txn.length;
+    txn.appends[txn.appendCount].table = table;
+    txn.appends[txn.appendCount].slot = slot;
+    txn.appendCount++;
+    return 1;
+}
+
+/* Forget the calling thread's transaction entries */
+static void clearTransaction(void) {
+    txn.length = 0;
+    txn.appendCount = 0;
+    txn.unlogged = 0;
+}
+
+/* Open the log for appending if it is not open yet (lock held) */
+static int openLog(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    if (walFile == NULL) {
+        walFile = fopen(WAL_FILE, "ab");
+        if (walFile == NULL) {
+            printf("\nError: Could not open %s for writing.\n", WAL_FILE);
+            return 0;
+        }
+        fseek(walFile, 0, SEEK_END);
+        walWritten = walDurable = ftell(walFile);
+    }
+#else
+    if (walFd < 0) {
+        walFd = open(WAL_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (walFd < 0) {
+            printf("\nError: Could not open %s for writing.\n", WAL_FILE);
+            return 0;
+        }
+        walWritten = walDurable = (long)lseek(walFd, 0, SEEK_END);
+    }
+#endif
+    return 1;
+}
+
+/* Append bytes to the end of the log (lock held) */
+static int writeLog(const char *data, size_t length) {
+#if defined(_WIN32) || defined(_WIN64)
+    if (fwrite(data, 1, length, walFile) != length || fflush(walFile) != 0) {
+        return 0;
+    }
+#else
+    size_t done = 0;
+
+    while (done < length) {
+        ssize_t n = write(walFd, data + done, length - done);
+        if (n <= 0) {
+            return 0;
+        }
+        done += (size_t)n;
+    }
+#endif
+    walWritten += (long)length;
+    return 1;
+}
+
+/* Wait until the log is on disk up to the given offset (lock held) */
+static int syncLog(long end) {
+#if defined(_WIN32) || defined(_WIN64)
+    if (_commit(_fileno(walFile)) != 0) {
+        return 0;
+    }
+    walDurable = walWritten;
+#else
+    long generation = walGeneration;
+
+    while (generation == walGeneration && walDurable < end) {
+        if (walSyncing) {
+            /* A leader is syncing; its fsync may already cover us */
+            pthread_cond_wait(&walSynced, &walMutex);
+        } else {
+            long target = walWritten;
+            int ok;
+
+            walSyncing = 1;
+            WAL_UNLOCK();
+            ok = fsync(walFd) == 0;
+            WAL_LOCK();
+            walSyncing = 0;
+            if (ok && walDurable < target) {
+                walDurable = target;
+            }
+            pthread_cond_broadcast(&walSynced);
+            if (!ok) {
+                return 0;
+            }
+        }
+    }
+#endif
+    return 1;
+}
+
+/* Wait for a running fsync of the log to finish (lock held) */
+static void waitForSync(void) {
+#if !defined(_WIN32) && !defined(_WIN64)
+    while (walSyncing) {
+        pthread_cond_wait(&walSynced, &walMutex);
+    }
+#endif
+}
+
+/* Sync everything written to the log without giving up the lock (lock held) */
+static int syncLogNow(void) {
+    waitForSync();
+#if defined(_WIN32) || defined(_WIN64)
+    if (_commit(_fileno(walFile)) != 0) {
+        return 0;
+    }
+#else
+    if (fsync(walFd) != 0) {
+        return 0;
+    }
+#endif
+    walDurable = walWritten;
+    return 1;
+}
+
+/* Check whether another terminal has changed the log since this one last wrote it (lock held) */
+static int logForeign(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    return 0;
+#else
+    return lseek(walFd, 0, SEEK_END) != (off_t)walWritten;
+#endif
+}
+
+/* Empty the log (lock held) */
+static int truncateLog(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    if (walFile != NULL) {
+        fclose(walFile);
+    }
+    walFile = fopen(WAL_FILE, "wb");
+    if (walFile == NULL) {
+        printf("\nError: Could not truncate %s.\n", WAL_FILE);
+        return 0;
+    }
+#else
+    if (!openLog()) {
+        return 0;
+    }
+    if (ftruncate(walFd, 0) != 0 || fsync(walFd) != 0) {
+        printf("\nError: Could not truncate %s.\n", WAL_FILE);
+        return 0;
+    }
+#endif
+    walWritten = walDurable = 0;
+    walGeneration++;
+    noteLogTruncated();
+    return 1;
+}
+
+/* Read the whole log into memory; *log is NULL if it is missing or empty */
+static int readLog(char **log, long *size) {
+    FILE *fp;
+
+    *log = NULL;
+    *size = 0;
+    fp = fopen(WAL_FILE, "rb");
+    if (fp == NULL) {
+        return 1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (*size == 0) {
+        fclose(fp);
+        return 1;
+    }
+
+    *log = malloc((size_t)*size);
+    if (*log == NULL || fread(*log, 1, (size_t)*size, fp) != (size_t)*size) {
+        printf("\nError: Could not read %s.\n", WAL_FILE);
+        free(*log);
+        *log = NULL;
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    return 1;
+}
+
+/* Write the committed transactions in the log to their slots in the data files */
+static int replayLog(int *touched, int *recovered, long *size) {
+    char *log;
+    long pos = 0, txnStart = 0;
+
+    if (!readLog(&log, size)) {
+        return 0;
+    }
+    if (log == NULL) {
+        return 1; /* No log, nothing to replay */
+    }
+
+    /* Walk intact entries; apply each transaction when its commit is reached */
+    while (pos + (long)sizeof(WalEntry) <= *size) {
+        WalEntry entry;
+        const char *data = log + pos + sizeof(WalEntry);
+
+        memcpy(&entry, log + pos, sizeof(entry));
+        if (entry.length < 0 || pos + (long)sizeof(WalEntry) + entry.length > *size ||
+            entry.checksum != entryChecksum(&entry, data)) {
+            break; /* Torn write at the end of the log */
+        }
+
+        if (entry.type == WAL_ENTRY_COMMIT) {
+            long p = txnStart;
+            while (p < pos) {
+                WalEntry change;
+                Table *table;
+
+                memcpy(&change, log + p, sizeof(change));
+                if (change.table < 0 || change.table >= TABLE_COUNT) {
+                    printf("\nError: %s refers to an unknown table.\n", WAL_FILE);
+                    free(log);
+                    return 0;
+                }
+                table = getTable((TableId)change.table);
+                if ((size_t)change.length != table->recordSize) {
+                    printf("\nError: %s was written with a different record layout for %s; not replaying it.\n",
+                           WAL_FILE, table->path);
+                    free(log);
+                    return 0;
+                }
+                if (!tableWriteLogged(table, change.slot, log + p + sizeof(WalEntry))) {
+                    printf("\nError: %s does not match %s; not replaying it.\n", WAL_FILE, table->path);
+                    free(log);
+                    return 0;
+                }
+                touched[change.table] = 1;
+                p += (long)sizeof(WalEntry) + change.length;
+            }
+            (*recovered)++;
+            txnStart = pos + (long)sizeof(WalEntry);
+        } else if (entry.type != WAL_ENTRY_RECORD) {
+            break;
+        }
+        pos += (long)sizeof(WalEntry) + entry.length;
+    }
+    free(log);
+
+    if (txnStart < *size) {
+        printf("\nDiscarded %ld byte(s) of uncommitted changes from %s.\n", *size - txnStart, WAL_FILE);
+    }
+    return 1;
+}
+
+/* Copy the log's committed transactions into the data files and empty it (lock held) */
+static int applyLog(int current, int *touched, int *recovered) {
+    long size;
+
+    waitForSync();
+    if (!replayLog(touched, recovered, &size)) {
+        return 0;
+    }
+    if (size == 0) {
+        return 1;
+    }
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        if (touched[i] && !tableSync(getTable((TableId)i), current)) {
+            return 0;
+        }
+    }
+    /* Everything logged is in the data files now */
+    tableMarkAllClean();
+    return truncateLog();
+}
+
+/* Write all tables and empty the log (lock held) */
+static int checkpointLocked(void) {
+    int touched[TABLE_COUNT] = {0};
+    int recovered = 0;
+    int ok;
+
+    if (!lockLog()) {
+        return 0;
+    }
+    ok = openLog();
+    if (ok && (logForeign() || logShared())) {
+        /* Other terminals read the data files: copy exactly what was logged */
+        ok = applyLog(!logForeign(), touched, &recovered);
+    } else if (ok) {
+        /* The log must not be truncated under a running fsync */
+        waitForSync();
+        ok = tableFlushAll() && truncateLog();
+    }
+    unlockLog();
+    return ok;
+}
+
+/* Write the calling thread's transaction to the log and wait for it */
+static int commitTransaction(void) {
+    int touched[TABLE_COUNT] = {0};
+    int recovered = 0;
+    long end;
+    int ok, shared;
+
+    if (txn.length == 0) {
+        return 1;
+    }
+    if (serverConnected()) {
+        /* The server logs the entries and applies them to its tables */
+        ok = serverCommit(txn.data, txn.length);
+        clearTransaction();
+        return ok;
+    }
+    if (!bufferEntry(WAL_ENTRY_COMMIT, -1, -1, NULL, 0)) {
+        clearTransaction();
+        return 0;
+    }
+
+    WAL_LOCK();
+    ok = lockLog() && openLog();
+    if (ok && logForeign()) {
+        /* Entries another terminal left behind go to the data files first */
+        ok = applyLog(0, touched, &recovered);
+    }
+    shared = ok && logShared();
+    ok = ok && writeLog(txn.data, txn.length);
+    clearTransaction();
+    end = walWritten;
+    if (ok && shared) {
+        /* Other terminals read the data files, so write the change through */
+        ok = syncLogNow() && applyLog(1, touched, &recovered);
+        unlockLog();
+    } else {
+        unlockLog();
+        if (ok) {
+            ok = syncLog(end);
+        }
+    }
+    if (!ok) {
+        printf("\nError: Could not write to %s.\n", WAL_FILE);
+    } else if (!manualCheckpoints && walWritten >= WAL_CHECKPOINT_SIZE) {
+        checkpointLocked();
+    }
+    WAL_UNLOCK();
+    return ok;
+}
+
+/* Find the last contents a transaction's entries give a slot, before an offset */
+static const char *findBuffered(size_t end, int table, int slot) {
+    const char *found = NULL;
+    size_t pos = 0;
+
+    while (pos < end) {
+        WalEntry entry;
+
+        memcpy(&entry, txn.data + pos, sizeof(entry));
+        if (entry.table == table && entry.slot == slot) {
+            found = txn.data + pos + sizeof(WalEntry);
+        }
+        pos += sizeof(WalEntry) + (size_t)entry.length;
+    }
+    return found;
+}
+
+/* Find the last committed contents of a slot in a copy of the log */
+static const char *findCommitted(const char *log, long size, int table, int slot) {
+    const char *committed = NULL, *pending = NULL;
+    long pos = 0;
+
+    while (pos + (long)sizeof(WalEntry) <= size) {
+        WalEntry entry;
+        const char *data = log + pos + sizeof(WalEntry);
+
+        memcpy(&entry, log + pos, sizeof(entry));
+        if (entry.length < 0 || pos + (long)sizeof(WalEntry) + entry.length > size ||
+            entry.checksum != entryChecksum(&entry, data)) {
+            break; /* Torn write at the end of the log */
+        }
+        if (entry.type == WAL_ENTRY_COMMIT) {
+            if (pending != NULL) {
+                committed = pending;
+            }
+            pending = NULL;
+        } else if (entry.type != WAL_ENTRY_RECORD) {
+            break;
+        } else if (entry.table == table && entry.slot == slot) {
+            pending = data;
+        }
+        pos += (long)sizeof(WalEntry) + entry.length;
+    }
+    return committed;
+}
+
+/* Put a slot back to its contents at an offset in the transaction */
+static int restoreSlot(size_t mark, int table, int slot, const char *log, long logSize) {
+    const char *record = findBuffered(mark, table, slot);
+
+    if (record == NULL && log != NULL) {
+        record = findCommitted(log, logSize, table, slot);
+    }
+    /* Neither logged: the data file, or the server, has the committed contents */
+    return tableRevert(getTable((TableId)table), slot, record);
+}
+
+/* Undo the changes the calling thread has logged since an offset in its transaction */
+static void rollbackTo(size_t mark) {
+    int touched[TABLE_COUNT] = {0};
+    int firstAppend[TABLE_COUNT];
+    char *log = NULL;
+    long logSize = 0;
+    size_t pos;
+    int ok = 1, logLocked = 0;
+
+    /* Appends come last in their table, so dropping them is a truncation */
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        firstAppend[i] = -1;
+    }
+    while (txn.appendCount > 0 && txn.appends[txn.appendCount - 1].offset >= mark) {
+        const WalAppend *append = &txn.appends[--txn.appendCount];
+        firstAppend[append->table] = append->slot;
+        touched[append->table] = 1;
+    }
+
+    if (!serverConnected()) {
+        WAL_LOCK();
+        logLocked = lockLog();
+        ok = logLocked && readLog(&log, &logSize);
+    }
+    for (pos = mark; pos < txn.length; ) {
+        WalEntry entry;
+
+        memcpy(&entry, txn.data + pos, sizeof(entry));
+        touched[entry.table] = 1;
+        if (firstAppend[entry.table] < 0 || entry.slot < firstAppend[entry.table]) {
+            ok = restoreSlot(mark, entry.table, entry.slot, log, logSize) && ok;
+        }
+        pos += sizeof(WalEntry) + (size_t)entry.length;
+    }
+    /* A change the caller made but could not log */
+    if (txn.unlogged && txn.unloggedOffset >= mark) {
+        touched[txn.unloggedTable] = 1;
+        if (firstAppend[txn.unloggedTable] < 0 || txn.unloggedSlot < firstAppend[txn.unloggedTable]) {
+            ok = restoreSlot(mark, txn.unloggedTable, txn.unloggedSlot, log, logSize) && ok;
+        }
+        txn.unlogged = 0;
+    }
+    txn.length = mark;
+    free(log);
+    if (logLocked) {
+        unlockLog();
+    }
+    if (!serverConnected()) {
+        WAL_UNLOCK();
+    }
+
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        if (firstAppend[i] >= 0 && !tableTruncate(getTable((TableId)i), firstAppend[i])) {
+            ok = 0;
+        }
+        if (touched[i]) {
+            invalidateDerived((TableId)i);
+        }
+    }
+    if (!ok) {
+        printf("\nError: Could not undo the changes of a failed operation.\n");
+    }
+}
+
+/* Start a transaction on the calling thread */
+void walBegin(void) {
+    if (txn.depth < WAL_MAX_DEPTH) {
+        txn.marks[txn.depth] = txn.length;
+    }
+    txn.depth++;
+}
+
+/* Commit the calling thread's transaction */
+int walCommit(void) {
+    int ok;
+
+    if (txn.depth > 0) {
+        txn.depth--;
+    }
+    if (txn.depth > 0) {
+        return 1;
+    }
+    ok = commitTransaction();
+    /* The changes are where other terminals can read them */
+    releaseLocks();
+    return ok;
+}
+
+/* Abandon the calling thread's transaction, or its part since the matching walBegin */
+void walAbort(void) {
+    if (txn.depth == 0) {
+        return;
+    }
+    txn.depth--;
+    /* Past WAL_MAX_DEPTH the innermost tracked level is undone */
+    rollbackTo(txn.marks[txn.depth < WAL_MAX_DEPTH ? txn.depth : WAL_MAX_DEPTH - 1]);
+    if (txn.depth == 0) {
+        clearTransaction();
+        releaseLocks();
+    }
+}
+
+/* Check whether the calling thread has a transaction open */
+int walInTransaction(void) {
+    return txn.depth > 0;
+}
+
+/* Log the new contents of a table record */
+int walLogRecord(TableId table, int slot, const void *record, size_t size) {
+    int ok;
+
+    /* Inside a transaction, note appends so walAbort can drop them */
+    if ((txn.depth > 0 && slot == getTable(table)->count && !bufferAppend((int)table, slot)) ||
+        !bufferEntry(WAL_ENTRY_RECORD, (int)table, slot, record, size)) {
+        if (txn.depth == 0) {
+            releaseLocks();
+        } else if (!txn.unlogged) {
+            /* The caller changed the cached record; walAbort must still put it back */
+            txn.unlogged = 1;
+            txn.unloggedTable = (int)table;
+            txn.unloggedSlot = slot;
+            txn.unloggedOffset = txn.length;
+        }
+        return 0;
+    }
+    /* Outside a transaction every change commits on its own */
+    if (txn.depth == 0) {
+        ok = commitTransaction();
+        releaseLocks();
+        return ok;
+    }
+    return 1;
+}
+
+/* Write all logged changes into the data files and empty the log */
+int walCheckpoint(void) {
+    int ok;
+
+    /* Data files must never hold half of an open transaction */
+    if (txn.depth > 0) {
+        return 1;
+    }
+    if (serverConnected()) {
+        char *payload;
+        return serverCall(SERVER_OP_CHECKPOINT, 0, 0, 0, NULL, 0, &payload) >= 0;
+    }
+
+    WAL_LOCK();
+    ok = checkpointLocked();
+    WAL_UNLOCK();
+    return ok;
+}
+
+/* Replay committed transactions left in the log */
+int walRecover(void) {
+    int touched[TABLE_COUNT] = {0};
+    int recovered = 0;
+    int ok;
+
+    WAL_LOCK();
+    ok = lockLog() && applyLog(0, touched, &recovered);
+    unlockLog();
+    WAL_UNLOCK();
+    if (!ok) {
+        return 0;
+    }
+
+    /* Reload replayed tables so their indexes match the data files */
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        if (touched[i] && !loadTable((TableId)i)) {
+            return 0;
+        }
+    }
+
+    if (recovered > 0) {
+        printf("\nRecovered %d transaction(s) from %s.\n", recovered, WAL_FILE);
+    }
+    return 1;
+}
+
+/* Check a transaction's entries and find the tables it changes */
+int walCheckTransaction(const char *data, size_t length, int *touched) {
+    size_t pos = 0;
+
+    while (pos < length) {
+        WalEntry entry;
+
+        if (length - pos < sizeof(WalEntry)) {
+            return 0;
+        }
+        memcpy(&entry, data + pos, sizeof(entry));
+        if (entry.type != WAL_ENTRY_RECORD || entry.table < 0 || entry.table >= TABLE_COUNT ||
+            entry.length < 0 || (size_t)entry.length > length - pos - sizeof(WalEntry) ||
+            (size_t)entry.length != getTable((TableId)entry.table)->recordSize ||
+            entry.checksum != entryChecksum(&entry, data + pos + sizeof(WalEntry))) {
+            return 0;
+        }
+        touched[entry.table] = 1;
+        pos += sizeof(WalEntry) + (size_t)entry.length;
+    }
+    return 1;
+}
+
+/* Apply and commit a transaction logged by a client */
+int walApply(const char *data, size_t length) {
+    int counts[TABLE_COUNT];
+    size_t pos;
+    int ok = 1;
+
+    /* Appends must follow on from the table as it is now */
+    for (int i = 0; i < TABLE_COUNT; i++) {
+        counts[i] = getTable((TableId)i)->count;
+    }
+    for (pos = 0; pos < length; ) {
+        WalEntry entry;
+
+        memcpy(&entry, data + pos, sizeof(entry));
+        if (entry.slot < 0 || entry.slot > counts[entry.table]) {
+            return 0;
+        }
+        if (entry.slot == counts[entry.table]) {
+            counts[entry.table]++;
+        }
+        pos += sizeof(WalEntry) + (size_t)entry.length;
+    }
+
+    walBegin();
+    for (pos = 0; ok && pos < length; ) {
+        WalEntry entry;
+
+        memcpy(&entry, data + pos, sizeof(entry));
+        ok = tableStore(getTable((TableId)entry.table), entry.slot, data + pos + sizeof(WalEntry));
+        pos += sizeof(WalEntry) + (size_t)entry.length;
+    }
+    if (!ok) {
+        walAbort();
+        return 0;
+    }
+    return walCommit();
+}
+
+/* Stop commits from starting checkpoints */
+void walManualCheckpoints(void) {
+    manualCheckpoints = 1;
+}
+
+/* Check whether the log has grown past WAL_CHECKPOINT_SIZE */
+int walCheckpointDue(void) {
+    int due;
+
+    WAL_LOCK();
+    due = walWritten >= WAL_CHECKPOINT_SIZE;
+    WAL_UNLOCK();
+    return due;
+}
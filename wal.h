@@ -0,0 +1,131 @@
+/**
+ * Hotel Management System
+ * wal.h - Write-ahead log header
+ *
+ * This file contains declarations for the write-ahead log. Every record
+ * the table cache changes is first appended to WAL_FILE and made durable
+ * there; the data files themselves are only brought up to date at a
+ * checkpoint. Changes made between walBegin and walCommit reach the log
+ * together, so after a crash either all of them or none are replayed.
+ * walAbort abandons them instead and puts the cached records back.
+ *
+ * In a client of a server (see server.h) a commit sends the entries to
+ * the server instead, which applies them with walApply and logs them.
+ */
+
+#ifndef WAL_H
+#define WAL_H
+
+#include <stddef.h>
+#include "table.h"
+
+/* File paths */
+#define WAL_FILE "data/wal.log"
+
+/* Log size after which a commit triggers a checkpoint */
+#define WAL_CHECKPOINT_SIZE (1024 * 1024)
+
+/**
+ * Start a transaction on the calling thread
+ *
+ * Transactions nest; only the outermost walCommit writes the log.
+ * Changes logged outside a transaction are committed one at a time.
+ */
+void walBegin(void);
+
+/**
+ * Commit the calling thread's transaction
+ *
+ * The transaction's entries are appended to the log in one write and
+ * the call returns once they are on disk. Threads committing at the
+ * same time share a single fsync.
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int walCommit(void);
+
+/**
+ * Abandon the calling thread's transaction
+ *
+ * Ends the innermost walBegin like walCommit, but undoes every change
+ * logged since it: changed records get their earlier contents back in
+ * the table cache and appended records are dropped. The enclosing
+ * transaction, if any, carries on without them. Call this on every
+ * error path between walBegin and walCommit.
+ */
+void walAbort(void);
+
+/**
+ * Check whether the calling thread has a transaction open
+ *
+ * @return 1 inside a transaction, 0 otherwise
+ */
+int walInTransaction(void);
+
+/**
+ * Log the new contents of a table record
+ *
+ * @param table Table the record belongs to
+ * @param slot Slot of the record; equal to the table's count for an append
+ * @param record New record contents
+ * @param size Size of the record in bytes
+ * @return 1 if successful, 0 otherwise
+ */
+int walLogRecord(TableId table, int slot, const void *record, size_t size);
+
+/**
+ * Write all logged changes into the data files and empty the log
+ *
+ * @return 1 if successful, 0 otherwise
+ */
+int walCheckpoint(void);
+
+/**
+ * Replay committed transactions left in the log by an unclean shutdown
+ *
+ * Entries after the last intact commit are discarded. The recovered
+ * changes are checkpointed before returning.
+ *
+ * @return 1 if successful or nothing to do, 0 otherwise
+ */
+int walRecover(void);
+
+/**
+ * Check a transaction's entries and find the tables it changes
+ *
+ * @param data Log entries, without a commit marker
+ * @param length Bytes of log entries
+ * @param touched Array of TABLE_COUNT flags, set for each table changed
+ * @return 1 if the entries are intact, 0 otherwise
+ */
+int walCheckTransaction(const char *data, size_t length, int *touched);
+
+/**
+ * Apply and commit a transaction logged by a client
+ *
+ * The entries must have passed walCheckTransaction, and the tables they
+ * change must not be changed by other threads meanwhile. Nothing is
+ * applied if a slot lies past the end of its table.
+ *
+ * @param data Log entries, without a commit marker
+ * @param length Bytes of log entries
+ * @return 1 if successful, 0 otherwise
+ */
+int walApply(const char *data, size_t length);
+
+/**
+ * Stop commits from starting checkpoints; the caller runs them instead
+ *
+ * A server checkpoints only while it holds every table, since a
+ * checkpoint reads tables other threads may be changing.
+ */
+void walManualCheckpoints(void);
+
+/**
+ * Check whether the log has grown past WAL_CHECKPOINT_SIZE
+ *
+ * @return 1 if a checkpoint is due, 0 otherwise
+ */
+int walCheckpointDue(void);
+
+#endif /* WAL_H */